@@ -0,0 +1,396 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Headless benchmarks for scanning and the list models. Builds synthetic
+// trees in a temporary directory, times Utility::scan(), populating a
+// FileListModel, sorting it, filtering it through a FileFilterModel and
+// scrolling through it, and prints one JSON object per measurement on
+// stdout:
+//
+//   {"benchmark": "scan", "shape": "flat", "entries": 100000,
+//    "seconds": 0.0123, "entries_per_second": 8130081,
+//    "peak_rss_kib": 20480, "allocs_per_entry": 1.02}
+//
+// "seconds" is the best of a few runs over a warm page cache. Peak RSS is
+// reset before each measurement where the kernel allows it. Allocations are
+// operator new calls; GLib's own allocations are not counted.
+//
+// "scroll-bind" walks a window of rows over the whole filtered list, the
+// way a view binding rows as it scrolls asks for them: items are fetched
+// from the filter model and the text of every list view column is made.
+// Widgets, icons and thumbnails need a display and are not part of it.
+//
+// Usage: xafile-bench [--sizes 1000,100000,1000000] [--shapes flat,deep]
+//                     [--dir PARENT] [--keep]
+
+#include "file_filter_model.hpp"
+#include "file_list_model.hpp"
+#include "utility/tree_remover.hpp"
+#include "utility/utilitas.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocations{0};
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+namespace xafile {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Words file names commonly start with; the rest is random
+constexpr const char *kWords[] = {
+    "IMG",    "DSC",   "report", "invoice", "notes",  "draft", "final",
+    "backup", "photo", "track",  "README",  "config", "build", "test",
+    "Screenshot", "document", "archive", "résumé", "data", "index",
+};
+constexpr const char *kExtensions[] = {
+    ".jpg", ".png", ".txt", ".pdf", ".cpp", ".hpp", ".json",
+    ".tar.gz", ".mp3", ".md", "", "",
+};
+// Typed one key at a time, as the filter sees them
+constexpr const char *kQueries[] = {"r", "re", "rep", "repo"};
+
+// Rows bound at once while scrolling, about a screenful of the list view
+constexpr std::size_t kVisibleRows = 64;
+
+struct Tree {
+  std::string root;
+  std::string shape;
+  std::size_t entries = 0;
+  std::vector<std::string> dirs; // every directory, the root first
+};
+
+// Mixed lengths: mostly short names, a few long ones up to 200 bytes
+std::string make_name(std::mt19937 &rng, std::size_t serial) {
+  static const char kChars[] = "abcdefghijklmnopqrstuvwxyz0123456789_- ";
+  // Some dotfiles, for showing and hiding hidden rows
+  std::string name = rng() % 20 == 0 ? "." : "";
+  name += kWords[rng() % std::size(kWords)];
+  name += rng() % 2 ? "_" : " ";
+  std::size_t tail = rng() % 100 < 90 ? rng() % 16 : rng() % 180;
+  for (std::size_t i = 0; i < tail; i++)
+    name += kChars[rng() % (sizeof(kChars) - 1)];
+  name += "_" + std::to_string(serial);
+  name += kExtensions[rng() % std::size(kExtensions)];
+  return name;
+}
+
+bool create_file(const std::string &path) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return false;
+  close(fd);
+  return true;
+}
+
+// One directory holding every entry, a tenth of them folders
+bool build_flat(Tree &tree, std::size_t entries, std::mt19937 &rng) {
+  tree.dirs.push_back(tree.root);
+  for (std::size_t i = 0; i < entries; i++) {
+    auto path = tree.root + "/" + make_name(rng, i);
+    if (!(i % 10 == 0 ? mkdir(path.c_str(), 0755) == 0 : create_file(path)))
+      return false;
+  }
+  tree.entries = entries;
+  return true;
+}
+
+// Breadth first, eight files and three folders per directory, so a
+// million entries end up about ten levels deep
+bool build_deep(Tree &tree, std::size_t entries, std::mt19937 &rng) {
+  std::deque<std::string> pending{tree.root};
+  std::size_t made = 0;
+  while (made < entries && !pending.empty()) {
+    auto dir = std::move(pending.front());
+    pending.pop_front();
+    tree.dirs.push_back(dir);
+    for (int i = 0; i < 11 && made < entries; i++, made++) {
+      auto path = dir + "/" + make_name(rng, made);
+      if (i >= 8) {
+        if (mkdir(path.c_str(), 0755) != 0)
+          return false;
+        pending.push_back(std::move(path));
+      } else if (!create_file(path)) {
+        return false;
+      }
+    }
+  }
+  // Folders that were made but never filled are scanned too
+  for (auto &dir : pending)
+    tree.dirs.push_back(std::move(dir));
+  tree.entries = made;
+  return true;
+}
+
+void reset_peak_rss() {
+  // Supported since Linux 4.0; without it the peak covers the whole run
+  std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+std::uint64_t peak_rss_kib() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+    if (line.starts_with("VmHWM:"))
+      return std::strtoull(line.c_str() + 6, nullptr, 10);
+  return 0;
+}
+
+// Runs `setup` untimed and `body` timed `runs` times and prints the best
+struct Measurement {
+  const char *benchmark;
+  const Tree &tree;
+  int runs;
+};
+
+void measure(const Measurement &m, const std::function<void()> &setup,
+             const std::function<void()> &body) {
+  double best = 0;
+  std::uint64_t allocations = 0;
+  reset_peak_rss();
+  for (int run = 0; run < m.runs; run++) {
+    setup();
+    auto before = g_allocations.load();
+    auto start = Clock::now();
+    body();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    allocations += g_allocations.load() - before;
+    if (run == 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+
+  auto entries = static_cast<double>(std::max<std::size_t>(m.tree.entries, 1));
+  std::printf("{\"benchmark\": \"%s\", \"shape\": \"%s\", \"entries\": %zu, "
+              "\"seconds\": %.6f, \"entries_per_second\": %.0f, "
+              "\"peak_rss_kib\": %llu, \"allocs_per_entry\": %.3f}\n",
+              m.benchmark, m.tree.shape.c_str(), m.tree.entries, best,
+              best > 0 ? entries / best : 0.0,
+              static_cast<unsigned long long>(peak_rss_kib()),
+              allocations / (entries * m.runs));
+  std::fflush(stdout);
+}
+
+void run_benchmarks(const Tree &tree) {
+  int runs = tree.entries <= 1000 ? 20 : tree.entries <= 100000 ? 5 : 2;
+  Utility utility;
+
+  // Warms the dentry and inode caches
+  for (const auto &dir : tree.dirs)
+    utility.scan(dir);
+
+  std::vector<Listing> listings;
+  measure({"scan", tree, runs}, [&] { listings.clear(); },
+          [&] {
+            for (const auto &dir : tree.dirs)
+              listings.push_back(utility.scan(dir));
+          });
+  // The models show one directory at a time
+  if (tree.shape != "flat")
+    return;
+  const auto &listing = listings.front();
+
+  auto *model = file_list_model_new();
+  measure({"populate", tree, runs}, [&] { file_list_model_clear(model); },
+          [&] { file_list_model_append(model, listing, 0, listing.size()); });
+
+  measure({"sort-name-descending", tree, runs},
+          [&] { file_list_model_set_sort(model, SortOrder()); },
+          [&] {
+            file_list_model_set_sort(model, {SortField::Name, true});
+          });
+  measure({"sort-type", tree, runs},
+          [&] { file_list_model_set_sort(model, SortOrder()); },
+          [&] { file_list_model_set_sort(model, {SortField::Type, false}); });
+  file_list_model_set_sort(model, SortOrder());
+
+  auto *filter = file_filter_model_new(model);
+  measure({"filter-typing", tree, runs},
+          [&] { file_filter_model_set_query(filter, ""); },
+          [&] {
+            for (const char *query : kQueries)
+              file_filter_model_set_query(filter, query);
+          });
+  measure({"show-hidden", tree, runs},
+          [&] { file_filter_model_set_show_hidden(filter, false); },
+          [&] { file_filter_model_set_show_hidden(filter, true); });
+  file_filter_model_set_query(filter, "");
+
+  // Rows are bound once their sizes and dates are in
+  std::vector<MetadataResult> results;
+  auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+  for (std::uint32_t i = 0; i < listing.size(); i++)
+    results.push_back({i, std::uint64_t(i) * 4099, now - std::int64_t(i) * 600,
+                       {atoms::kNone, atoms::kNone, atoms::kNone}});
+  file_list_model_update_metadata(model, results);
+  file_list_model_sort(model);
+
+  auto *rows = G_LIST_MODEL(filter);
+  std::deque<FileItemObject *> bound;
+  measure({"scroll-bind", tree, runs}, [] {},
+          [&] {
+            std::size_t text_bytes = 0;
+            guint n = g_list_model_get_n_items(rows);
+            for (guint position = 0; position < n; position++) {
+              auto *item = FILE_ITEM(g_list_model_get_item(rows, position));
+              text_bytes += std::strlen(file_item_get_name(item));
+              text_bytes += std::strlen(file_item_get_icon_name(item));
+              text_bytes += std::strlen(file_item_get_file_type(item));
+              for (char *text : {file_item_format_size(item),
+                                 file_item_format_modified(item)}) {
+                text_bytes += std::strlen(text);
+                g_free(text);
+              }
+              // Rows scrolled out of view are unbound and let go
+              bound.push_back(item);
+              if (bound.size() > kVisibleRows) {
+                g_object_unref(bound.front());
+                bound.pop_front();
+              }
+            }
+            for (auto *item : bound)
+              g_object_unref(item);
+            bound.clear();
+            if (text_bytes == 0)
+              std::abort();
+          });
+  g_object_unref(filter);
+  g_object_unref(model);
+}
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+void remove_tree(const std::string &root) {
+  std::atomic<bool> cancelled{false};
+  TreeRemover(
+      cancelled, [](std::uint64_t) {}, [](std::uint64_t) {},
+      [](const std::string &path, int error) {
+        std::cerr << path << ": " << std::strerror(error) << '\n';
+      })
+      .remove({root});
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main(int argc, char **argv) {
+  using namespace xafile;
+
+  std::vector<std::size_t> sizes{1000, 100000, 1000000};
+  std::vector<std::string> shapes{"flat", "deep"};
+  std::string parent = g_get_tmp_dir();
+  bool keep = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--sizes" && i + 1 < argc) {
+      sizes.clear();
+      for (const auto &size : split(argv[++i]))
+        sizes.push_back(std::stoull(size));
+    } else if (arg == "--shapes" && i + 1 < argc) {
+      shapes = split(argv[++i]);
+    } else if (arg == "--dir" && i + 1 < argc) {
+      parent = argv[++i];
+    } else if (arg == "--keep") {
+      keep = true;
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--sizes N,...] [--shapes flat,deep] [--dir PARENT]"
+                   " [--keep]\n";
+      return 2;
+    }
+  }
+
+  int status = 0;
+  for (const auto &shape : shapes) {
+    for (auto size : sizes) {
+      Tree tree;
+      tree.shape = shape;
+      std::string pattern = parent + "/xafile-bench-XXXXXX";
+      if (!mkdtemp(pattern.data())) {
+        std::perror(pattern.c_str());
+        return 1;
+      }
+      tree.root = pattern;
+
+      // Same names every run, so results compare across builds
+      std::mt19937 rng(size);
+      auto start = Clock::now();
+      bool built = shape == "deep" ? build_deep(tree, size, rng)
+                                   : build_flat(tree, size, rng);
+      std::chrono::duration<double> elapsed = Clock::now() - start;
+      if (!built) {
+        std::perror(tree.root.c_str());
+        status = 1;
+      } else {
+        std::cerr << "built " << shape << " tree of " << tree.entries
+                  << " entries in " << elapsed.count() << " s\n";
+        run_benchmarks(tree);
+      }
+
+      if (keep)
+        std::cerr << "kept " << tree.root << '\n';
+      else
+        remove_tree(tree.root);
+    }
+  }
+  return status;
+}
@@ -17,6 +17,10 @@
  */
 
 #include "application.hpp"
+#include "file_index.hpp"
+#include "utility/listing_snapshot.hpp"
+#include "utility/startup_timer.hpp"
+#include "utility/trace.hpp"
 #include "window.hpp"
 
 namespace xafile {
@@ -26,6 +30,16 @@ Application::Application() {
     
     g_signal_connect(app_, "activate", G_CALLBACK(on_activate), this);
     g_signal_connect(app_, "startup", G_CALLBACK(on_startup), this);
+
+    g_application_add_main_option(
+        G_APPLICATION(app_), "trace", 0, G_OPTION_FLAG_NONE,
+        G_OPTION_ARG_FILENAME,
+        "Write a trace for ui.perfetto.dev to FILE on exit", "FILE");
+    g_application_add_main_option(
+        G_APPLICATION(app_), "startup-timings", 0, G_OPTION_FLAG_NONE,
+        G_OPTION_ARG_NONE, "Print how long startup took on stderr", nullptr);
+    g_signal_connect(app_, "handle-local-options",
+                     G_CALLBACK(on_handle_local_options), this);
 }
 
 Application* Application::create() {
@@ -33,21 +47,70 @@ Application* Application::create() {
 }
 
 int Application::run(int argc, char* argv[]) {
+    StartupTimer::start_from_environment();
+    Trace::start_from_environment();
     int status = g_application_run(G_APPLICATION(app_), argc, argv);
     g_object_unref(app_);
+    ListingSnapshot::instance().write();
+    Trace::write();
     return status;
 }
 
+int Application::on_handle_local_options(GApplication* app,
+                                         GVariantDict* options,
+                                         gpointer user_data) {
+    (void)app;
+    (void)user_data;
+    char* path = nullptr;
+    if (g_variant_dict_lookup(options, "trace", "^ay", &path)) {
+        Trace::start(path);
+        g_free(path);
+    }
+    if (g_variant_dict_contains(options, "startup-timings"))
+        StartupTimer::start();
+    // Carry on starting up
+    return -1;
+}
+
 void Application::on_startup(GtkApplication* app, gpointer user_data) {
     (void)app;
     (void)user_data;
+    // Opening and checking the index waits until the window is up
+    g_idle_add_full(
+        G_PRIORITY_LOW,
+        +[](gpointer) -> gboolean {
+            FileIndex::instance().start();
+            return G_SOURCE_REMOVE;
+        },
+        nullptr, nullptr);
 }
 
 void Application::on_activate(GtkApplication* app, gpointer user_data) {
     (void)user_data;
     
+    StartupTimer::mark("activate");
     auto* window = Window::create(GTK_APPLICATION(app));
-    gtk_window_present(GTK_WINDOW(window->get_widget()));
+    auto* widget = window->get_widget();
+    if (StartupTimer::enabled())
+        g_signal_connect(widget, "map", G_CALLBACK(on_first_map), nullptr);
+    gtk_window_present(GTK_WINDOW(widget));
+    StartupTimer::mark("window-presented");
+}
+
+void Application::on_first_map(GtkWidget* widget, gpointer user_data) {
+    (void)user_data;
+    StartupTimer::mark("window-mapped");
+    g_signal_handlers_disconnect_by_func(widget, (gpointer)on_first_map,
+                                         nullptr);
+    g_signal_connect(gtk_widget_get_frame_clock(widget), "after-paint",
+                     G_CALLBACK(on_first_paint), nullptr);
+}
+
+void Application::on_first_paint(GdkFrameClock* clock, gpointer user_data) {
+    (void)user_data;
+    StartupTimer::mark("first-frame");
+    g_signal_handlers_disconnect_by_func(clock, (gpointer)on_first_paint,
+                                         nullptr);
 }
 
 }
@@ -33,6 +33,11 @@ private:
     
     static void on_activate(GtkApplication* app, gpointer user_data);
     static void on_startup(GtkApplication* app, gpointer user_data);
+    static void on_first_map(GtkWidget* widget, gpointer user_data);
+    static void on_first_paint(GdkFrameClock* clock, gpointer user_data);
+    static int on_handle_local_options(GApplication* app,
+                                       GVariantDict* options,
+                                       gpointer user_data);
     
     AdwApplication* app_;
 };
@@ -0,0 +1,212 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "content_types.hpp"
+#include <fcntl.h>
+#include <gio/gio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace xafile {
+
+namespace {
+
+constexpr std::size_t kSniffBytes = 4096;
+constexpr std::size_t kMaxSniffed = 1 << 16;
+constexpr std::size_t kMaxExtension = 15;
+
+// The extensions seen most often, checked before shared-mime-info. Lower
+// case, without the dot. Ambiguous ones (.ts, .m) are left to the globs.
+constexpr std::pair<std::string_view, const char *> kExtensionTable[] = {
+    {"txt", "text/plain"},
+    {"md", "text/markdown"},
+    {"log", "text/x-log"},
+    {"csv", "text/csv"},
+    {"c", "text/x-csrc"},
+    {"h", "text/x-chdr"},
+    {"cc", "text/x-c++src"},
+    {"cpp", "text/x-c++src"},
+    {"cxx", "text/x-c++src"},
+    {"hh", "text/x-c++hdr"},
+    {"hpp", "text/x-c++hdr"},
+    {"py", "text/x-python3"},
+    {"rs", "text/rust"},
+    {"go", "text/x-go"},
+    {"java", "text/x-java"},
+    {"js", "text/javascript"},
+    {"css", "text/css"},
+    {"html", "text/html"},
+    {"htm", "text/html"},
+    {"json", "application/json"},
+    {"xml", "application/xml"},
+    {"yaml", "application/yaml"},
+    {"yml", "application/yaml"},
+    {"toml", "application/toml"},
+    {"sh", "application/x-shellscript"},
+    {"o", "application/x-object"},
+    {"a", "application/x-archive"},
+    {"so", "application/x-sharedlib"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"jpeg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"webp", "image/webp"},
+    {"svg", "image/svg+xml"},
+    {"bmp", "image/bmp"},
+    {"tif", "image/tiff"},
+    {"tiff", "image/tiff"},
+    {"mp3", "audio/mpeg"},
+    {"flac", "audio/flac"},
+    {"wav", "audio/x-wav"},
+    {"mp4", "video/mp4"},
+    {"mkv", "video/x-matroska"},
+    {"webm", "video/webm"},
+    {"mov", "video/quicktime"},
+    {"avi", "video/x-msvideo"},
+    {"pdf", "application/pdf"},
+    {"zip", "application/zip"},
+    {"gz", "application/gzip"},
+    {"xz", "application/x-xz"},
+    {"zst", "application/zstd"},
+    {"tar", "application/x-tar"},
+    {"7z", "application/x-7z-compressed"},
+    {"iso", "application/x-cd-image"},
+    {"deb", "application/vnd.debian.binary-package"},
+    {"rpm", "application/x-rpm"},
+    {"odt", "application/vnd.oasis.opendocument.text"},
+    {"ods", "application/vnd.oasis.opendocument.spreadsheet"},
+    {"docx", "application/"
+             "vnd.openxmlformats-officedocument.wordprocessingml.document"},
+    {"xlsx",
+     "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet"},
+    {"ttf", "font/ttf"},
+    {"otf", "font/otf"},
+    {"woff2", "font/woff2"},
+};
+
+} // namespace
+
+ContentTypeDetector::ContentTypeDetector() {
+  for (const auto &[ext, type] : kExtensionTable)
+    extensions_.emplace(ext, type);
+}
+
+ContentTypeDetector &ContentTypeDetector::instance() {
+  static ContentTypeDetector detector;
+  return detector;
+}
+
+ContentType ContentTypeDetector::resolve(const std::string &content_type) {
+  std::lock_guard lock(mutex_);
+  if (auto it = types_.find(content_type); it != types_.end())
+    return it->second;
+
+  char *description = g_content_type_get_description(content_type.c_str());
+  char *icon = g_content_type_get_generic_icon_name(content_type.c_str());
+  ContentType result{atom_intern(content_type), atom_intern(description),
+                     icon ? atom_intern(icon) : atoms::kFileIcon};
+  g_free(description);
+  g_free(icon);
+
+  types_.emplace(content_type, result);
+  return result;
+}
+
+std::optional<ContentType>
+ContentTypeDetector::from_name(std::string_view name) {
+  auto dot = name.rfind('.');
+  if (dot != std::string_view::npos && dot > 0 &&
+      name.size() - dot - 1 <= kMaxExtension) {
+    char ext[kMaxExtension + 1];
+    std::size_t len = name.size() - dot - 1;
+    for (std::size_t i = 0; i < len; i++)
+      ext[i] = g_ascii_tolower(name[dot + 1 + i]);
+    if (auto it = extensions_.find({ext, len}); it != extensions_.end()) {
+      by_extension_.fetch_add(1, std::memory_order_relaxed);
+      return resolve(it->second);
+    }
+  }
+
+  std::string filename(name);
+  gboolean uncertain = FALSE;
+  char *guess = g_content_type_guess(filename.c_str(), nullptr, 0, &uncertain);
+  std::optional<ContentType> result;
+  if (!uncertain) {
+    by_glob_.fetch_add(1, std::memory_order_relaxed);
+    result = resolve(guess);
+  }
+  g_free(guess);
+  return result;
+}
+
+ContentType ContentTypeDetector::detect(int dir_fd, const char *name,
+                                        std::uint64_t device,
+                                        std::uint64_t inode,
+                                        std::int64_t mtime_sec,
+                                        std::uint32_t mtime_nsec,
+                                        std::uint64_t size) {
+  if (auto by_name = from_name(name))
+    return *by_name;
+
+  FileKey key{device, inode, mtime_sec, mtime_nsec};
+  {
+    std::lock_guard lock(mutex_);
+    if (auto it = sniffed_.find(key); it != sniffed_.end()) {
+      by_cache_.fetch_add(1, std::memory_order_relaxed);
+      return it->second;
+    }
+  }
+
+  guchar head[kSniffBytes];
+  gssize length = 0;
+  if (size > 0) {
+    // The entry may have been swapped for a FIFO or device since it was
+    // looked at; opening one must not block and reading it could hang
+    int fd = openat(dir_fd, name,
+                    O_RDONLY | O_CLOEXEC | O_NOCTTY | O_NONBLOCK);
+    if (fd >= 0) {
+      struct stat st;
+      if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        length = read(fd, head, sizeof(head));
+      close(fd);
+    }
+    if (length < 0)
+      length = 0;
+  }
+
+  char *guess = g_content_type_guess(name, head, length, nullptr);
+  ContentType result = resolve(guess);
+  g_free(guess);
+  by_sniffing_.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard lock(mutex_);
+  if (sniffed_.size() >= kMaxSniffed)
+    sniffed_.clear();
+  sniffed_.emplace(key, result);
+  return result;
+}
+
+ContentTypeDetector::Stats ContentTypeDetector::stats() const {
+  return {by_extension_.load(std::memory_order_relaxed),
+          by_glob_.load(std::memory_order_relaxed),
+          by_cache_.load(std::memory_order_relaxed),
+          by_sniffing_.load(std::memory_order_relaxed)};
+}
+
+} // namespace xafile
@@ -0,0 +1,91 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "utility/atoms.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace xafile {
+
+struct ContentType {
+  Atom content_type; // MIME type
+  Atom description;
+  Atom icon;
+};
+
+// Works out content types in three tiers: a built-in extension table, the
+// shared-mime-info globs, and finally sniffing the head of the file. Only
+// the last one does I/O, its results are cached by (device, inode, mtime).
+// Thread-safe.
+class ContentTypeDetector {
+public:
+  struct Stats {
+    std::uint64_t extension;
+    std::uint64_t glob;
+    std::uint64_t cached;
+    std::uint64_t sniffed;
+  };
+
+  static ContentTypeDetector &instance();
+
+  // Name based tiers only, never touches the disk
+  std::optional<ContentType> from_name(std::string_view name);
+  // Falls back to reading `name` relative to `dir_fd`
+  ContentType detect(int dir_fd, const char *name, std::uint64_t device,
+                     std::uint64_t inode, std::int64_t mtime_sec,
+                     std::uint32_t mtime_nsec, std::uint64_t size);
+
+  Stats stats() const;
+
+private:
+  struct FileKey {
+    std::uint64_t device, inode;
+    std::int64_t mtime_sec;
+    std::uint32_t mtime_nsec;
+    bool operator==(const FileKey &) const = default;
+  };
+  struct FileKeyHash {
+    std::size_t operator()(const FileKey &k) const {
+      return std::hash<std::uint64_t>()(k.inode * 31 + k.device) ^
+             std::hash<std::int64_t>()(k.mtime_sec * 1000000007 + k.mtime_nsec);
+    }
+  };
+
+  ContentTypeDetector();
+  ContentType resolve(const std::string &content_type);
+
+  std::unordered_map<std::string_view, const char *> extensions_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, ContentType> types_;
+  std::unordered_map<FileKey, ContentType, FileKeyHash> sniffed_;
+
+  std::atomic<std::uint64_t> by_extension_{0};
+  std::atomic<std::uint64_t> by_glob_{0};
+  std::atomic<std::uint64_t> by_cache_{0};
+  std::atomic<std::uint64_t> by_sniffing_{0};
+};
+
+} // namespace xafile
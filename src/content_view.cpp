@@ -17,81 +17,178 @@
  */
 
 #include "content_view.hpp"
+#include "content_types.hpp"
+#include "diagnostics_overlay.hpp"
+#include "dir_watcher.hpp"
+#include "metadata_loader.hpp"
 #include "gio/gio.h"
 #include "glib.h"
 #include "glibconfig.h"
+#include "icon_cache.hpp"
+#include "scan_job.hpp"
+#include "search_job.hpp"
+#include "size_job.hpp"
+#include "stat_job.hpp"
 #include "src/window.hpp"
+#include "thumbnailer.hpp"
+#include "utility/listing_cache.hpp"
+#include "utility/listing_snapshot.hpp"
+#include "utility/startup_timer.hpp"
+#include "utility/trace.hpp"
 #include "utility/utilitas.hpp"
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <fcntl.h>
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace xafile {
 
-#define FILE_ITEM_TYPE (file_item_get_type())
-G_DECLARE_FINAL_TYPE(FileItemObject, file_item, FILE, ITEM, GObject)
-
-struct _FileItemObject {
-  GObject parent_instance;
-  char *name;
-  char *icon_name;
-  char *file_type;
-  char *size;
-  char *modified;
-  gboolean is_directory;
-};
-
-G_DEFINE_TYPE(FileItemObject, file_item, G_TYPE_OBJECT)
-
-static void file_item_finalize(GObject *object) {
-  FileItemObject *self = FILE_ITEM(object);
-  g_free(self->name);
-  g_free(self->icon_name);
-  g_free(self->file_type);
-  g_free(self->size);
-  g_free(self->modified);
-  G_OBJECT_CLASS(file_item_parent_class)->finalize(object);
-}
-static Utility utly{};
-static void file_item_class_init(FileItemObjectClass *klass) {
-  GObjectClass *object_class = G_OBJECT_CLASS(klass);
-  object_class->finalize = file_item_finalize;
-}
-
-static void file_item_init(FileItemObject *self) {
-  self->name = nullptr;
-  self->icon_name = nullptr;
-  self->file_type = nullptr;
-  self->size = nullptr;
-  self->modified = nullptr;
-  self->is_directory = FALSE;
-}
-
-static FileItemObject *file_item_new(const char *name, const char *icon_name,
-                                     const char *file_type, const char *size,
-                                     const char *modified,
-                                     gboolean is_directory) {
-  FileItemObject *item = FILE_ITEM(g_object_new(FILE_ITEM_TYPE, nullptr));
-  item->name = g_strdup(name);
-  item->icon_name = g_strdup(icon_name);
-  item->file_type = g_strdup(file_type);
-  item->size = g_strdup(size);
-  item->modified = g_strdup(modified);
-  item->is_directory = is_directory;
-  return item;
+// Set on grid cells, which need the directory their rows are in
+static constexpr char kViewKey[] = "xafile-content-view";
+
+// Every window's view, so one can wait for another's scan of the same
+// directory instead of listing it a second time
+static std::vector<ContentView *> live_views;
+
+// Batches up to this size are appended to the model in one go. Anything
+// larger is inserted in chunks from an idle source so a single items-changed
+// emission never has to rebuild both views for a huge range.
+static constexpr std::size_t kInsertThreshold = 2048;
+static constexpr std::size_t kInsertChunk = 1024;
+
+static constexpr int kGridIconSize = 64;
+static constexpr int kListIconSize = 16;
+
+// Skips the icon theme lookup GtkImage would do on every bind
+static void set_icon(GtkWidget *image, FileItemObject *item, int size) {
+  auto *paintable =
+      IconCache::instance().lookup(file_item_entry(item).icon, size,
+                                   gtk_widget_get_scale_factor(image));
+  gtk_image_set_from_paintable(GTK_IMAGE(image), paintable);
+}
+
+static std::string item_path(GtkListItem *list_item, FileItemObject *item) {
+  auto *view = static_cast<ContentView *>(
+      g_object_get_data(G_OBJECT(list_item), kViewKey));
+  std::string path = view->current_path();
+  if (path.empty() || path.back() != '/')
+    path += '/';
+  return path + file_item_get_name(item);
+}
+
+static bool has_thumbnail(FileItemObject *item) {
+  const auto &e = file_item_entry(item);
+  return !e.is_directory && e.has_metadata &&
+         Thumbnailer::instance().can_thumbnail(e.content_type);
+}
+
+// Grid cells show a thumbnail once there is one, the themed icon until then
+static void update_grid_cell(GtkListItem *list_item) {
+  TraceSpan span("bind-grid-cell");
+  auto *box = gtk_list_item_get_child(list_item);
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+
+  auto *icon = gtk_widget_get_first_child(box);
+  auto *label = gtk_widget_get_next_sibling(icon);
+
+  GdkTexture *texture = nullptr;
+  if (has_thumbnail(item)) {
+    const auto &e = file_item_entry(item);
+    texture = Thumbnailer::instance().lookup(item_path(list_item, item),
+                                             e.mtime, e.content_type);
+  }
+  if (texture)
+    gtk_image_set_from_paintable(GTK_IMAGE(icon), GDK_PAINTABLE(texture));
+  else
+    set_icon(icon, item, kGridIconSize);
+  gtk_label_set_text(GTK_LABEL(label), file_item_get_name(item));
+}
+
+// Icon and name cell of the name column
+static void update_name_cell(GtkListItem *list_item) {
+  TraceSpan span("bind-name");
+  auto *box = gtk_list_item_get_child(list_item);
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+
+  auto *icon = gtk_widget_get_first_child(box);
+  auto *label = gtk_widget_get_next_sibling(icon);
+
+  set_icon(icon, item, kListIconSize);
+  gtk_label_set_text(GTK_LABEL(label), file_item_get_name(item));
+}
+
+static void update_type_label(GtkListItem *list_item) {
+  TraceSpan span("bind-type");
+  auto *label = gtk_list_item_get_child(list_item);
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+  gtk_label_set_text(GTK_LABEL(label), file_item_get_file_type(item));
+}
+
+static void update_size_label(GtkListItem *list_item) {
+  TraceSpan span("bind-size");
+  auto *label = gtk_list_item_get_child(list_item);
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+  char *size = file_item_format_size(item);
+  gtk_label_set_text(GTK_LABEL(label), size);
+  g_free(size);
+}
+
+static void update_modified_label(GtkListItem *list_item) {
+  TraceSpan span("bind-modified");
+  auto *label = gtk_list_item_get_child(list_item);
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+  char *modified = file_item_format_modified(item);
+  gtk_label_set_text(GTK_LABEL(label), modified);
+  g_free(modified);
+}
+
+// Drops the "changed" handler a bind callback attached to the item
+static void disconnect_item(GtkSignalListItemFactory *, GtkListItem *list_item,
+                            gpointer) {
+  g_signal_handlers_disconnect_by_data(gtk_list_item_get_item(list_item),
+                                       list_item);
+}
+
+// Rows that scroll out of view should not keep a decode queued
+static void unbind_grid_cell(GtkSignalListItemFactory *factory,
+                             GtkListItem *list_item, gpointer user_data) {
+  auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
+  if (has_thumbnail(item))
+    Thumbnailer::instance().withdraw(item_path(list_item, item));
+  disconnect_item(factory, list_item, user_data);
 }
 
 ContentView::ContentView() : is_grid_mode_(true) {
-  content_box_ = GTK_BOX(gtk_box_new(GTK_ORIENTATION_VERTICAL, 0));
-  file_store_ = g_list_store_new(FILE_ITEM_TYPE);
+  live_views.push_back(this);
+  // Held, so the view can be taken down after the window is gone
+  content_box_ =
+      GTK_BOX(g_object_ref_sink(gtk_box_new(GTK_ORIENTATION_VERTICAL, 0)));
+  file_store_ = file_list_model_new();
+  file_list_model_set_item_requested_func(
+      file_store_, [this](std::uint32_t index) {
+        // Rows being bound get their metadata before the rest
+        const auto &listing = file_list_model_get_listing(file_store_);
+        if (metadata_loader_ && !listing[index].has_metadata)
+          metadata_loader_->prioritize(index);
+      });
+  thumbnail_listener_ = Thumbnailer::instance().connect(
+      [this](const std::string &path) { on_thumbnail_ready(path); });
+  icon_listener_ = IconCache::instance().connect(
+      [this] { file_list_model_refresh_all(file_store_); });
+  filter_ = file_filter_model_new(file_store_);
 
   setup_path_bar();
   setup_grid_view();
-  setup_list_view();
-  add_sample_items();
+  begin_trace_navigation();
+  current_path_ = utly_.getCurDir();
 
   view_stack_ = GTK_STACK(gtk_stack_new());
   gtk_stack_set_transition_type(view_stack_,
@@ -104,23 +201,48 @@ ContentView::ContentView() : is_grid_mode_(true) {
                                 GTK_WIDGET(grid_view_));
   gtk_widget_set_vexpand(grid_scroll, TRUE);
 
-  auto *list_scroll = gtk_scrolled_window_new();
-  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(list_scroll),
-                                 GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
-  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(list_scroll),
-                                GTK_WIDGET(list_view_));
-  gtk_widget_set_vexpand(list_scroll, TRUE);
-
+  // The list view is built the first time it is shown
   gtk_stack_add_named(view_stack_, grid_scroll, "grid");
-  gtk_stack_add_named(view_stack_, list_scroll, "list");
   gtk_stack_set_visible_child_name(view_stack_, "grid");
 
-  gtk_box_append(content_box_, GTK_WIDGET(view_stack_));
+  overlay_ = GTK_OVERLAY(gtk_overlay_new());
+  gtk_overlay_set_child(overlay_, GTK_WIDGET(view_stack_));
+  gtk_box_append(content_box_, GTK_WIDGET(overlay_));
+
+  // The window shows up first and the listing is loaded once it has been
+  // painted, empty
+  load_after_first_frame();
 }
 
 ContentView *ContentView::create() { return new ContentView(); }
+
+// Runs once the window is destroyed, when its widgets are already gone;
+// only what is held here is touched
+ContentView::~ContentView() {
+  std::erase(live_views, this);
+  stop_loading();
+  scan_job_.reset();
+  watcher_.reset();
+  diagnostics_.reset();
+  Thumbnailer::instance().disconnect(thumbnail_listener_);
+  IconCache::instance().disconnect(icon_listener_);
+
+  for (auto *source : {&load_source_, &reload_source_})
+    if (*source != 0)
+      g_source_remove(*source);
+  stop_watching_paint();
+  if (load_clock_) {
+    g_signal_handler_disconnect(load_clock_, load_handler_);
+    g_clear_object(&load_clock_);
+  }
+  g_signal_handlers_disconnect_by_data(content_box_, this);
+
+  file_list_model_set_item_requested_func(file_store_, nullptr);
+  g_object_unref(file_store_);
+  g_object_unref(content_box_);
+}
 void ContentView::setup_path_bar() {
-  const auto result = utly.getParsedCurDir();
+  const auto result = utly_.getParsedCurDir();
   path_bar_ = GTK_BOX(gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0));
   gtk_widget_add_css_class(GTK_WIDGET(path_bar_), "linked");
   gtk_widget_set_margin_start(GTK_WIDGET(path_bar_), 12);
@@ -144,6 +266,7 @@ void ContentView::setup_path_bar() {
 }
 
 void ContentView::refresh_path_bar() {
+  TraceSpan span("refresh-path-bar");
   GtkWidget *child = gtk_widget_get_first_child(GTK_WIDGET(path_bar_));
   while (child != nullptr) {
     GtkWidget *next = gtk_widget_get_next_sibling(child);
@@ -151,7 +274,7 @@ void ContentView::refresh_path_bar() {
     child = next;
   }
 
-  const auto result = utly.getParsedCurDir();
+  const auto result = utly_.getParsedCurDir();
   for (size_t i = 0; i < result.size(); i++) {
     if (i > 0) {
       auto *arrowRight = gtk_image_new_from_icon_name("go-next-symbolic");
@@ -171,25 +294,26 @@ void ContentView::on_item_activated(GtkGridView *view, guint position,
   auto *self = static_cast<ContentView *>(user_data);
 
   auto *item = FILE_ITEM(
-      g_list_model_get_item(G_LIST_MODEL(self->file_store_), position));
+      g_list_model_get_item(G_LIST_MODEL(self->filter_), position));
 
   if (!item)
     return;
 
-  std::string cur_dir = utly.getCurDir();
+  std::string cur_dir = self->current_path_;
   if (cur_dir.empty() || cur_dir.back() != '/') {
     cur_dir += '/';
   }
 
-  if (item->is_directory) {
-    fs::path new_path = cur_dir + item->name + '/';
+  if (file_item_is_directory(item)) {
+    fs::path new_path = cur_dir + file_item_get_name(item) + '/';
     self->navigate(new_path.string());
   } else {
-    std::string full_path = cur_dir + item->name;
+    std::string full_path = cur_dir + file_item_get_name(item);
     GFile *file = g_file_new_for_path(full_path.c_str());
     g_app_info_launch_default_for_uri(g_file_get_uri(file), NULL, NULL);
     g_object_unref(file);
   }
+  g_object_unref(item);
 }
 
 void ContentView::setup_grid_view() {
@@ -198,7 +322,9 @@ void ContentView::setup_grid_view() {
   g_signal_connect(
       factory, "setup",
       G_CALLBACK(
-          +[](GtkSignalListItemFactory *, GtkListItem *list_item, gpointer) {
+          +[](GtkSignalListItemFactory *, GtkListItem *list_item,
+              gpointer user_data) {
+            g_object_set_data(G_OBJECT(list_item), kViewKey, user_data);
             auto *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 6);
             gtk_widget_set_size_request(box, 100, 100);
             gtk_widget_set_halign(box, GTK_ALIGN_CENTER);
@@ -209,7 +335,7 @@ void ContentView::setup_grid_view() {
             gtk_widget_set_margin_bottom(box, 8);
 
             auto *icon = gtk_image_new();
-            gtk_image_set_pixel_size(GTK_IMAGE(icon), 64);
+            gtk_image_set_pixel_size(GTK_IMAGE(icon), kGridIconSize);
             gtk_widget_set_halign(icon, GTK_ALIGN_CENTER);
             gtk_box_append(GTK_BOX(box), icon);
 
@@ -224,24 +350,20 @@ void ContentView::setup_grid_view() {
 
             gtk_list_item_set_child(list_item, box);
           }),
-      nullptr);
+      this);
 
   g_signal_connect(factory, "bind",
                    G_CALLBACK(+[](GtkSignalListItemFactory *,
                                   GtkListItem *list_item, gpointer) {
-                     auto *box = gtk_list_item_get_child(list_item);
-                     auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
-
-                     auto *icon = gtk_widget_get_first_child(box);
-                     auto *label = gtk_widget_get_next_sibling(icon);
-
-                     gtk_image_set_from_icon_name(GTK_IMAGE(icon),
-                                                  item->icon_name);
-                     gtk_label_set_text(GTK_LABEL(label), item->name);
+                     update_grid_cell(list_item);
+                     g_signal_connect_swapped(
+                         gtk_list_item_get_item(list_item), "changed",
+                         G_CALLBACK(update_grid_cell), list_item);
                    }),
                    nullptr);
+  g_signal_connect(factory, "unbind", G_CALLBACK(unbind_grid_cell), nullptr);
 
-  auto *selection = gtk_multi_selection_new(G_LIST_MODEL(file_store_));
+  auto *selection = gtk_multi_selection_new(G_LIST_MODEL(filter_));
   grid_view_ =
       GTK_GRID_VIEW(gtk_grid_view_new(GTK_SELECTION_MODEL(selection), factory));
   gtk_grid_view_set_min_columns(grid_view_, 3);
@@ -253,7 +375,7 @@ void ContentView::setup_grid_view() {
 
 void ContentView::setup_list_view() {
   auto *selection =
-      gtk_multi_selection_new(G_LIST_MODEL(g_object_ref(file_store_)));
+      gtk_multi_selection_new(G_LIST_MODEL(g_object_ref(filter_)));
   list_view_ =
       GTK_COLUMN_VIEW(gtk_column_view_new(GTK_SELECTION_MODEL(selection)));
   gtk_column_view_set_show_column_separators(list_view_, FALSE);
@@ -283,17 +405,14 @@ void ContentView::setup_list_view() {
   g_signal_connect(name_factory, "bind",
                    G_CALLBACK(+[](GtkSignalListItemFactory *,
                                   GtkListItem *list_item, gpointer) {
-                     auto *box = gtk_list_item_get_child(list_item);
-                     auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
-
-                     auto *icon = gtk_widget_get_first_child(box);
-                     auto *label = gtk_widget_get_next_sibling(icon);
-
-                     gtk_image_set_from_icon_name(GTK_IMAGE(icon),
-                                                  item->icon_name);
-                     gtk_label_set_text(GTK_LABEL(label), item->name);
+                     update_name_cell(list_item);
+                     g_signal_connect_swapped(
+                         gtk_list_item_get_item(list_item), "changed",
+                         G_CALLBACK(update_name_cell), list_item);
                    }),
                    nullptr);
+  g_signal_connect(name_factory, "unbind", G_CALLBACK(disconnect_item),
+                   nullptr);
   g_signal_connect(list_view_, "activate", G_CALLBACK(on_item_activated), this);
   auto *name_col = gtk_column_view_column_new("Name", name_factory);
   gtk_column_view_column_set_expand(name_col, TRUE);
@@ -314,11 +433,14 @@ void ContentView::setup_list_view() {
   g_signal_connect(size_factory, "bind",
                    G_CALLBACK(+[](GtkSignalListItemFactory *,
                                   GtkListItem *list_item, gpointer) {
-                     auto *label = gtk_list_item_get_child(list_item);
-                     auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
-                     gtk_label_set_text(GTK_LABEL(label), item->size);
+                     update_size_label(list_item);
+                     g_signal_connect_swapped(
+                         gtk_list_item_get_item(list_item), "changed",
+                         G_CALLBACK(update_size_label), list_item);
                    }),
                    nullptr);
+  g_signal_connect(size_factory, "unbind", G_CALLBACK(disconnect_item),
+                   nullptr);
 
   auto *size_col = gtk_column_view_column_new("Size", size_factory);
   gtk_column_view_column_set_resizable(size_col, TRUE);
@@ -338,11 +460,14 @@ void ContentView::setup_list_view() {
   g_signal_connect(type_factory, "bind",
                    G_CALLBACK(+[](GtkSignalListItemFactory *,
                                   GtkListItem *list_item, gpointer) {
-                     auto *label = gtk_list_item_get_child(list_item);
-                     auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
-                     gtk_label_set_text(GTK_LABEL(label), item->file_type);
+                     update_type_label(list_item);
+                     g_signal_connect_swapped(
+                         gtk_list_item_get_item(list_item), "changed",
+                         G_CALLBACK(update_type_label), list_item);
                    }),
                    nullptr);
+  g_signal_connect(type_factory, "unbind", G_CALLBACK(disconnect_item),
+                   nullptr);
 
   auto *type_col = gtk_column_view_column_new("Type", type_factory);
   gtk_column_view_column_set_resizable(type_col, TRUE);
@@ -362,51 +487,729 @@ void ContentView::setup_list_view() {
   g_signal_connect(modified_factory, "bind",
                    G_CALLBACK(+[](GtkSignalListItemFactory *,
                                   GtkListItem *list_item, gpointer) {
-                     auto *label = gtk_list_item_get_child(list_item);
-                     auto *item = FILE_ITEM(gtk_list_item_get_item(list_item));
-                     gtk_label_set_text(GTK_LABEL(label), item->modified);
+                     update_modified_label(list_item);
+                     g_signal_connect_swapped(
+                         gtk_list_item_get_item(list_item), "changed",
+                         G_CALLBACK(update_modified_label), list_item);
                    }),
                    nullptr);
+  g_signal_connect(modified_factory, "unbind", G_CALLBACK(disconnect_item),
+                   nullptr);
 
   auto *modified_col = gtk_column_view_column_new("Modified", modified_factory);
   gtk_column_view_column_set_resizable(modified_col, TRUE);
   gtk_column_view_append_column(list_view_, modified_col);
+
+  auto *list_scroll = gtk_scrolled_window_new();
+  gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(list_scroll),
+                                 GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+  gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(list_scroll),
+                                GTK_WIDGET(list_view_));
+  gtk_widget_set_vexpand(list_scroll, TRUE);
+  gtk_stack_add_named(view_stack_, list_scroll, "list");
+
+  // Its columns are counted from now on too
+  if (diagnostics_ && diagnostics_->visible()) {
+    diagnostics_.reset();
+    set_diagnostics_visible(true);
+  } else {
+    diagnostics_.reset();
+  }
+}
+
+void ContentView::stop_loading() {
+  if (scan_job_)
+    scan_job_->cancel();
+  if (search_job_) {
+    search_job_->cancel();
+    search_job_.reset();
+  }
+  if (metadata_loader_) {
+    metadata_loader_->cancel();
+    metadata_loader_.reset();
+  }
+  metadata_from_ = nullptr;
+  early_metadata_.clear();
+  release_followers();
+  if (stat_job_) {
+    stat_job_->cancel();
+    stat_job_.reset();
+  }
+  queued_changes_.clear();
+  finish_after_changes_ = false;
+  cancel_population();
+  if (!current_path_.empty())
+    Thumbnailer::instance().withdraw_directory(current_path_);
+  if (scanning_) {
+    scanning_ = false;
+    wake_waiting_views();
+  }
+}
+
+bool ContentView::is_scanning(const std::string &path) const {
+  return scanning_ && current_path_ == path;
+}
+
+// Views that followed a scan dropped here load the directory themselves
+void ContentView::wake_waiting_views() {
+  for (auto *view : live_views) {
+    if (view == this || !view->waiting_for_scan_ ||
+        view->current_path_ != current_path_)
+      continue;
+    view->add_sample_items();
+  }
+}
+
+// Views that followed this one's finished scan keep the rows they show.
+// Once their own last batch is in they are sorted if need be, and this
+// view's metadata pass fills them in as well.
+void ContentView::hand_over_scan(bool sorted) {
+  auto sort = file_list_model_get_sort(file_store_);
+  for (auto *view : live_views) {
+    if (view == this || !view->waiting_for_scan_ ||
+        view->current_path_ != current_path_)
+      continue;
+    view->metadata_from_ = this;
+    view->scan_finished_ = true;
+    view->needs_sort_ =
+        !sorted || file_list_model_get_sort(view->file_store_) != sort;
+    if (view->populate_source_ == 0)
+      view->finish_loading();
+  }
+}
+
+// Views this one's metadata pass was filling in look up the rest
+// themselves
+void ContentView::release_followers() {
+  for (auto *view : live_views) {
+    if (view->metadata_from_ != this)
+      continue;
+    view->metadata_from_ = nullptr;
+    view->early_metadata_.clear();
+    if (!view->waiting_for_scan_)
+      view->load_metadata();
+  }
+}
+
+// Shows what the other window's scan brought in so far. Later batches are
+// handed over by its append_entries.
+void ContentView::follow_scan(const ContentView &view) {
+  file_list_model_set_listing(file_store_,
+                              file_list_model_share_listing(view.file_store_),
+                              file_list_model_get_order(view.file_store_));
+  // Changes to a saved listing are handed over too, and need the rows in
+  // this view's order
+  if (file_list_model_get_sort(file_store_) !=
+      file_list_model_get_sort(view.file_store_))
+    file_list_model_sort(file_store_);
+  pending_batches_ = view.pending_batches_;
+  pending_offset_ = view.pending_offset_;
+  if (!pending_batches_.empty())
+    populate_source_ = g_idle_add(on_populate_idle, this);
+  watch_first_paint();
 }
 
 void ContentView::add_sample_items() {
-  const auto [sc, s] = utly.scan(utly.getCurDir());
+  store_listing();
+  initial_load_pending_ = false;
+  restat_saved_ = false;
+  waiting_for_scan_ = false;
+  stop_loading();
+  search_query_.clear();
+
+  // The same directory has the same key in every window
+  current_path_ = utly_.getCurDir();
+  while (current_path_.size() > 1 && current_path_.back() == '/')
+    current_path_.pop_back();
+  current_stamp_ = DirStamp::of(current_path_);
+  // Changes that happen while the listing loads are applied afterwards
+  watcher_ = std::make_unique<DirWatcher>(
+      current_path_, [this](std::vector<std::string> &&names) {
+        apply_changes(std::move(names));
+      });
+  watcher_->set_paused(true);
 
-  for (auto &s : sc) {
-    g_list_store_append(file_store_,
-                        file_item_new(s.c_str(), "folder-symbolic", "Folder",
-                                      "--", "Today", TRUE));
+  if (current_stamp_) {
+    TraceSpan lookup_span("listing-cache-lookup");
+    auto cached =
+        ListingCache::instance().lookup(current_path_, *current_stamp_);
+    log_cache_stats();
+    if (cached) {
+      scan_job_.reset();
+      lookup_span.set_count(cached->order.size());
+      file_list_model_set_listing(file_store_, std::move(cached->listing),
+                                  std::move(cached->order));
+      // Sizes and dates may have filled in since the order was stored
+      auto sort = file_list_model_get_sort(file_store_);
+      if (cached->sort != sort || sort.needs_metadata())
+        file_list_model_sort(file_store_);
+      watch_first_paint();
+      ListingSnapshot::instance().remember(
+          current_path_, *current_stamp_,
+          {file_list_model_share_listing(file_store_),
+           file_list_model_get_order(file_store_),
+           file_list_model_get_sort(file_store_)});
+      watcher_->set_paused(false);
+      load_metadata();
+      return;
+    }
+    if (auto saved = ListingSnapshot::instance().take(current_path_)) {
+      show_saved(std::move(*saved));
+      return;
+    }
   }
-  for (auto &c : s) {
-    g_list_store_append(file_store_,
-                        file_item_new(c.c_str(), "text-x-generic", "file", "--",
-                                      "today", false));
+
+  file_list_model_clear(file_store_);
+  for (auto *view : live_views) {
+    if (view != this && view->is_scanning(current_path_)) {
+      scan_job_.reset();
+      waiting_for_scan_ = true;
+      follow_scan(*view);
+      return;
+    }
   }
+  scanning_ = true;
+  scan_job_ = ScanJob::start(
+      current_path_,
+      [this](Listing &&entries) { append_entries(std::move(entries)); },
+      [this](bool sorted) {
+        scan_finished_ = true;
+        // Streamed batches arrive in directory order, a single batch in
+        // name order
+        needs_sort_ =
+            !sorted || file_list_model_get_sort(file_store_) != SortOrder();
+        if (populate_source_ == 0)
+          finish_loading();
+      });
 }
 
-void ContentView::reload_items() {
-  g_list_store_remove_all(file_store_);
-  const auto [sc, s] = utly.scan(utly.getCurDir());
+// Shows what the last run saved right away. If the directory changed since,
+// it is listed again in the background and only the names that came or
+// went are looked at.
+void ContentView::show_saved(ListingSnapshot::Saved &&saved) {
+  scan_job_.reset();
+  file_list_model_set_listing(file_store_, std::move(saved.contents.listing),
+                              std::move(saved.contents.order));
+  auto sort = file_list_model_get_sort(file_store_);
+  if (saved.contents.sort != sort || sort.needs_metadata())
+    file_list_model_sort(file_store_);
+  watch_first_paint();
+  // Files rewritten in place since then leave the stamp alone
+  restat_saved_ = true;
+  if (saved.stamp == *current_stamp_) {
+    finish_loading();
+    return;
+  }
 
-  for (auto &s : sc) {
-    g_list_store_append(file_store_,
-                        file_item_new(s.c_str(), "folder-symbolic", "Folder",
-                                      "--", "Today", TRUE));
+  auto scanned = std::make_shared<std::unordered_set<std::string>>();
+  scanning_ = true;
+  scan_job_ = ScanJob::start(
+      current_path_,
+      [scanned](Listing &&batch) {
+        for (std::size_t i = 0; i < batch.size(); i++)
+          scanned->emplace(batch.name(batch[i]));
+      },
+      [this, scanned](bool) { apply_scan_difference(*scanned); });
+}
+
+void ContentView::apply_scan_difference(
+    const std::unordered_set<std::string> &scanned) {
+  const auto &listing = file_list_model_get_listing(file_store_);
+  std::unordered_set<std::string_view> shown;
+  std::vector<std::string> changed;
+  for (auto index : file_list_model_get_order(file_store_)) {
+    auto name = listing.name(listing[index]);
+    shown.insert(name);
+    if (!scanned.contains(std::string(name)))
+      changed.emplace_back(name);
   }
-  for (auto &c : s) {
-    g_list_store_append(file_store_,
-                        file_item_new(c.c_str(), "text-x-generic", "file", "--",
-                                      "today", false));
+  for (const auto &name : scanned)
+    if (!shown.contains(name))
+      changed.push_back(name);
+  g_debug("%s: %zu names changed since the saved listing",
+          current_path_.c_str(), changed.size());
+
+  // A changed .hidden reloads the whole directory instead
+  bool reloads =
+      std::find(changed.begin(), changed.end(), ".hidden") != changed.end();
+  apply_changes(std::move(changed));
+  if (reloads)
+    return;
+  if (stat_job_)
+    finish_after_changes_ = true;
+  else
+    finish_loading();
+}
+
+void ContentView::search(const std::string &query) {
+  if (query == search_query_)
+    return;
+  if (query.empty()) {
+    // Back to the directory itself, usually straight from the cache
+    add_sample_items();
+    return;
   }
 
+  initial_load_pending_ = false;
+  waiting_for_scan_ = false;
+  stop_loading();
+  search_query_ = query;
+  // Matches come from the whole subtree, which the watcher does not cover
+  watcher_.reset();
+  file_list_model_clear(file_store_);
+  search_job_ = SearchJob::start(
+      current_path_, query,
+      [this](Listing &&entries) { append_entries(std::move(entries)); },
+      [this] {
+        scan_finished_ = true;
+        needs_sort_ = true;
+        if (populate_source_ == 0)
+          finish_loading();
+      });
+}
+
+void ContentView::set_show_hidden(bool show_hidden) {
+  file_filter_model_set_show_hidden(filter_, show_hidden);
+}
+
+void ContentView::set_diagnostics_visible(bool visible) {
+  if (!diagnostics_) {
+    if (!visible)
+      return;
+    std::vector<GtkListItemFactory *> columns;
+    auto *list_columns =
+        list_view_ ? gtk_column_view_get_columns(list_view_) : nullptr;
+    for (guint i = 0; list_columns && i < g_list_model_get_n_items(list_columns);
+         i++) {
+      auto *column = GTK_COLUMN_VIEW_COLUMN(
+          g_list_model_get_item(list_columns, i));
+      columns.push_back(gtk_column_view_column_get_factory(column));
+      g_object_unref(column);
+    }
+    diagnostics_ = std::make_unique<DiagnosticsOverlay>(
+        overlay_, G_LIST_MODEL(file_store_), G_LIST_MODEL(filter_),
+        std::vector<DiagnosticsOverlay::Factories>{
+            {"grid", {gtk_grid_view_get_factory(grid_view_)}},
+            {"list", std::move(columns)}});
+  }
+  diagnostics_->set_visible(visible);
+}
+
+void ContentView::filter(const std::string &query) {
+  TraceSpan span("filter");
+  file_filter_model_set_query(filter_, query);
+}
+
+void ContentView::finish_loading() {
+  bool sorted = !needs_sort_;
+  if (needs_sort_) {
+    TraceSpan span("sort",
+                   g_list_model_get_n_items(G_LIST_MODEL(file_store_)));
+    file_list_model_sort(file_store_);
+  }
+  // An empty folder paints once it is known to be empty
+  watch_first_paint();
+  scan_finished_ = false;
+  needs_sort_ = false;
+
+  if (!search_query_.empty()) {
+    search_job_.reset();
+    load_metadata();
+    return;
+  }
+
+  watcher_->set_paused(false);
+  if (waiting_for_scan_) {
+    // The scan was another window's, and so is the metadata pass
+    waiting_for_scan_ = false;
+    if (metadata_from_)
+      take_metadata(*metadata_from_, std::exchange(early_metadata_, {}));
+    else
+      load_metadata();
+    return;
+  }
+  scanning_ = false;
+  if (current_stamp_) {
+    CachedListing shown{file_list_model_share_listing(file_store_),
+                        file_list_model_get_order(file_store_),
+                        file_list_model_get_sort(file_store_)};
+    ListingSnapshot::instance().remember(current_path_, *current_stamp_,
+                                         shown);
+    ListingCache::instance().store(current_path_, *current_stamp_,
+                                   std::move(shown));
+  }
+  hand_over_scan(sorted);
+  load_metadata();
+}
+
+void ContentView::load_metadata() {
+  // Whatever the last loader still had to do is picked up again below
+  if (metadata_loader_)
+    metadata_loader_->cancel();
+  metadata_from_ = nullptr;
+  early_metadata_.clear();
+  const auto &listing = file_list_model_get_listing(file_store_);
+  std::vector<std::uint32_t> missing;
+  for (auto index : file_list_model_get_order(file_store_)) {
+    const auto &e = listing[index];
+    if (!e.has_metadata || restat_saved_ ||
+        (!e.is_directory && e.content_type == atoms::kNone))
+      missing.push_back(index);
+  }
+  restat_saved_ = false;
+  if (missing.empty())
+    return;
+
+  // Shared, not copied; what comes back goes to a copy of the model's
+  metadata_loader_ = MetadataLoader::start(
+      current_path_, file_list_model_share_listing(file_store_),
+      std::move(missing), [this](std::vector<MetadataResult> &&results) {
+        file_list_model_update_metadata(file_store_, results);
+        for (auto *view : live_views)
+          if (view->metadata_from_ == this)
+            view->take_metadata(*this, results);
+      });
+}
+
+// Results from the metadata pass of the window whose scan this one
+// followed. Entry indices match while both listings grew the same way,
+// which the names are checked for; otherwise this view looks its entries
+// up itself.
+void ContentView::take_metadata(const ContentView &from,
+                                const std::vector<MetadataResult> &results) {
+  if (waiting_for_scan_) {
+    early_metadata_.insert(early_metadata_.end(), results.begin(),
+                           results.end());
+    return;
+  }
+  const auto &ours = file_list_model_get_listing(file_store_);
+  const auto &theirs = file_list_model_get_listing(from.file_store_);
+  for (const auto &r : results) {
+    if (r.index >= ours.size() || r.index >= theirs.size() ||
+        ours.name(ours[r.index]) != theirs.name(theirs[r.index])) {
+      load_metadata();
+      return;
+    }
+  }
+  file_list_model_update_metadata(file_store_, results);
+}
+
+// What was stored when the listing was loaded is a copy by now, without
+// the sizes, dates and types filled in since. Stored again on the way out,
+// unless the directory changed meanwhile, so coming back does not look them
+// up again.
+void ContentView::store_listing() {
+  if (!current_stamp_ || scanning_ || waiting_for_scan_ ||
+      populate_source_ != 0 || !search_query_.empty() ||
+      DirStamp::of(current_path_) != current_stamp_)
+    return;
+  CachedListing shown{file_list_model_share_listing(file_store_),
+                      file_list_model_get_order(file_store_),
+                      file_list_model_get_sort(file_store_)};
+  ListingSnapshot::instance().remember(current_path_, *current_stamp_, shown);
+  ListingCache::instance().store(current_path_, *current_stamp_,
+                                 std::move(shown));
+}
+
+void ContentView::apply_changes(std::vector<std::string> &&names) {
+  // Which entries are hidden may have changed for any of them
+  if (std::find(names.begin(), names.end(), ".hidden") != names.end()) {
+    // Reloaded from the main loop, this runs inside the watcher being
+    // replaced
+    ListingCache::instance().erase(current_path_);
+    current_stamp_.reset();
+    if (reload_source_ == 0)
+      reload_source_ = g_idle_add(
+          +[](gpointer data) {
+            auto *self = static_cast<ContentView *>(data);
+            self->reload_source_ = 0;
+            self->add_sample_items();
+            return G_SOURCE_REMOVE;
+          },
+          this);
+    return;
+  }
+
+  // Files rewritten in place leave the folder's mtime alone
+  SizeJob::invalidate(current_path_);
+  if (names.empty())
+    return;
+  if (stat_job_)
+    queued_changes_.insert(queued_changes_.end(),
+                           std::make_move_iterator(names.begin()),
+                           std::make_move_iterator(names.end()));
+  else
+    look_up_changes(std::move(names));
+}
+
+// Looks at what is there now rather than replaying the events, off the
+// main loop
+void ContentView::look_up_changes(std::vector<std::string> &&names) {
+  stat_job_ = StatJob::start(
+      current_path_, std::move(names),
+      [this](std::vector<EntryUpdate> &&updates, bool unsettled) {
+        stat_job_.reset();
+        apply_updates(updates, unsettled);
+        if (!queued_changes_.empty()) {
+          // Names that changed more than once are looked up once
+          auto names = std::exchange(queued_changes_, {});
+          std::sort(names.begin(), names.end());
+          names.erase(std::unique(names.begin(), names.end()), names.end());
+          look_up_changes(std::move(names));
+        } else if (finish_after_changes_) {
+          finish_after_changes_ = false;
+          finish_loading();
+        }
+      });
+}
+
+void ContentView::apply_updates(const std::vector<EntryUpdate> &updates,
+                                bool unsettled) {
+  bool renumbered = file_list_model_apply(file_store_, updates);
+  // Views following a saved listing being brought up to date get the same
+  // changes, which keeps their entries in step
+  if (scanning_) {
+    for (auto *view : live_views)
+      if (view != this && view->waiting_for_scan_ &&
+          view->current_path_ == current_path_)
+        file_list_model_apply(view->file_store_, updates);
+  }
+  // While a saved listing is brought up to date, finish_loading does this.
+  // A loader still working on the old entry indices starts over.
+  if ((unsettled || renumbered) && !scanning_)
+    load_metadata();
+}
+
+void ContentView::on_thumbnail_ready(const std::string &path) {
+  std::string dir = current_path_;
+  if (dir.empty() || dir.back() != '/')
+    dir += '/';
+  if (path.size() <= dir.size() || !path.starts_with(dir))
+    return;
+  // Search results are named by their path below the directory
+  auto name = std::string_view(path).substr(dir.size());
+  if (!search_query_.empty() || name.find('/') == std::string_view::npos)
+    file_list_model_refresh(file_store_, name);
+}
+
+void ContentView::log_cache_stats() {
+  auto stats = ListingCache::instance().stats();
+  g_debug("listing cache: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT
+          " misses, %" G_GUINT64_FORMAT " evictions, %zu dirs, %zu/%zu KiB",
+          stats.hits, stats.misses, stats.evictions, stats.entries,
+          stats.bytes >> 10, stats.budget >> 10);
+
+  auto types = ContentTypeDetector::instance().stats();
+  g_debug("content types: %" G_GUINT64_FORMAT " by extension, "
+          "%" G_GUINT64_FORMAT " by glob, %" G_GUINT64_FORMAT " cached, "
+          "%" G_GUINT64_FORMAT " sniffed",
+          types.extension, types.glob, types.cached, types.sniffed);
+
+  auto icons = IconCache::instance().stats();
+  g_debug("icons: %" G_GUINT64_FORMAT " hits, %" G_GUINT64_FORMAT
+          " misses, %" G_GUINT64_FORMAT " theme changes, %zu cached",
+          icons.hits, icons.misses, icons.invalidations, icons.entries);
+
+  auto thumbs = Thumbnailer::instance().stats();
+  g_debug("thumbnails: %" G_GUINT64_FORMAT " memory hits, %" G_GUINT64_FORMAT
+          " disk hits, %" G_GUINT64_FORMAT " generated, %" G_GUINT64_FORMAT
+          " failed, %" G_GUINT64_FORMAT " withdrawn, %zu cached, %zu KiB",
+          thumbs.memory_hits, thumbs.disk_hits, thumbs.generated,
+          thumbs.failed, thumbs.withdrawn, thumbs.entries, thumbs.bytes >> 10);
+}
+
+void ContentView::append_entries(Listing &&entries) {
+  if (scanning_) {
+    for (auto *view : live_views)
+      if (view != this && view->waiting_for_scan_ &&
+          view->current_path_ == current_path_)
+        view->append_entries(Listing(entries));
+  }
+
+  if (entries.size() <= kInsertThreshold && pending_batches_.empty()) {
+    insert_entries(entries, 0, entries.size());
+    return;
+  }
+
+  pending_batches_.push_back(std::move(entries));
+  if (populate_source_ == 0)
+    populate_source_ = g_idle_add(on_populate_idle, this);
+}
+
+void ContentView::insert_entries(const Listing &entries, std::size_t begin,
+                                 std::size_t end) {
+  TraceSpan span("populate", end - begin);
+  file_list_model_append(file_store_, entries, begin, end);
+  watch_first_paint();
+}
+
+gboolean ContentView::on_populate_idle(gpointer user_data) {
+  auto *self = static_cast<ContentView *>(user_data);
+  auto &batch = self->pending_batches_.front();
+
+  std::size_t end =
+      std::min(self->pending_offset_ + kInsertChunk, batch.size());
+  self->insert_entries(batch, self->pending_offset_, end);
+  self->pending_offset_ = end;
+
+  if (end == batch.size()) {
+    self->pending_batches_.pop_front();
+    self->pending_offset_ = 0;
+  }
+  if (!self->pending_batches_.empty())
+    return G_SOURCE_CONTINUE;
+
+  self->populate_source_ = 0;
+  if (self->scan_finished_)
+    self->finish_loading();
+  return G_SOURCE_REMOVE;
+}
+
+void ContentView::cancel_population() {
+  if (populate_source_ != 0) {
+    g_source_remove(populate_source_);
+    populate_source_ = 0;
+  }
+  pending_batches_.clear();
+  pending_offset_ = 0;
+  scan_finished_ = false;
+  needs_sort_ = false;
+}
+
+void ContentView::begin_trace_navigation() {
+  if (!Trace::enabled())
+    return;
+  // Left before it painted
+  stop_watching_paint();
+  Trace::end_navigation(trace_navigation_);
+  trace_navigation_ = Trace::begin_navigation(utly_.getCurDir());
+}
+
+// Ends the navigation span, and startup, once the next frame, the first
+// with its rows, has been painted
+void ContentView::watch_first_paint() {
+  if ((trace_navigation_ == 0 && !StartupTimer::enabled()) ||
+      after_paint_handler_ != 0)
+    return;
+  auto *widget = GTK_WIDGET(content_box_);
+  if (!gtk_widget_get_realized(widget)) {
+    // The window's first frame, at startup
+    paint_clock_ = nullptr;
+    after_paint_handler_ = g_signal_connect_swapped(
+        widget, "realize", G_CALLBACK(+[](ContentView *self) {
+          g_signal_handler_disconnect(self->content_box_,
+                                      self->after_paint_handler_);
+          self->after_paint_handler_ = 0;
+          self->watch_first_paint();
+        }),
+        this);
+    return;
+  }
+  // Held, so the handler can still be disconnected once the window is gone
+  paint_clock_ =
+      GDK_FRAME_CLOCK(g_object_ref(gtk_widget_get_frame_clock(widget)));
+  after_paint_handler_ = g_signal_connect(paint_clock_, "after-paint",
+                                          G_CALLBACK(on_after_paint), this);
+}
+
+void ContentView::stop_watching_paint() {
+  if (after_paint_handler_ != 0) {
+    g_signal_handler_disconnect(
+        paint_clock_ ? G_OBJECT(paint_clock_) : G_OBJECT(content_box_),
+        after_paint_handler_);
+    after_paint_handler_ = 0;
+  }
+  g_clear_object(&paint_clock_);
+}
+
+void ContentView::on_after_paint(GdkFrameClock *, gpointer user_data) {
+  auto *self = static_cast<ContentView *>(user_data);
+  Trace::end_navigation(self->trace_navigation_);
+  self->trace_navigation_ = 0;
+  StartupTimer::finish("items-painted");
+  self->stop_watching_paint();
+}
+
+void ContentView::load_after_first_frame() {
+  initial_load_pending_ = true;
+  load_handler_ = g_signal_connect_swapped(
+      content_box_, "realize", G_CALLBACK(+[](ContentView *self) {
+        g_signal_handler_disconnect(self->content_box_, self->load_handler_);
+        self->load_clock_ = GDK_FRAME_CLOCK(g_object_ref(
+            gtk_widget_get_frame_clock(GTK_WIDGET(self->content_box_))));
+        self->load_handler_ = g_signal_connect(
+            self->load_clock_, "after-paint", G_CALLBACK(on_first_frame),
+            self);
+      }),
+      this);
+}
+
+void ContentView::on_first_frame(GdkFrameClock *clock, gpointer user_data) {
+  auto *self = static_cast<ContentView *>(user_data);
+  g_signal_handler_disconnect(clock, self->load_handler_);
+  self->load_handler_ = 0;
+  g_clear_object(&self->load_clock_);
+  // Outside the frame, so the rows are laid out in the next one
+  self->load_source_ = g_idle_add(
+      +[](gpointer user_data) -> gboolean {
+        auto *self = static_cast<ContentView *>(user_data);
+        self->load_source_ = 0;
+        // Unless something was opened in the meantime
+        if (self->initial_load_pending_)
+          self->add_sample_items();
+        return G_SOURCE_REMOVE;
+      },
+      self);
+}
+
+void ContentView::show_directory(const std::string &path) {
+  utly_.setCurDir(path);
+  reload_items();
+}
+
+void ContentView::reload_items() {
+  begin_trace_navigation();
+  add_sample_items();
+
   refresh_path_bar();
 }
 
+void ContentView::set_sort(SortOrder sort) {
+  file_list_model_set_sort(file_store_, sort);
+  // Batches still waiting to be inserted are in the old order
+  if (scan_finished_)
+    needs_sort_ = true;
+}
+
+std::vector<std::string> ContentView::selected_paths() const {
+  auto *model = is_grid_mode_ ? gtk_grid_view_get_model(grid_view_)
+                              : gtk_column_view_get_model(list_view_);
+  auto *selection = gtk_selection_model_get_selection(model);
+  std::string dir = current_path_;
+  if (dir.empty() || dir.back() != '/')
+    dir += '/';
+
+  std::vector<std::string> paths;
+  paths.reserve(gtk_bitset_get_size(selection));
+  GtkBitsetIter iter;
+  guint position;
+  for (bool more = gtk_bitset_iter_init_first(&iter, selection, &position);
+       more; more = gtk_bitset_iter_next(&iter, &position)) {
+    auto *item =
+        FILE_ITEM(g_list_model_get_item(G_LIST_MODEL(model), position));
+    if (!item)
+      continue;
+    // Search results are named by their path below the directory
+    paths.push_back(dir + file_item_get_name(item));
+    g_object_unref(item);
+  }
+  gtk_bitset_unref(selection);
+  return paths;
+}
+
 void ContentView::set_view_mode(bool grid_mode) {
+  if (!grid_mode && !list_view_)
+    setup_list_view();
   is_grid_mode_ = grid_mode;
   gtk_stack_set_visible_child_name(view_stack_, grid_mode ? "grid" : "list");
 }
@@ -428,9 +1231,9 @@ void ContentView::go_back() {
   std::string target = back_stack_.back();
   back_stack_.pop_back();
   
-  forward_stack_.push_back(utly.getCurDir());
+  forward_stack_.push_back(utly_.getCurDir());
   
-  utly.setCurDir(target);
+  utly_.setCurDir(target);
   reload_items();
   update_history_state();
 }
@@ -441,9 +1244,9 @@ void ContentView::go_forward() {
   std::string target = forward_stack_.back();
   forward_stack_.pop_back();
   
-  back_stack_.push_back(utly.getCurDir());
+  back_stack_.push_back(utly_.getCurDir());
   
-  utly.setCurDir(target);
+  utly_.setCurDir(target);
   reload_items();
   update_history_state();
 }
@@ -455,10 +1258,10 @@ void ContentView::update_history_state() {
 }
 
 void ContentView::navigate(const std::string& path) {
-  back_stack_.push_back(utly.getCurDir());
+  back_stack_.push_back(utly_.getCurDir());
   forward_stack_.clear();
   
-  utly.setCurDir(path);
+  utly_.setCurDir(path);
   reload_items();
   update_history_state();
 }
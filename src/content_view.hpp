@@ -18,23 +18,59 @@
 
 #pragma once
 
+#include "file_filter_model.hpp"
+#include "file_list_model.hpp"
 #include "glib.h"
+#include "utility/listing.hpp"
+#include "utility/listing_cache.hpp"
+#include "utility/listing_snapshot.hpp"
+#include "utility/utilitas.hpp"
 #include <adwaita.h>
 #include <gtk/gtk.h>
+#include <deque>
 #include <vector>
 #include <string>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_set>
 
 namespace xafile {
 
+class DiagnosticsOverlay;
+class DirWatcher;
+class MetadataLoader;
+class StatJob;
+class ScanJob;
+class SearchJob;
+
 class ContentView {
 public:
   void reload_items();
 
   static ContentView *create();
+  ~ContentView();
   GtkWidget *get_widget() const { return GTK_WIDGET(content_box_); }
 
+  // Shows `path` without adding it to the history, as the sidebar does
+  void show_directory(const std::string &path);
+
   void set_view_mode(bool grid_mode);
+  void set_sort(SortOrder sort);
+  // Hidden entries are always loaded, this only changes what is shown
+  void set_show_hidden(bool show_hidden);
+  // Lists everything below the current directory whose name contains
+  // `query`; an empty query shows the directory again
+  void search(const std::string &query);
+  // Narrows the rows already listed to names fuzzily matching `query`,
+  // best match first; an empty query shows them all again
+  void filter(const std::string &query);
+  // Frame timings, cell and model counters drawn over the views
+  void set_diagnostics_visible(bool visible);
+
+  const std::string &current_path() const { return current_path_; }
+  // Full paths of the selected rows of the visible view
+  std::vector<std::string> selected_paths() const;
 
 private:
   ContentView();
@@ -43,6 +79,36 @@ private:
   void setup_grid_view();
   void setup_list_view();
   void add_sample_items();
+  void append_entries(Listing &&entries);
+  void insert_entries(const Listing &entries, std::size_t begin,
+                      std::size_t end);
+  void cancel_population();
+  void stop_loading();
+  void finish_loading();
+  void load_metadata();
+  void store_listing();
+  void show_saved(ListingSnapshot::Saved &&saved);
+  void apply_scan_difference(const std::unordered_set<std::string> &scanned);
+  void apply_changes(std::vector<std::string> &&names);
+  void look_up_changes(std::vector<std::string> &&names);
+  void apply_updates(const std::vector<EntryUpdate> &updates,
+                     bool unsettled);
+  void on_thumbnail_ready(const std::string &path);
+  static void log_cache_stats();
+  static gboolean on_populate_idle(gpointer user_data);
+  void begin_trace_navigation();
+  void watch_first_paint();
+  void stop_watching_paint();
+  static void on_after_paint(GdkFrameClock *clock, gpointer user_data);
+  bool is_scanning(const std::string &path) const;
+  void wake_waiting_views();
+  void hand_over_scan(bool sorted);
+  void release_followers();
+  void follow_scan(const ContentView &view);
+  void take_metadata(const ContentView &from,
+                     const std::vector<MetadataResult> &results);
+  void load_after_first_frame();
+  static void on_first_frame(GdkFrameClock *clock, gpointer user_data);
   void refresh_path_bar();
   static void on_item_activated(GtkGridView *view, guint position,
                                 gpointer user_data);
@@ -55,10 +121,55 @@ private:
 
   GtkBox *content_box_;
   GtkBox *path_bar_;
+  GtkOverlay *overlay_;
   GtkStack *view_stack_;
   GtkGridView *grid_view_;
-  GtkColumnView *list_view_;
-  GListStore *file_store_;
+  GtkColumnView *list_view_ = nullptr; // built when first shown
+  FileListModel *file_store_;
+  FileFilterModel *filter_;
+  std::shared_ptr<ScanJob> scan_job_;
+  std::shared_ptr<SearchJob> search_job_;
+  std::string search_query_;
+  std::unique_ptr<DirWatcher> watcher_;
+  std::unique_ptr<DiagnosticsOverlay> diagnostics_;
+  std::shared_ptr<MetadataLoader> metadata_loader_;
+  // Changed names are looked up one batch at a time, in the order they came
+  std::shared_ptr<StatJob> stat_job_;
+  std::vector<std::string> queued_changes_;
+  // A saved listing is shown as loaded once its changes are in
+  bool finish_after_changes_ = false;
+  std::deque<Listing> pending_batches_;
+  std::size_t pending_offset_ = 0;
+  guint populate_source_ = 0;
+  std::string current_path_;
+  std::optional<DirStamp> current_stamp_;
+  bool scan_finished_ = false;
+  bool needs_sort_ = false;
+  // A scan of the directory started here, until it is finished or dropped
+  bool scanning_ = false;
+  // Another window is scanning the directory; this one shows its batches
+  // as they come and keeps them once that is done
+  bool waiting_for_scan_ = false;
+  // The window whose scan this one followed, while its metadata pass fills
+  // this one in too. What arrives before the last batch is in waits here.
+  const ContentView *metadata_from_ = nullptr;
+  std::vector<MetadataResult> early_metadata_;
+  // Shown from the last run's snapshot; sizes and dates are looked at again
+  bool restat_saved_ = false;
+  // Navigation waiting for its first painted frame, while tracing
+  std::uint64_t trace_navigation_ = 0;
+  GdkFrameClock *paint_clock_ = nullptr; // null while waiting to be realized
+  gulong after_paint_handler_ = 0;
+  // The first listing waits for the window's first frame
+  bool initial_load_pending_ = false;
+  GdkFrameClock *load_clock_ = nullptr; // null while waiting to be realized
+  gulong load_handler_ = 0;
+  guint load_source_ = 0;
+  guint reload_source_ = 0;
+  std::size_t thumbnail_listener_ = 0;
+  std::size_t icon_listener_ = 0;
+
+  Utility utly_; // the directory shown, before it is loaded
 
   bool is_grid_mode_;
   std::vector<std::string> back_stack_;
@@ -76,14 +187,4 @@ private:
   void navigate(const std::string& path);
 };
 
-struct FileItem {
-  GObject parent;
-  char *name;
-  char *icon_name;
-  char *file_type;
-  char *size;
-  char *modified;
-  bool is_directory;
-};
-
 } // namespace xafile
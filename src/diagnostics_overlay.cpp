@@ -0,0 +1,216 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "diagnostics_overlay.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace xafile {
+
+namespace {
+
+double ms(gint64 us) { return us / 1000.0; }
+
+} // namespace
+
+DiagnosticsOverlay::DiagnosticsOverlay(GtkOverlay *overlay, GListModel *store,
+                                       GListModel *shown,
+                                       std::vector<Factories> views)
+    : view_(GTK_WIDGET(g_object_ref(overlay))), store_{store},
+      shown_{shown} {
+  for (auto &view : views)
+    views_.push_back({view.label, std::move(view.factories)});
+
+  // Held, so the overlay can be taken down after the window is gone
+  label_ = GTK_WIDGET(g_object_ref_sink(gtk_label_new("")));
+  gtk_label_set_xalign(GTK_LABEL(label_), 0.0f);
+  gtk_widget_add_css_class(label_, "osd");
+  gtk_widget_add_css_class(label_, "monospace");
+  gtk_widget_set_halign(label_, GTK_ALIGN_END);
+  gtk_widget_set_valign(label_, GTK_ALIGN_START);
+  gtk_widget_set_margin_top(label_, 12);
+  gtk_widget_set_margin_end(label_, 12);
+  // Clicks and scrolling go to the view underneath
+  gtk_widget_set_can_target(label_, FALSE);
+  gtk_widget_set_visible(label_, FALSE);
+  gtk_overlay_add_overlay(overlay, label_);
+}
+
+DiagnosticsOverlay::~DiagnosticsOverlay() {
+  disconnect();
+  g_signal_handlers_disconnect_by_data(view_, this);
+  if (gtk_widget_get_parent(label_) == view_)
+    gtk_overlay_remove_overlay(GTK_OVERLAY(view_), label_);
+  g_object_unref(label_);
+  g_object_unref(view_);
+}
+
+void DiagnosticsOverlay::set_visible(bool visible) {
+  if (visible == visible_)
+    return;
+  visible_ = visible;
+  gtk_widget_set_visible(label_, visible);
+  if (visible)
+    connect();
+  else
+    disconnect();
+}
+
+void DiagnosticsOverlay::connect() {
+  for (auto &view : views_) {
+    view.setup = view.bind = view.frame_bind = view.max_frame_bind = 0;
+    for (auto *factory : view.factories) {
+      g_signal_connect(factory, "setup", G_CALLBACK(on_setup), &view);
+      g_signal_connect(factory, "bind", G_CALLBACK(on_bind), &view);
+    }
+  }
+  for (auto *model : {&store_, &shown_}) {
+    model->emissions = model->rows = 0;
+    g_signal_connect(model->model, "items-changed",
+                     G_CALLBACK(on_items_changed), model);
+  }
+
+  frames_ = 0;
+  worst_interval_ = total_work_ = worst_work_ = 0;
+  last_frame_time_ = 0;
+  window_start_ = g_get_monotonic_time();
+  update_text(window_start_);
+
+  if (!gtk_widget_get_realized(view_)) {
+    g_signal_connect(view_, "realize", G_CALLBACK(on_realize), this);
+    return;
+  }
+  clock_ = GDK_FRAME_CLOCK(g_object_ref(gtk_widget_get_frame_clock(view_)));
+  g_signal_connect(clock_, "before-paint", G_CALLBACK(on_before_paint), this);
+  g_signal_connect(clock_, "after-paint", G_CALLBACK(on_after_paint), this);
+}
+
+void DiagnosticsOverlay::disconnect() {
+  for (auto &view : views_)
+    for (auto *factory : view.factories)
+      g_signal_handlers_disconnect_by_data(factory, &view);
+  for (auto *model : {&store_, &shown_})
+    g_signal_handlers_disconnect_by_data(model->model, model);
+  if (clock_) {
+    g_signal_handlers_disconnect_by_data(clock_, this);
+    g_clear_object(&clock_);
+  }
+}
+
+void DiagnosticsOverlay::on_realize(GtkWidget *widget, gpointer data) {
+  auto *self = static_cast<DiagnosticsOverlay *>(data);
+  g_signal_handlers_disconnect_by_func(widget, (gpointer)on_realize, self);
+  if (!self->visible_)
+    return;
+  self->clock_ =
+      GDK_FRAME_CLOCK(g_object_ref(gtk_widget_get_frame_clock(widget)));
+  g_signal_connect(self->clock_, "before-paint", G_CALLBACK(on_before_paint),
+                   self);
+  g_signal_connect(self->clock_, "after-paint", G_CALLBACK(on_after_paint),
+                   self);
+}
+
+void DiagnosticsOverlay::on_setup(GtkListItemFactory *, GtkListItem *,
+                                  gpointer data) {
+  static_cast<ViewCounts *>(data)->setup++;
+}
+
+void DiagnosticsOverlay::on_bind(GtkListItemFactory *, GtkListItem *,
+                                 gpointer data) {
+  auto *view = static_cast<ViewCounts *>(data);
+  view->bind++;
+  view->frame_bind++;
+}
+
+void DiagnosticsOverlay::on_items_changed(GListModel *, guint, guint removed,
+                                          guint added, gpointer data) {
+  auto *model = static_cast<ModelCounts *>(data);
+  model->emissions++;
+  model->rows += removed + added;
+}
+
+void DiagnosticsOverlay::on_before_paint(GdkFrameClock *, gpointer data) {
+  static_cast<DiagnosticsOverlay *>(data)->work_start_ =
+      g_get_monotonic_time();
+}
+
+void DiagnosticsOverlay::on_after_paint(GdkFrameClock *clock, gpointer data) {
+  auto *self = static_cast<DiagnosticsOverlay *>(data);
+  gint64 now = g_get_monotonic_time();
+  gint64 work = now - self->work_start_;
+  self->total_work_ += work;
+  self->worst_work_ = std::max(self->worst_work_, work);
+
+  // Frames that follow an idle stretch say nothing about smoothness
+  gint64 frame_time = gdk_frame_clock_get_frame_time(clock);
+  if (self->last_frame_time_ != 0 &&
+      frame_time - self->last_frame_time_ < G_USEC_PER_SEC / 4)
+    self->worst_interval_ = std::max(self->worst_interval_,
+                                     frame_time - self->last_frame_time_);
+  self->last_frame_time_ = frame_time;
+  self->frames_++;
+
+  for (auto &view : self->views_) {
+    view.max_frame_bind = std::max(view.max_frame_bind, view.frame_bind);
+    view.frame_bind = 0;
+  }
+  if (now - self->window_start_ >= kUpdateIntervalUs)
+    self->update_text(now);
+}
+
+void DiagnosticsOverlay::update_text(gint64 now) {
+  double seconds = std::max<gint64>(now - window_start_, 1) /
+                   double(G_USEC_PER_SEC);
+  char line[160];
+  std::string text;
+
+  std::snprintf(line, sizeof(line),
+                "frames  %5.1f fps  worst gap %5.1f ms\n"
+                "work    %5.1f ms avg  %5.1f ms worst\n",
+                frames_ / seconds, ms(worst_interval_),
+                frames_ ? ms(total_work_ / gint64(frames_)) : 0.0,
+                ms(worst_work_));
+  text += line;
+  for (auto &view : views_) {
+    std::snprintf(line, sizeof(line),
+                  "%-7s %5.0f setup/s  %6.0f bind/s  %4llu bind/frame max\n",
+                  view.label, view.setup / seconds, view.bind / seconds,
+                  static_cast<unsigned long long>(view.max_frame_bind));
+    text += line;
+    view.setup = view.bind = view.max_frame_bind = 0;
+  }
+  std::snprintf(line, sizeof(line),
+                "rows    %u in folder, %u shown\n"
+                "changes %5.1f/s (%.0f rows/s) folder, %5.1f/s (%.0f rows/s) "
+                "shown",
+                g_list_model_get_n_items(store_.model),
+                g_list_model_get_n_items(shown_.model),
+                store_.emissions / seconds, store_.rows / seconds,
+                shown_.emissions / seconds, shown_.rows / seconds);
+  text += line;
+  for (auto *model : {&store_, &shown_})
+    model->emissions = model->rows = 0;
+
+  frames_ = 0;
+  worst_interval_ = total_work_ = worst_work_ = 0;
+  window_start_ = now;
+  gtk_label_set_text(GTK_LABEL(label_), text.c_str());
+}
+
+} // namespace xafile
@@ -0,0 +1,102 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace xafile {
+
+// A text box over the file views showing, about four times a second, how
+// long frames take, how many cells the grid and the column view set up and
+// bind per frame, how many rows the models hold and how often they emit
+// items-changed. Telling widget creation (setup), cell updates (bind) and
+// model churn apart is usually enough to explain a janky scroll.
+//
+// Everything it counts is only hooked up while it is shown, so a hidden
+// overlay costs nothing.
+class DiagnosticsOverlay {
+public:
+  // Views whose factories are counted together
+  struct Factories {
+    const char *label;
+    std::vector<GtkListItemFactory *> factories;
+  };
+
+  DiagnosticsOverlay(GtkOverlay *overlay, GListModel *store,
+                     GListModel *shown, std::vector<Factories> views);
+  ~DiagnosticsOverlay();
+
+  DiagnosticsOverlay(const DiagnosticsOverlay &) = delete;
+  DiagnosticsOverlay &operator=(const DiagnosticsOverlay &) = delete;
+
+  void set_visible(bool visible);
+  bool visible() const { return visible_; }
+
+private:
+  static constexpr gint64 kUpdateIntervalUs = 250'000;
+
+  struct ViewCounts {
+    const char *label;
+    std::vector<GtkListItemFactory *> factories;
+    std::uint64_t setup = 0;
+    std::uint64_t bind = 0;
+    std::uint64_t frame_bind = 0; // binds since the last painted frame
+    std::uint64_t max_frame_bind = 0;
+  };
+  struct ModelCounts {
+    GListModel *model;
+    std::uint64_t emissions = 0;
+    std::uint64_t rows = 0; // added plus removed
+  };
+
+  void connect();
+  void disconnect();
+  void update_text(gint64 now);
+  static void on_setup(GtkListItemFactory *, GtkListItem *, gpointer data);
+  static void on_bind(GtkListItemFactory *, GtkListItem *, gpointer data);
+  static void on_items_changed(GListModel *, guint, guint removed, guint added,
+                               gpointer data);
+  static void on_before_paint(GdkFrameClock *clock, gpointer data);
+  static void on_after_paint(GdkFrameClock *clock, gpointer data);
+  static void on_realize(GtkWidget *widget, gpointer data);
+
+  GtkWidget *label_;
+  GtkWidget *view_;
+  GdkFrameClock *clock_ = nullptr; // held while connected
+  std::vector<ViewCounts> views_;
+  ModelCounts store_;
+  ModelCounts shown_;
+  bool visible_ = false;
+
+  // Accumulated since the text was last updated
+  gint64 window_start_ = 0;
+  gint64 work_start_ = 0;
+  gint64 last_frame_time_ = 0;
+  std::uint64_t frames_ = 0;
+  gint64 worst_interval_ = 0;
+  // From before-paint to after-paint: updates, layout, where cells are
+  // bound, and paint
+  gint64 total_work_ = 0;
+  gint64 worst_work_ = 0;
+};
+
+} // namespace xafile
@@ -0,0 +1,141 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dir_watcher.hpp"
+#include <iostream>
+
+namespace xafile {
+
+std::unordered_map<std::string, DirWatcher::Shared *> &
+DirWatcher::shared_monitors() {
+  static auto *monitors = new std::unordered_map<std::string, Shared *>();
+  return *monitors;
+}
+
+DirWatcher::DirWatcher(const std::string &path, ChangesCallback on_changes)
+    : on_changes_(std::move(on_changes)) {
+  auto &monitors = shared_monitors();
+  if (auto it = monitors.find(path); it != monitors.end()) {
+    shared_ = it->second;
+    shared_->watchers.push_back(this);
+    return;
+  }
+
+  GFile *dir = g_file_new_for_path(path.c_str());
+  GError *error = nullptr;
+  auto *monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES,
+                                           nullptr, &error);
+  g_object_unref(dir);
+
+  if (!monitor) {
+    std::cerr << path << ": " << error->message << '\n';
+    g_error_free(error);
+    return;
+  }
+  shared_ = new Shared{path, monitor, {this}};
+  monitors.emplace(path, shared_);
+  g_signal_connect(monitor, "changed", G_CALLBACK(on_changed), shared_);
+}
+
+DirWatcher::~DirWatcher() {
+  if (flush_source_ != 0)
+    g_source_remove(flush_source_);
+  if (!shared_)
+    return;
+  std::erase(shared_->watchers, this);
+  if (!shared_->watchers.empty())
+    return;
+  // The last one watching it
+  shared_monitors().erase(shared_->path);
+  g_signal_handlers_disconnect_by_data(shared_->monitor, shared_);
+  g_file_monitor_cancel(shared_->monitor);
+  g_object_unref(shared_->monitor);
+  delete shared_;
+}
+
+void DirWatcher::set_paused(bool paused) {
+  paused_ = paused;
+  if (!paused_ && !pending_.empty())
+    schedule_flush();
+}
+
+void DirWatcher::queue(GFile *file) {
+  if (!file)
+    return;
+  char *name = g_file_get_basename(file);
+  pending_.emplace(name);
+  g_free(name);
+}
+
+void DirWatcher::schedule_flush() {
+  if (flush_source_ == 0)
+    flush_source_ = g_timeout_add(kFlushInterval, on_flush, this);
+}
+
+void DirWatcher::on_changed(GFileMonitor *monitor, GFile *file,
+                            GFile *other_file, GFileMonitorEvent event_type,
+                            gpointer user_data) {
+  (void)monitor;
+  for (auto *watcher : static_cast<Shared *>(user_data)->watchers)
+    watcher->handle(event_type, file, other_file);
+}
+
+void DirWatcher::handle(GFileMonitorEvent event_type, GFile *file,
+                        GFile *other_file) {
+  switch (event_type) {
+  case G_FILE_MONITOR_EVENT_RENAMED:
+    queue(file);
+    queue(other_file);
+    break;
+  case G_FILE_MONITOR_EVENT_CREATED:
+  case G_FILE_MONITOR_EVENT_DELETED:
+  case G_FILE_MONITOR_EVENT_MOVED_IN:
+  case G_FILE_MONITOR_EVENT_MOVED_OUT:
+  case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+  case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+    queue(file);
+    break;
+  default:
+    return;
+  }
+
+  if (!paused_)
+    schedule_flush();
+}
+
+gboolean DirWatcher::on_flush(gpointer user_data) {
+  auto *self = static_cast<DirWatcher *>(user_data);
+  if (self->paused_ || self->pending_.empty()) {
+    self->flush_source_ = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  std::vector<std::string> names;
+  auto it = self->pending_.begin();
+  while (it != self->pending_.end() && names.size() < kMaxNamesPerFlush) {
+    names.push_back(std::move(self->pending_.extract(it++).value()));
+  }
+
+  bool more = !self->pending_.empty();
+  if (!more)
+    self->flush_source_ = 0;
+  self->on_changes_(std::move(names));
+  return more ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
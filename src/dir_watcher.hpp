@@ -0,0 +1,76 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+// Watches one directory and reports the names of entries that changed.
+// Events are coalesced per name and handed out at most every
+// kFlushInterval, in chunks of at most kMaxNamesPerFlush, so a burst of
+// thousands of writes turns into a few bounded updates.
+//
+// Watchers of the same directory, one per window showing it, share one
+// file monitor. Main thread only.
+class DirWatcher {
+public:
+  using ChangesCallback = std::function<void(std::vector<std::string> &&)>;
+
+  DirWatcher(const std::string &path, ChangesCallback on_changes);
+  ~DirWatcher();
+
+  DirWatcher(const DirWatcher &) = delete;
+  DirWatcher &operator=(const DirWatcher &) = delete;
+
+  // While paused events are only collected
+  void set_paused(bool paused);
+
+private:
+  static constexpr guint kFlushInterval = 100; // ms
+  static constexpr std::size_t kMaxNamesPerFlush = 2048;
+
+  // The monitor of one directory and everyone watching it
+  struct Shared {
+    std::string path;
+    GFileMonitor *monitor;
+    std::vector<DirWatcher *> watchers;
+  };
+
+  static std::unordered_map<std::string, Shared *> &shared_monitors();
+  void queue(GFile *file);
+  void handle(GFileMonitorEvent event_type, GFile *file, GFile *other_file);
+  void schedule_flush();
+  static void on_changed(GFileMonitor *monitor, GFile *file, GFile *other_file,
+                         GFileMonitorEvent event_type, gpointer user_data);
+  static gboolean on_flush(gpointer user_data);
+
+  Shared *shared_ = nullptr;
+  ChangesCallback on_changes_;
+  std::unordered_set<std::string> pending_;
+  guint flush_source_ = 0;
+  bool paused_ = false;
+};
+
+} // namespace xafile
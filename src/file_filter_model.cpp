@@ -0,0 +1,341 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_filter_model.hpp"
+#include "utility/name_filter.hpp"
+#include <algorithm>
+#include <new>
+#include <optional>
+#include <vector>
+
+namespace xafile {
+
+// Source changes are applied at most this often while a query is set
+static constexpr guint kRefilterDelayMs = 100;
+
+struct _FileFilterModel {
+  GObject parent_instance;
+  FileListModel *source;
+  gulong items_changed_handler;
+  guint refilter_source;
+  std::string query;
+  bool show_hidden;
+  // Source positions of the hidden rows, ascending, kept up to date with
+  // every source change whether or not they are shown
+  std::vector<std::uint32_t> hidden;
+  // How many of `hidden`, from the front, are left out: all of them or
+  // none, except while show_hidden is being changed one run at a time
+  std::size_t left_out;
+  // The source listing `entries` index into
+  const Listing *listing;
+  // Matching entry indices, best first
+  std::vector<std::uint32_t> entries;
+  // Folded names of the source rows, kept while the source is unchanged
+  std::optional<FoldedNames> names;
+  // The rows behind `entries`, ascending, for narrowing the next query
+  std::vector<std::uint32_t> matched_rows;
+};
+
+static GType file_filter_model_get_item_type(GListModel *) {
+  return FILE_ITEM_TYPE;
+}
+
+// Every source row is shown as it is
+static bool is_passthrough(FileFilterModel *self) {
+  return self->query.empty() && self->left_out == 0;
+}
+
+// The source row shown at `position` while there is no query. Shown rows
+// before the i-th hidden one number hidden[i] - i, which never decreases.
+static guint source_row(FileFilterModel *self, guint position) {
+  std::size_t low = 0, high = self->left_out;
+  while (low < high) {
+    auto mid = low + (high - low) / 2;
+    if (self->hidden[mid] - mid <= position)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return position + low;
+}
+
+static guint file_filter_model_get_n_items(GListModel *model) {
+  auto *self = FILE_FILTER_MODEL(model);
+  if (is_passthrough(self))
+    return g_list_model_get_n_items(G_LIST_MODEL(self->source));
+  if (self->query.empty())
+    return g_list_model_get_n_items(G_LIST_MODEL(self->source)) -
+           self->left_out;
+  return self->entries.size();
+}
+
+static gpointer file_filter_model_get_item(GListModel *model, guint position) {
+  auto *self = FILE_FILTER_MODEL(model);
+  if (is_passthrough(self))
+    return g_list_model_get_item(G_LIST_MODEL(self->source), position);
+  if (self->query.empty()) {
+    if (position >= file_filter_model_get_n_items(model))
+      return nullptr;
+    return g_list_model_get_item(G_LIST_MODEL(self->source),
+                                 source_row(self, position));
+  }
+  if (position >= self->entries.size())
+    return nullptr;
+  return file_list_model_get_item_for_entry(self->source,
+                                            self->entries[position]);
+}
+
+static void file_filter_model_list_model_init(GListModelInterface *iface) {
+  iface->get_item_type = file_filter_model_get_item_type;
+  iface->get_n_items = file_filter_model_get_n_items;
+  iface->get_item = file_filter_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE(FileFilterModel, file_filter_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(
+                            G_TYPE_LIST_MODEL,
+                            file_filter_model_list_model_init))
+
+// Recomputes the matches. When the query only grew and the source is
+// unchanged, just the previous matches are looked at again.
+static void refilter(FileFilterModel *self, bool narrow) {
+  guint removed = self->entries.size();
+  const auto &listing = file_list_model_get_listing(self->source);
+  const auto &order = file_list_model_get_order(self->source);
+  self->listing = &listing;
+  if (!self->names) {
+    self->names.emplace(listing, order);
+    narrow = false;
+  }
+
+  NameFilter filter(self->query);
+  auto rows = filter.rank(*self->names, narrow ? &self->matched_rows : nullptr);
+  if (!self->show_hidden)
+    std::erase_if(rows, [&](std::uint32_t row) {
+      return listing[order[row]].is_hidden;
+    });
+  self->entries.resize(rows.size());
+  for (std::size_t i = 0; i < rows.size(); i++)
+    self->entries[i] = order[rows[i]];
+  std::sort(rows.begin(), rows.end());
+  self->matched_rows = std::move(rows);
+
+  if (removed > 0 || !self->entries.empty())
+    g_list_model_items_changed(G_LIST_MODEL(self), 0, removed,
+                               self->entries.size());
+}
+
+// Source positions in [begin, end) of hidden rows
+static void append_hidden(FileFilterModel *self, std::uint32_t begin,
+                          std::uint32_t end, std::vector<std::uint32_t> &out) {
+  const auto &listing = file_list_model_get_listing(self->source);
+  const auto &order = file_list_model_get_order(self->source);
+  for (auto row = begin; row < end; row++)
+    if (listing[order[row]].is_hidden)
+      out.push_back(row);
+}
+
+// Keeps `hidden` in step with a source change and, while there is no
+// query, mirrors the change onto the rows shown
+static void track_hidden(FileFilterModel *self, guint position, guint removed,
+                         guint added) {
+  auto &hidden = self->hidden;
+  auto first = std::lower_bound(hidden.begin(), hidden.end(), position);
+  auto last = std::lower_bound(first, hidden.end(), position + removed);
+  guint before = first - hidden.begin();
+  guint hidden_removed = last - first;
+  for (auto it = last; it != hidden.end(); ++it)
+    *it = *it + added - removed;
+
+  std::vector<std::uint32_t> inserted;
+  append_hidden(self, position, position + added, inserted);
+  auto it = hidden.erase(first, last);
+  hidden.insert(it, inserted.begin(), inserted.end());
+
+  if (!self->show_hidden)
+    self->left_out = hidden.size();
+  if (!self->query.empty())
+    return;
+  if (self->show_hidden) {
+    g_list_model_items_changed(G_LIST_MODEL(self), position, removed, added);
+    return;
+  }
+  guint shown_removed = removed - hidden_removed;
+  guint shown_added = added - inserted.size();
+  if (shown_removed > 0 || shown_added > 0)
+    g_list_model_items_changed(G_LIST_MODEL(self), position - before,
+                               shown_removed, shown_added);
+}
+
+static gboolean on_refilter_timeout(gpointer user_data) {
+  auto *self = static_cast<FileFilterModel *>(user_data);
+  self->refilter_source = 0;
+  refilter(self, false);
+  return G_SOURCE_REMOVE;
+}
+
+static void on_source_items_changed(GListModel *, guint position,
+                                    guint removed, guint added,
+                                    gpointer user_data) {
+  auto *self = static_cast<FileFilterModel *>(user_data);
+  self->names.reset();
+  track_hidden(self, position, removed, added);
+  if (self->query.empty())
+    return;
+  // A new listing invalidates every entry index held, so that cannot wait
+  if (&file_list_model_get_listing(self->source) != self->listing) {
+    if (self->refilter_source != 0) {
+      g_source_remove(self->refilter_source);
+      self->refilter_source = 0;
+    }
+    refilter(self, false);
+    return;
+  }
+  if (self->refilter_source == 0)
+    self->refilter_source =
+        g_timeout_add(kRefilterDelayMs, on_refilter_timeout, self);
+}
+
+static void file_filter_model_dispose(GObject *object) {
+  FileFilterModel *self = FILE_FILTER_MODEL(object);
+  if (self->refilter_source != 0) {
+    g_source_remove(self->refilter_source);
+    self->refilter_source = 0;
+  }
+  if (self->source) {
+    g_signal_handler_disconnect(self->source, self->items_changed_handler);
+    g_clear_object(&self->source);
+  }
+  G_OBJECT_CLASS(file_filter_model_parent_class)->dispose(object);
+}
+
+static void file_filter_model_finalize(GObject *object) {
+  FileFilterModel *self = FILE_FILTER_MODEL(object);
+  self->query.~basic_string();
+  self->hidden.~vector();
+  self->entries.~vector();
+  self->names.~optional();
+  self->matched_rows.~vector();
+  G_OBJECT_CLASS(file_filter_model_parent_class)->finalize(object);
+}
+
+static void file_filter_model_class_init(FileFilterModelClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  object_class->dispose = file_filter_model_dispose;
+  object_class->finalize = file_filter_model_finalize;
+}
+
+static void file_filter_model_init(FileFilterModel *self) {
+  self->source = nullptr;
+  self->items_changed_handler = 0;
+  self->refilter_source = 0;
+  self->listing = nullptr;
+  self->show_hidden = false;
+  self->left_out = 0;
+  new (&self->query) std::string();
+  new (&self->hidden) std::vector<std::uint32_t>();
+  new (&self->entries) std::vector<std::uint32_t>();
+  new (&self->names) std::optional<FoldedNames>();
+  new (&self->matched_rows) std::vector<std::uint32_t>();
+}
+
+FileFilterModel *file_filter_model_new(FileListModel *source) {
+  auto *self =
+      FILE_FILTER_MODEL(g_object_new(FILE_FILTER_MODEL_TYPE, nullptr));
+  self->source = FILE_LIST_MODEL(g_object_ref(source));
+  self->items_changed_handler =
+      g_signal_connect(source, "items-changed",
+                       G_CALLBACK(on_source_items_changed), self);
+  append_hidden(self, 0, g_list_model_get_n_items(G_LIST_MODEL(source)),
+                self->hidden);
+  self->left_out = self->hidden.size();
+  return self;
+}
+
+void file_filter_model_set_query(FileFilterModel *self,
+                                 const std::string &query) {
+  if (query == self->query)
+    return;
+  bool narrow = !self->query.empty() && query.starts_with(self->query) &&
+                self->refilter_source == 0;
+  guint before = g_list_model_get_n_items(G_LIST_MODEL(self));
+  self->query = query;
+  if (self->refilter_source != 0) {
+    g_source_remove(self->refilter_source);
+    self->refilter_source = 0;
+  }
+
+  if (query.empty()) {
+    self->entries.clear();
+    self->matched_rows.clear();
+    self->names.reset();
+    guint after = g_list_model_get_n_items(G_LIST_MODEL(self));
+    if (before > 0 || after > 0)
+      g_list_model_items_changed(G_LIST_MODEL(self), 0, before, after);
+    return;
+  }
+
+  // Coming from the unfiltered view every row shown goes
+  if (before != self->entries.size())
+    self->entries.assign(before, 0);
+  refilter(self, narrow);
+}
+
+void file_filter_model_set_show_hidden(FileFilterModel *self,
+                                       bool show_hidden) {
+  if (show_hidden == self->show_hidden)
+    return;
+  self->show_hidden = show_hidden;
+
+  if (!self->query.empty()) {
+    self->left_out = show_hidden ? 0 : self->hidden.size();
+    refilter(self, false);
+    return;
+  }
+
+  // One change per run of adjacent hidden rows. Rows are shown from the
+  // last run up and left out from the first down, so the hidden rows left
+  // out are always a prefix of `hidden` and every step is a valid model.
+  const auto &hidden = self->hidden;
+  auto run_end = [&](std::size_t i) {
+    auto end = i + 1;
+    while (end < hidden.size() && hidden[end] == hidden[end - 1] + 1)
+      end++;
+    return end;
+  };
+  if (show_hidden) {
+    std::vector<std::pair<std::size_t, std::size_t>> runs;
+    for (std::size_t i = 0; i < hidden.size(); i = runs.back().second)
+      runs.emplace_back(i, run_end(i));
+    for (auto it = runs.rbegin(); it != runs.rend(); ++it) {
+      auto [begin, end] = *it;
+      self->left_out = begin;
+      g_list_model_items_changed(G_LIST_MODEL(self), hidden[begin] - begin, 0,
+                                 end - begin);
+    }
+  } else {
+    for (std::size_t begin = 0, end; begin < hidden.size(); begin = end) {
+      end = run_end(begin);
+      self->left_out = end;
+      g_list_model_items_changed(G_LIST_MODEL(self), hidden[begin] - begin,
+                                 end - begin, 0);
+    }
+  }
+}
+
+} // namespace xafile
@@ -0,0 +1,45 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "file_list_model.hpp"
+#include <gio/gio.h>
+#include <string>
+
+namespace xafile {
+
+// Sits between a FileListModel and the views' selection models. With no
+// query it passes rows straight through; with one it shows only the
+// matching rows, best match first. Hidden rows are left out unless asked
+// for. Changes to the source while a query is set are picked up after a
+// short delay, so a directory that is still loading is not refiltered for
+// every batch.
+#define FILE_FILTER_MODEL_TYPE (file_filter_model_get_type())
+G_DECLARE_FINAL_TYPE(FileFilterModel, file_filter_model, FILE, FILTER_MODEL,
+                     GObject)
+
+FileFilterModel *file_filter_model_new(FileListModel *source);
+void file_filter_model_set_query(FileFilterModel *self,
+                                 const std::string &query);
+// Showing or hiding hidden rows touches only those rows, one change per
+// run of adjacent ones
+void file_filter_model_set_show_hidden(FileFilterModel *self,
+                                       bool show_hidden);
+
+} // namespace xafile
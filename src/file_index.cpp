@@ -0,0 +1,792 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_index.hpp"
+#include "content_types.hpp"
+#include "utility/dir_reader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <span>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace xafile {
+
+namespace {
+
+constexpr char kMagic[8] = {'X', 'A', 'F', 'I', 'D', 'X', '\0', '\0'};
+// Bump whenever the layout below changes; older files are rebuilt
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::uint32_t kNoParent = UINT32_MAX;
+
+constexpr std::int64_t kMaxAge = 6 * 60 * 60; // seconds
+constexpr guint kStaleCheckInterval = 30 * 60; // seconds
+constexpr std::size_t kMaxBatch = 4096;
+
+// Every section starts at a multiple of 8 so it can be used in place
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t root_length;
+  std::int64_t built_at; // seconds since the epoch
+  std::uint32_t entry_count;
+  std::uint32_t name_count;
+  std::uint32_t trigram_count;
+  std::uint32_t reserved;
+  std::uint64_t root_offset;
+  std::uint64_t entries_offset;      // FileEntry[entry_count]
+  std::uint64_t name_offsets_offset; // uint32[name_count + 1] into names
+  std::uint64_t names_offset;        // distinct names, NUL separated
+  std::uint64_t name_entries_offset; // uint32[name_count + 1] into entry_ids
+  std::uint64_t entry_ids_offset;    // uint32[entry_count], grouped by name
+  std::uint64_t trigrams_offset;     // FileTrigram[trigram_count], by key
+  std::uint64_t postings_offset;     // delta-varint name ids per trigram
+  std::uint64_t file_size;
+};
+
+// Children of a directory are stored next to each other
+struct FileEntry {
+  std::uint32_t parent; // kNoParent for the root
+  std::uint32_t name;
+  std::uint32_t first_child;
+  std::uint32_t child_count;
+  std::uint32_t is_directory;
+};
+
+struct FileTrigram {
+  std::uint32_t key;
+  std::uint32_t count;
+  std::uint64_t offset; // into the postings section
+};
+
+char ascii_fold(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+std::uint32_t trigram_key(const char *p) {
+  return std::uint32_t(static_cast<unsigned char>(ascii_fold(p[0]))) << 16 |
+         std::uint32_t(static_cast<unsigned char>(ascii_fold(p[1]))) << 8 |
+         std::uint32_t(static_cast<unsigned char>(ascii_fold(p[2])));
+}
+
+// Distinct trigrams of a name, sorted
+void name_trigrams(std::string_view name, std::vector<std::uint32_t> &keys) {
+  keys.clear();
+  for (std::size_t i = 0; i + 3 <= name.size(); i++)
+    keys.push_back(trigram_key(name.data() + i));
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+void put_varint(std::string &out, std::uint32_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+// Path of `path` below `root`, without leading or trailing slashes
+std::optional<std::string_view> relative_to(std::string_view path,
+                                            std::string_view root) {
+  while (path.size() > 1 && path.back() == '/')
+    path.remove_suffix(1);
+  if (!path.starts_with(root))
+    return std::nullopt;
+  path.remove_prefix(root.size());
+  if (path.empty())
+    return path;
+  if (path.front() != '/' && !root.ends_with('/'))
+    return std::nullopt;
+  while (!path.empty() && path.front() == '/')
+    path.remove_prefix(1);
+  return path;
+}
+
+// Keeps the indexer from competing with anything the user is doing
+void lower_thread_priority() {
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassIdle = 3;
+  constexpr int kIoprioClassShift = 13;
+  // With IOPRIO_WHO_PROCESS and 0, both calls affect only this thread
+  syscall(SYS_ioprio_set, kIoprioWhoProcess, 0,
+          kIoprioClassIdle << kIoprioClassShift);
+  setpriority(PRIO_PROCESS, 0, 19);
+}
+
+class IndexBuilder {
+public:
+  explicit IndexBuilder(std::string root) : root_(std::move(root)) {}
+
+  bool build();
+  bool write(const std::string &file, std::int64_t built_at) const;
+
+private:
+  std::uint32_t intern(std::string_view name);
+
+  std::string root_;
+  std::vector<FileEntry> entries_;
+  std::string names_;
+  std::vector<std::uint32_t> name_offsets_;
+  std::unordered_map<std::string, std::uint32_t> name_ids_;
+};
+
+std::uint32_t IndexBuilder::intern(std::string_view name) {
+  auto [it, inserted] = name_ids_.try_emplace(
+      std::string(name), static_cast<std::uint32_t>(name_offsets_.size()));
+  if (inserted) {
+    name_offsets_.push_back(static_cast<std::uint32_t>(names_.size()));
+    names_.append(name);
+    names_.push_back('\0');
+  }
+  return it->second;
+}
+
+// Same rules as SearchJob: symlinked directories and pseudo-filesystems are
+// not entered, and each directory only once.
+bool IndexBuilder::build() {
+  int root_fd = open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  struct stat st;
+  if (root_fd < 0 || fstat(root_fd, &st) != 0) {
+    if (root_fd >= 0)
+      close(root_fd);
+    return false;
+  }
+
+  struct Pending {
+    std::uint32_t id;
+    std::string path;
+    dev_t parent_device;
+  };
+  std::vector<Pending> stack{{0, std::string(), st.st_dev}};
+  std::set<std::pair<dev_t, ino_t>> visited;
+  entries_.push_back({kNoParent, intern(""), 0, 0, 1});
+
+  std::vector<DirEntry> batch;
+  std::vector<Pending> subdirs;
+  while (!stack.empty()) {
+    auto dir = std::move(stack.back());
+    stack.pop_back();
+
+    DirReader reader(root_fd, dir.path.empty() ? "." : dir.path.c_str());
+    if (!reader.is_open() || fstat(reader.fd(), &st) != 0)
+      continue;
+    if (st.st_dev != dir.parent_device && is_pseudo_filesystem(reader.fd()))
+      continue;
+    if (!visited.emplace(st.st_dev, st.st_ino).second)
+      continue;
+
+    auto first = static_cast<std::uint32_t>(entries_.size());
+    std::string prefix = dir.path.empty() ? std::string() : dir.path + '/';
+    subdirs.clear();
+    while (reader.read(batch)) {
+      for (const auto &e : batch) {
+        if (e.kind == EntryKind::Other)
+          continue;
+        bool is_directory = e.kind == EntryKind::Directory;
+        auto id = static_cast<std::uint32_t>(entries_.size());
+        entries_.push_back({dir.id, intern(e.name), 0, 0, is_directory});
+        if (is_directory && !e.is_symlink)
+          subdirs.push_back({id, prefix + std::string(e.name), st.st_dev});
+      }
+    }
+    entries_[dir.id].first_child = first;
+    entries_[dir.id].child_count =
+        static_cast<std::uint32_t>(entries_.size()) - first;
+    stack.insert(stack.end(), std::make_move_iterator(subdirs.rbegin()),
+                 std::make_move_iterator(subdirs.rend()));
+  }
+  close(root_fd);
+  return true;
+}
+
+bool IndexBuilder::write(const std::string &file, std::int64_t built_at) const {
+  auto name_count = static_cast<std::uint32_t>(name_offsets_.size());
+  auto entry_count = static_cast<std::uint32_t>(entries_.size());
+
+  // Entry ids grouped by name
+  std::vector<std::uint32_t> name_entries(name_count + 1, 0);
+  for (const auto &e : entries_)
+    name_entries[e.name + 1]++;
+  for (std::uint32_t i = 0; i < name_count; i++)
+    name_entries[i + 1] += name_entries[i];
+  std::vector<std::uint32_t> entry_ids(entry_count);
+  {
+    auto cursor = name_entries;
+    for (std::uint32_t id = 0; id < entry_count; id++)
+      entry_ids[cursor[entries_[id].name]++] = id;
+  }
+
+  // Trigram postings, counted first so they can be filled in place
+  auto name_at = [this](std::uint32_t id) {
+    return std::string_view(names_.data() + name_offsets_[id]);
+  };
+  std::unordered_map<std::uint32_t, std::uint32_t> counts;
+  std::vector<std::uint32_t> keys;
+  for (std::uint32_t id = 0; id < name_count; id++) {
+    name_trigrams(name_at(id), keys);
+    for (auto key : keys)
+      counts[key]++;
+  }
+  std::vector<FileTrigram> trigrams;
+  trigrams.reserve(counts.size());
+  for (auto [key, count] : counts)
+    trigrams.push_back({key, count, 0});
+  std::sort(trigrams.begin(), trigrams.end(),
+            [](const FileTrigram &a, const FileTrigram &b) {
+              return a.key < b.key;
+            });
+  std::unordered_map<std::uint32_t, std::size_t> slot_of;
+  std::vector<std::size_t> starts(trigrams.size() + 1, 0);
+  for (std::size_t i = 0; i < trigrams.size(); i++) {
+    slot_of[trigrams[i].key] = i;
+    starts[i + 1] = starts[i] + trigrams[i].count;
+  }
+  std::vector<std::uint32_t> raw(starts.back());
+  {
+    auto cursor = starts;
+    for (std::uint32_t id = 0; id < name_count; id++) {
+      name_trigrams(name_at(id), keys);
+      for (auto key : keys)
+        raw[cursor[slot_of[key]]++] = id;
+    }
+  }
+  std::string postings;
+  for (std::size_t i = 0; i < trigrams.size(); i++) {
+    trigrams[i].offset = postings.size();
+    std::uint32_t previous = 0;
+    for (std::size_t j = starts[i]; j < starts[i + 1]; j++) {
+      put_varint(postings, raw[j] - previous);
+      previous = raw[j];
+    }
+  }
+  std::vector<std::uint32_t> name_offsets = name_offsets_;
+  name_offsets.push_back(static_cast<std::uint32_t>(names_.size()));
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.root_length = static_cast<std::uint32_t>(root_.size());
+  header.built_at = built_at;
+  header.entry_count = entry_count;
+  header.name_count = name_count;
+  header.trigram_count = static_cast<std::uint32_t>(trigrams.size());
+
+  std::uint64_t offset = sizeof(FileHeader);
+  auto place = [&offset](std::uint64_t &field, std::size_t bytes) {
+    offset = (offset + 7) & ~std::uint64_t(7);
+    field = offset;
+    offset += bytes;
+  };
+  place(header.root_offset, root_.size());
+  place(header.entries_offset, entries_.size() * sizeof(FileEntry));
+  place(header.name_offsets_offset,
+        name_offsets.size() * sizeof(std::uint32_t));
+  place(header.names_offset, names_.size());
+  place(header.name_entries_offset,
+        name_entries.size() * sizeof(std::uint32_t));
+  place(header.entry_ids_offset, entry_ids.size() * sizeof(std::uint32_t));
+  place(header.trigrams_offset, trigrams.size() * sizeof(FileTrigram));
+  place(header.postings_offset, postings.size());
+  header.file_size = offset;
+
+  // Written next to the old index and renamed over it, so a search never
+  // maps a half written file
+  std::string temp = file + ".tmp";
+  std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+  std::uint64_t written = 0;
+  auto emit = [&](std::uint64_t at, const void *data, std::size_t bytes) {
+    static const char zeros[8] = {};
+    out.write(zeros, static_cast<std::streamsize>(at - written));
+    out.write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(bytes));
+    written = at + bytes;
+  };
+  emit(0, &header, sizeof(header));
+  emit(header.root_offset, root_.data(), root_.size());
+  emit(header.entries_offset, entries_.data(),
+       entries_.size() * sizeof(FileEntry));
+  emit(header.name_offsets_offset, name_offsets.data(),
+       name_offsets.size() * sizeof(std::uint32_t));
+  emit(header.names_offset, names_.data(), names_.size());
+  emit(header.name_entries_offset, name_entries.data(),
+       name_entries.size() * sizeof(std::uint32_t));
+  emit(header.entry_ids_offset, entry_ids.data(),
+       entry_ids.size() * sizeof(std::uint32_t));
+  emit(header.trigrams_offset, trigrams.data(),
+       trigrams.size() * sizeof(FileTrigram));
+  emit(header.postings_offset, postings.data(), postings.size());
+  out.close();
+
+  if (!out || std::rename(temp.c_str(), file.c_str()) != 0) {
+    std::cerr << file << ": " << std::strerror(errno) << '\n';
+    std::remove(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+// A read-only view of an index file. Everything points into the mapping.
+class IndexMap {
+public:
+  static std::shared_ptr<const IndexMap> open(const std::string &file);
+  ~IndexMap() { munmap(data_, size_); }
+
+  IndexMap(const IndexMap &) = delete;
+  IndexMap &operator=(const IndexMap &) = delete;
+
+  std::string_view root() const {
+    return {data_ + header().root_offset, header().root_length};
+  }
+  std::int64_t built_at() const { return header().built_at; }
+  const FileEntry &entry(std::uint32_t id) const { return entries_[id]; }
+  std::string_view name(std::uint32_t name_id) const {
+    return {names_ + name_offsets_[name_id],
+            name_offsets_[name_id + 1] - name_offsets_[name_id] - 1};
+  }
+  std::span<const std::uint32_t> entries_named(std::uint32_t name_id) const {
+    return {entry_ids_ + name_entries_[name_id],
+            entry_ids_ + name_entries_[name_id + 1]};
+  }
+
+  // Entry id of `relative`, a path below the root
+  std::optional<std::uint32_t> find(std::string_view relative) const;
+  // Ids of the names that can contain the query; all names when the query
+  // has no usable trigram
+  std::vector<std::uint32_t> candidates(const NameMatcher &matcher) const;
+
+private:
+  IndexMap(char *data, std::size_t size) : data_(data), size_(size) {}
+
+  const FileHeader &header() const {
+    return *reinterpret_cast<const FileHeader *>(data_);
+  }
+  template <typename T> const T *section(std::uint64_t offset) const {
+    return reinterpret_cast<const T *>(data_ + offset);
+  }
+  std::vector<std::uint32_t> postings(const FileTrigram &trigram) const;
+
+  char *data_;
+  std::size_t size_;
+  const FileEntry *entries_ = nullptr;
+  const std::uint32_t *name_offsets_ = nullptr;
+  const char *names_ = nullptr;
+  const std::uint32_t *name_entries_ = nullptr;
+  const std::uint32_t *entry_ids_ = nullptr;
+  const FileTrigram *trigrams_ = nullptr;
+  const unsigned char *postings_ = nullptr;
+};
+
+std::shared_ptr<const IndexMap> IndexMap::open(const std::string &file) {
+  int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  std::shared_ptr<IndexMap> map(
+      new IndexMap(static_cast<char *>(data), st.st_size));
+  const auto &h = map->header();
+  // A damaged file is rejected here and rebuilt, never read past its end
+  auto fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+    return offset % 8 == 0 && offset <= h.file_size &&
+           bytes <= h.file_size - offset;
+  };
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+      h.version != kFormatVersion ||
+      h.file_size != static_cast<std::uint64_t>(st.st_size) ||
+      !fits(h.root_offset, h.root_length) ||
+      !fits(h.entries_offset, std::uint64_t(h.entry_count) * sizeof(FileEntry)) ||
+      !fits(h.name_offsets_offset, (h.name_count + 1ull) * 4) ||
+      !fits(h.name_entries_offset, (h.name_count + 1ull) * 4) ||
+      !fits(h.entry_ids_offset, std::uint64_t(h.entry_count) * 4) ||
+      !fits(h.trigrams_offset,
+            std::uint64_t(h.trigram_count) * sizeof(FileTrigram)) ||
+      !fits(h.postings_offset, 0) || h.entry_count == 0)
+    return nullptr;
+
+  // Each name has to end in its NUL inside the names section, and every
+  // entry has to point at a name and stay inside the entries
+  auto *name_offsets = map->section<std::uint32_t>(h.name_offsets_offset);
+  auto *names = map->section<char>(h.names_offset);
+  if (name_offsets[0] != 0 ||
+      !fits(h.names_offset, name_offsets[h.name_count]))
+    return nullptr;
+  for (std::uint32_t i = 0; i < h.name_count; i++) {
+    if (name_offsets[i] >= name_offsets[i + 1] ||
+        names[name_offsets[i + 1] - 1] != '\0')
+      return nullptr;
+  }
+  auto *entries = map->section<FileEntry>(h.entries_offset);
+  for (std::uint32_t i = 0; i < h.entry_count; i++) {
+    const auto &e = entries[i];
+    // Parents come before their children, so walking up always ends
+    if (e.name >= h.name_count ||
+        (i == 0 ? e.parent != kNoParent : e.parent >= i) ||
+        e.first_child > h.entry_count ||
+        e.child_count > h.entry_count - e.first_child)
+      return nullptr;
+  }
+  auto *name_entries = map->section<std::uint32_t>(h.name_entries_offset);
+  auto *entry_ids = map->section<std::uint32_t>(h.entry_ids_offset);
+  if (name_entries[0] != 0 || name_entries[h.name_count] != h.entry_count)
+    return nullptr;
+  for (std::uint32_t i = 0; i < h.name_count; i++)
+    if (name_entries[i] > name_entries[i + 1])
+      return nullptr;
+  for (std::uint32_t i = 0; i < h.entry_count; i++)
+    if (entry_ids[i] >= h.entry_count)
+      return nullptr;
+  auto *trigrams = map->section<FileTrigram>(h.trigrams_offset);
+  std::uint64_t postings_size = h.file_size - h.postings_offset;
+  for (std::uint32_t i = 0; i < h.trigram_count; i++)
+    if (trigrams[i].offset > postings_size)
+      return nullptr;
+
+  map->entries_ = entries;
+  map->name_offsets_ = name_offsets;
+  map->names_ = names;
+  map->name_entries_ = name_entries;
+  map->entry_ids_ = entry_ids;
+  map->trigrams_ = trigrams;
+  map->postings_ = map->section<unsigned char>(h.postings_offset);
+  // Lookups touch pages all over the file
+  madvise(data, st.st_size, MADV_RANDOM);
+  return map;
+}
+
+std::optional<std::uint32_t> IndexMap::find(std::string_view relative) const {
+  std::uint32_t id = 0;
+  while (!relative.empty()) {
+    auto slash = relative.find('/');
+    auto component = relative.substr(0, slash);
+    relative = slash == std::string_view::npos ? std::string_view()
+                                               : relative.substr(slash + 1);
+    if (component.empty())
+      continue;
+
+    const auto &dir = entries_[id];
+    std::optional<std::uint32_t> child;
+    for (std::uint32_t i = 0; i < dir.child_count; i++) {
+      if (name(entries_[dir.first_child + i].name) == component) {
+        child = dir.first_child + i;
+        break;
+      }
+    }
+    if (!child)
+      return std::nullopt;
+    id = *child;
+  }
+  return id;
+}
+
+std::vector<std::uint32_t>
+IndexMap::postings(const FileTrigram &trigram) const {
+  std::vector<std::uint32_t> ids;
+  const unsigned char *p = postings_ + trigram.offset;
+  const unsigned char *end =
+      reinterpret_cast<const unsigned char *>(data_) + header().file_size;
+  ids.reserve(std::min<std::size_t>(trigram.count, end - p));
+  std::uint32_t id = 0;
+  for (std::uint32_t i = 0; i < trigram.count; i++) {
+    std::uint32_t delta = 0;
+    for (int shift = 0;; shift += 7) {
+      // A damaged list ends early rather than reading past the file
+      if (p == end || shift > 28)
+        return ids;
+      delta |= std::uint32_t(*p & 0x7f) << shift;
+      if (!(*p++ & 0x80))
+        break;
+    }
+    id += delta;
+    if (id >= header().name_count)
+      return ids;
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+std::vector<std::uint32_t>
+IndexMap::candidates(const NameMatcher &matcher) const {
+  // Non-ASCII characters are case folded differently, only runs of ASCII
+  // in the query narrow the search
+  const auto &query = matcher.folded();
+  std::vector<const FileTrigram *> lists;
+  for (std::size_t i = 0; i + 3 <= query.size(); i++) {
+    if (!matcher.ascii_only() &&
+        std::any_of(query.begin() + i, query.begin() + i + 3, [](char c) {
+          return static_cast<unsigned char>(c) >= 0x80;
+        }))
+      continue;
+    auto key = trigram_key(query.data() + i);
+    const FileTrigram *end = trigrams_ + header().trigram_count;
+    auto it = std::lower_bound(
+        trigrams_, end, key,
+        [](const FileTrigram &t, std::uint32_t k) { return t.key < k; });
+    if (it == end || it->key != key)
+      return {};
+    lists.push_back(it);
+  }
+
+  if (lists.empty()) {
+    std::vector<std::uint32_t> all(header().name_count);
+    for (std::uint32_t i = 0; i < all.size(); i++)
+      all[i] = i;
+    return all;
+  }
+
+  // Intersect starting from the rarest trigram
+  std::sort(lists.begin(), lists.end(),
+            [](const FileTrigram *a, const FileTrigram *b) {
+              return a->count < b->count;
+            });
+  lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+  auto result = postings(*lists[0]);
+  for (std::size_t i = 1; i < lists.size() && !result.empty(); i++) {
+    auto next = postings(*lists[i]);
+    std::vector<std::uint32_t> both;
+    std::set_intersection(result.begin(), result.end(), next.begin(),
+                          next.end(), std::back_inserter(both));
+    result = std::move(both);
+  }
+  return result;
+}
+
+FileIndex &FileIndex::instance() {
+  // A rebuild may still be running on its detached thread at exit, so the
+  // instance is never destroyed
+  static auto *index = new FileIndex();
+  return *index;
+}
+
+void FileIndex::start() {
+  const char *setting = std::getenv("XAFILE_FILE_INDEX");
+  enabled_ = !setting || std::strcmp(setting, "0") != 0;
+  if (!enabled_)
+    return;
+
+  root_ = g_get_home_dir();
+  std::string dir = std::string(g_get_user_cache_dir()) + "/xafile";
+  g_mkdir_with_parents(dir.c_str(), 0700);
+  file_ = dir + "/file-index";
+
+  auto map = IndexMap::open(file_);
+  if (map && map->root() == root_) {
+    std::lock_guard lock(mutex_);
+    map_ = std::move(map);
+  }
+  on_rebuild_timeout(this);
+  g_timeout_add_seconds(kStaleCheckInterval, on_rebuild_timeout, this);
+}
+
+gboolean FileIndex::on_rebuild_timeout(gpointer user_data) {
+  auto *self = static_cast<FileIndex *>(user_data);
+  auto map = self->snapshot();
+  std::int64_t now = g_get_real_time() / G_USEC_PER_SEC;
+  if (!map || now - map->built_at() > kMaxAge)
+    self->rebuild();
+  return G_SOURCE_CONTINUE;
+}
+
+std::shared_ptr<const IndexMap> FileIndex::snapshot() const {
+  std::lock_guard lock(mutex_);
+  return map_;
+}
+
+void FileIndex::rebuild() {
+  if (building_.exchange(true))
+    return;
+
+  std::thread([this] {
+    lower_thread_priority();
+    std::int64_t built_at = g_get_real_time() / G_USEC_PER_SEC;
+    IndexBuilder builder(root_);
+    if (builder.build() && builder.write(file_, built_at)) {
+      if (auto map = IndexMap::open(file_))
+        install(std::move(map));
+    }
+    building_ = false;
+  }).detach();
+}
+
+void FileIndex::install(std::shared_ptr<const IndexMap> map) {
+  std::lock_guard lock(mutex_);
+  map_ = std::move(map);
+}
+
+bool FileIndex::covers(const std::string &directory) const {
+  auto map = snapshot();
+  if (!map)
+    return false;
+  auto relative = relative_to(directory, map->root());
+  if (!relative)
+    return false;
+  auto id = map->find(*relative);
+  return id && map->entry(*id).is_directory;
+}
+
+bool FileIndex::search(const std::string &root, const NameMatcher &matcher,
+                       const BatchCallback &on_batch,
+                       const std::atomic<bool> &cancelled,
+                       std::vector<StaleDir> &stale) const {
+  auto map = snapshot();
+  if (!map)
+    return false;
+  auto relative = relative_to(root, map->root());
+  if (!relative)
+    return false;
+  auto root_id = map->find(*relative);
+  if (!root_id || !map->entry(*root_id).is_directory)
+    return false;
+  int root_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (root_fd < 0)
+    return false;
+
+  // A directory changed at or after the build may have entries the index
+  // lacks or no longer has. Unlike the mtime, the ctime cannot be set back.
+  std::unordered_set<std::uint32_t> changed, gone;
+  struct Pending {
+    std::uint32_t id;
+    std::string path;
+  };
+  std::vector<Pending> stack{{*root_id, std::string()}};
+  while (!stack.empty()) {
+    if (cancelled.load(std::memory_order_relaxed)) {
+      close(root_fd);
+      return true;
+    }
+    auto dir = std::move(stack.back());
+    stack.pop_back();
+    struct stat st;
+    if (fstatat(root_fd, dir.path.empty() ? "." : dir.path.c_str(), &st,
+                AT_SYMLINK_NOFOLLOW) != 0 ||
+        !S_ISDIR(st.st_mode)) {
+      // Its parent changed as well and is read from disk
+      gone.insert(dir.id);
+      continue;
+    }
+
+    const auto &e = map->entry(dir.id);
+    bool is_stale = std::max(st.st_ctim.tv_sec, st.st_mtim.tv_sec) >=
+                    map->built_at();
+    if (is_stale)
+      changed.insert(dir.id);
+    StaleDir record{dir.path, {}};
+    std::string prefix = dir.path.empty() ? std::string() : dir.path + '/';
+    for (std::uint32_t i = 0; i < e.child_count; i++) {
+      auto child = e.first_child + i;
+      if (!map->entry(child).is_directory)
+        continue;
+      auto name = map->name(map->entry(child).name);
+      if (is_stale)
+        record.indexed.emplace(name);
+      stack.push_back({child, prefix + std::string(name)});
+    }
+    if (is_stale)
+      stale.push_back(std::move(record));
+  }
+
+  auto &types = ContentTypeDetector::instance();
+  Listing batch;
+  auto add = [&](std::string_view path, std::string_view name,
+                 bool is_directory) {
+    auto &entry = batch[batch.add(path, is_directory)];
+    if (!is_directory) {
+      if (auto type = types.from_name(name)) {
+        entry.content_type = type->content_type;
+        entry.type = type->description;
+        entry.icon = type->icon;
+      }
+    }
+    if (batch.size() >= kMaxBatch) {
+      on_batch(std::move(batch));
+      batch = Listing();
+    }
+  };
+
+  std::vector<std::uint32_t> chain;
+  std::string path;
+  for (auto name_id : map->candidates(matcher)) {
+    if (cancelled.load(std::memory_order_relaxed))
+      break;
+    auto name = map->name(name_id);
+    if (!matcher.matches(name))
+      continue;
+
+    for (auto id : map->entries_named(name_id)) {
+      // Entries of changed directories come from disk
+      if (changed.count(map->entry(id).parent))
+        continue;
+      // Walk up to the search root; entries elsewhere never reach it
+      chain.clear();
+      std::uint32_t up = id;
+      bool skip = false;
+      while (up != *root_id && up != kNoParent) {
+        if (gone.count(up)) {
+          skip = true;
+          break;
+        }
+        chain.push_back(up);
+        up = map->entry(up).parent;
+      }
+      if (skip || up != *root_id || chain.empty())
+        continue;
+
+      path.clear();
+      for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!path.empty())
+          path += '/';
+        path += map->name(map->entry(*it).name);
+      }
+      // Directory times can lag behind on network filesystems, so each
+      // hit is looked at as well
+      bool is_directory = map->entry(id).is_directory;
+      struct stat st;
+      if (fstatat(root_fd, path.c_str(), &st, 0) != 0 ||
+          S_ISDIR(st.st_mode) != is_directory)
+        continue;
+      add(path, name, is_directory);
+    }
+  }
+  close(root_fd);
+
+  if (!batch.empty() && !cancelled.load(std::memory_order_relaxed))
+    on_batch(std::move(batch));
+  return true;
+}
+
+} // namespace xafile
@@ -0,0 +1,100 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "search_job.hpp"
+#include "utility/listing.hpp"
+#include <glib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+class IndexMap;
+
+// A filename index of the home directory, kept in
+// ~/.cache/xafile/file-index and memory-mapped as is, so a cold start costs
+// one mmap and no parsing. Names are deduplicated and found through a
+// trigram table over their ASCII-folded bytes; each entry records its
+// parent, so paths are rebuilt from the matches alone.
+//
+// The index is rebuilt on a background thread at idle I/O priority when it
+// is missing or older than a few hours. In between, a search stats the
+// indexed directories below its root: entries of directories that changed
+// since the build are read from disk instead, and every hit is checked to
+// still be there. XAFILE_FILE_INDEX=0 turns the index off.
+class FileIndex {
+public:
+  using BatchCallback = std::function<void(Listing &&)>;
+
+  // A directory whose entries changed since the index was built. Search
+  // results leave them out, they have to be read from disk; of its
+  // subdirectories only those missing from the index need a walk.
+  struct StaleDir {
+    std::string path; // relative to the search root, empty for the root
+    std::unordered_set<std::string> indexed; // subdirectories in the index
+  };
+
+  static FileIndex &instance();
+
+  // Maps the stored index and schedules a rebuild if it is stale. Call once
+  // from the main thread.
+  void start();
+
+  // Whether `directory` is inside the indexed tree, so a search below it
+  // can be answered from the index
+  bool covers(const std::string &directory) const;
+
+  // Streams every indexed entry below `root` whose name matches and that
+  // still exists, named by its path relative to `root`. Directories that
+  // changed since the build are added to `stale` for the caller to read.
+  // Returns false without calling `on_batch` if `root` is not covered. Safe
+  // to call from any thread.
+  bool search(const std::string &root, const NameMatcher &matcher,
+              const BatchCallback &on_batch,
+              const std::atomic<bool> &cancelled,
+              std::vector<StaleDir> &stale) const;
+
+private:
+  FileIndex() = default;
+
+  std::shared_ptr<const IndexMap> snapshot() const;
+  void rebuild();
+  void install(std::shared_ptr<const IndexMap> map);
+  static gboolean on_rebuild_timeout(gpointer user_data);
+
+  std::string root_;
+  std::string file_;
+  bool enabled_ = false;
+  std::atomic<bool> building_{false};
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<const IndexMap> map_;
+};
+
+} // namespace xafile
@@ -0,0 +1,628 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_list_model.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+// Items only point at their entry; the name and metadata live in the
+// listing so an item costs one small allocation.
+struct _FileItemObject {
+  GObject parent_instance;
+  std::shared_ptr<const Listing> listing;
+  guint index;
+};
+
+G_DEFINE_TYPE(FileItemObject, file_item, G_TYPE_OBJECT)
+
+enum { ITEM_CHANGED, N_ITEM_SIGNALS };
+static guint item_signals[N_ITEM_SIGNALS];
+
+static void file_item_finalize(GObject *object) {
+  FileItemObject *self = FILE_ITEM(object);
+  self->listing.~shared_ptr();
+  G_OBJECT_CLASS(file_item_parent_class)->finalize(object);
+}
+
+static void file_item_class_init(FileItemObjectClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  object_class->finalize = file_item_finalize;
+
+  // Emitted when the entry's metadata changed and bound rows should redraw
+  item_signals[ITEM_CHANGED] =
+      g_signal_new("changed", G_TYPE_FROM_CLASS(klass), G_SIGNAL_RUN_LAST, 0,
+                   nullptr, nullptr, nullptr, G_TYPE_NONE, 0);
+}
+
+static void file_item_init(FileItemObject *self) {
+  new (&self->listing) std::shared_ptr<const Listing>();
+  self->index = 0;
+}
+
+static FileItemObject *file_item_new(std::shared_ptr<const Listing> listing,
+                                     guint index) {
+  FileItemObject *item = FILE_ITEM(g_object_new(FILE_ITEM_TYPE, nullptr));
+  item->listing = std::move(listing);
+  item->index = index;
+  return item;
+}
+
+const ListingEntry &file_item_entry(FileItemObject *item) {
+  return (*item->listing)[item->index];
+}
+
+const char *file_item_get_name(FileItemObject *item) {
+  return item->listing->c_name(file_item_entry(item));
+}
+
+bool file_item_is_directory(FileItemObject *item) {
+  return file_item_entry(item).is_directory;
+}
+
+const char *file_item_get_icon_name(FileItemObject *item) {
+  return atom_string(file_item_entry(item).icon);
+}
+
+const char *file_item_get_file_type(FileItemObject *item) {
+  return atom_string(file_item_entry(item).type);
+}
+
+// Size and modified time are kept as integers and only turned into text
+// when a row is bound.
+char *file_item_format_size(FileItemObject *item) {
+  const auto &e = file_item_entry(item);
+  if (e.is_directory || !e.has_metadata)
+    return g_strdup("--");
+  return g_format_size(e.size);
+}
+
+char *file_item_format_modified(FileItemObject *item) {
+  const auto &e = file_item_entry(item);
+  if (!e.has_metadata)
+    return g_strdup("--");
+
+  GDateTime *modified = g_date_time_new_from_unix_local(e.mtime);
+  GDateTime *now = g_date_time_new_now_local();
+  int y, m, d, now_y, now_m, now_d;
+  g_date_time_get_ymd(modified, &y, &m, &d);
+  g_date_time_get_ymd(now, &now_y, &now_m, &now_d);
+
+  const char *format = "%e %b %Y";
+  if (y == now_y && m == now_m && d == now_d)
+    format = "Today %H:%M";
+  else if (y == now_y)
+    format = "%e %b";
+  char *text = g_date_time_format(modified, format);
+
+  g_date_time_unref(now);
+  g_date_time_unref(modified);
+  return text;
+}
+
+// Up to this many changes are reported one row at a time, which keeps the
+// selection and scroll position of unrelated rows. Bigger bursts are merged
+// in one pass and reported as a single range.
+static constexpr std::size_t kMaxExactDiffs = 32;
+
+// Entries whose rows went away stay in the listing. Once there are more of
+// them than this, or than live ones, the live ones move to a new listing.
+static constexpr std::size_t kMaxDeadEntries = 4096;
+
+struct _FileListModel {
+  GObject parent_instance;
+  std::shared_ptr<const Listing> listing;
+  // The same listing while nobody else holds it; null once it was handed
+  // out, and the next change is made to a copy
+  std::shared_ptr<Listing> owned;
+  // Row position -> entry index in the listing
+  std::vector<std::uint32_t> order;
+  SortOrder sort;
+  // Entry index -> item currently referenced by a view, not owned
+  std::unordered_map<guint32, FileItemObject *> live;
+  std::function<void(std::uint32_t)> item_requested;
+};
+
+static GType file_list_model_get_item_type(GListModel *) {
+  return FILE_ITEM_TYPE;
+}
+
+static guint file_list_model_get_n_items(GListModel *model) {
+  return FILE_LIST_MODEL(model)->order.size();
+}
+
+static void on_item_finalized(gpointer data, GObject *where_the_object_was) {
+  auto *self = static_cast<FileListModel *>(data);
+  self->live.erase(
+      reinterpret_cast<FileItemObject *>(where_the_object_was)->index);
+}
+
+static FileItemObject *item_for_entry(FileListModel *self, guint32 index) {
+  if (auto it = self->live.find(index); it != self->live.end())
+    return static_cast<FileItemObject *>(g_object_ref(it->second));
+
+  if (self->item_requested)
+    self->item_requested(index);
+
+  auto *item = file_item_new(self->listing, index);
+  g_object_weak_ref(G_OBJECT(item), on_item_finalized, self);
+  self->live.emplace(index, item);
+  return item;
+}
+
+static gpointer file_list_model_get_item(GListModel *model, guint position) {
+  auto *self = FILE_LIST_MODEL(model);
+  if (position >= self->order.size())
+    return nullptr;
+  return item_for_entry(self, self->order[position]);
+}
+
+static void file_list_model_list_model_init(GListModelInterface *iface) {
+  iface->get_item_type = file_list_model_get_item_type;
+  iface->get_n_items = file_list_model_get_n_items;
+  iface->get_item = file_list_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE(FileListModel, file_list_model, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL,
+                                              file_list_model_list_model_init))
+
+// Items that outlive a listing keep their own reference to it, they just
+// stop being handed out again.
+static void forget_live_items(FileListModel *self) {
+  for (auto &[index, item] : self->live)
+    g_object_weak_unref(G_OBJECT(item), on_item_finalized, self);
+  self->live.clear();
+}
+
+// A listing handed to ListingCache, a saved snapshot, a metadata loader or
+// another window is never changed again. The first change after that is
+// made to a copy, and the live items move over to it.
+static Listing &writable_listing(FileListModel *self) {
+  if (!self->owned) {
+    self->owned = std::make_shared<Listing>(*self->listing);
+    self->listing = self->owned;
+    for (auto &[index, item] : self->live)
+      item->listing = self->listing;
+  }
+  return *self->owned;
+}
+
+// Refreshes the rows bound to an entry without touching the row layout,
+// so selection and focus survive.
+static void notify_item_changed(FileListModel *self, std::uint32_t index) {
+  if (auto it = self->live.find(index); it != self->live.end())
+    g_signal_emit(it->second, item_signals[ITEM_CHANGED], 0);
+}
+
+static void file_list_model_finalize(GObject *object) {
+  FileListModel *self = FILE_LIST_MODEL(object);
+  forget_live_items(self);
+  self->listing.~shared_ptr();
+  self->owned.~shared_ptr();
+  self->order.~vector();
+  self->live.~unordered_map();
+  self->item_requested.~function();
+  G_OBJECT_CLASS(file_list_model_parent_class)->finalize(object);
+}
+
+static void file_list_model_class_init(FileListModelClass *klass) {
+  GObjectClass *object_class = G_OBJECT_CLASS(klass);
+  object_class->finalize = file_list_model_finalize;
+}
+
+static void file_list_model_init(FileListModel *self) {
+  new (&self->owned) std::shared_ptr<Listing>(std::make_shared<Listing>());
+  new (&self->listing) std::shared_ptr<const Listing>(self->owned);
+  new (&self->order) std::vector<std::uint32_t>();
+  self->sort = SortOrder();
+  new (&self->live) std::unordered_map<guint32, FileItemObject *>();
+  new (&self->item_requested) std::function<void(std::uint32_t)>();
+}
+
+FileListModel *file_list_model_new() {
+  return FILE_LIST_MODEL(g_object_new(FILE_LIST_MODEL_TYPE, nullptr));
+}
+
+void file_list_model_clear(FileListModel *self) {
+  guint removed = self->order.size();
+  forget_live_items(self);
+  self->owned = std::make_shared<Listing>();
+  self->listing = self->owned;
+  self->order.clear();
+  if (removed > 0)
+    g_list_model_items_changed(G_LIST_MODEL(self), 0, removed, 0);
+}
+
+void file_list_model_set_listing(FileListModel *self,
+                                 std::shared_ptr<const Listing> listing,
+                                 std::vector<std::uint32_t> order) {
+  guint removed = self->order.size();
+  forget_live_items(self);
+  self->listing = std::move(listing);
+  self->owned.reset();
+  self->order = std::move(order);
+  if (removed > 0 || !self->order.empty())
+    g_list_model_items_changed(G_LIST_MODEL(self), 0, removed,
+                               self->order.size());
+}
+
+const Listing &file_list_model_get_listing(FileListModel *self) {
+  return *self->listing;
+}
+
+std::shared_ptr<const Listing>
+file_list_model_share_listing(FileListModel *self) {
+  self->owned.reset();
+  return self->listing;
+}
+
+const std::vector<std::uint32_t> &
+file_list_model_get_order(FileListModel *self) {
+  return self->order;
+}
+
+void file_list_model_append(FileListModel *self, const Listing &entries,
+                            std::size_t begin, std::size_t end) {
+  guint position = self->order.size();
+  auto &listing = writable_listing(self);
+  for (std::size_t i = begin; i < end; i++)
+    self->order.push_back(listing.add(entries, entries[i]));
+  if (end > begin)
+    g_list_model_items_changed(G_LIST_MODEL(self), position, 0, end - begin);
+}
+
+void file_list_model_sort(FileListModel *self) {
+  sort_entries(*self->listing, self->order, self->sort);
+
+  guint n = self->order.size();
+  if (n > 0)
+    g_list_model_items_changed(G_LIST_MODEL(self), 0, n, n);
+}
+
+void file_list_model_set_sort(FileListModel *self, SortOrder sort) {
+  if (self->sort == sort)
+    return;
+  self->sort = sort;
+  file_list_model_sort(self);
+}
+
+SortOrder file_list_model_get_sort(FileListModel *self) { return self->sort; }
+
+// Rows of the given entries. A binary search finds most of them; while
+// metadata is still arriving a size or date order can be out of date, and
+// the rest are found in a single pass over the rows.
+static std::vector<std::size_t>
+rows_of(FileListModel *self, const EntryOrder &less,
+        const std::vector<std::uint32_t> &indices) {
+  const auto &order = self->order;
+  std::vector<std::size_t> rows;
+  std::unordered_set<std::uint32_t> missing;
+  for (auto index : indices) {
+    auto pos = std::lower_bound(order.begin(), order.end(), index, less) -
+               order.begin();
+    if (pos < std::ptrdiff_t(order.size()) && order[pos] == index)
+      rows.push_back(pos);
+    else
+      missing.insert(index);
+  }
+  for (std::size_t pos = 0; !missing.empty() && pos < order.size(); pos++) {
+    if (missing.erase(order[pos]))
+      rows.push_back(pos);
+  }
+  return rows;
+}
+
+// Looks the updated names up: a binary search each when rows are ordered by
+// name, one pass over the rows otherwise.
+static std::vector<std::optional<std::uint32_t>>
+find_entries(FileListModel *self, const std::vector<EntryUpdate> &updates) {
+  const auto &listing = *self->listing;
+  std::vector<std::optional<std::uint32_t>> found(updates.size());
+
+  if (self->sort.field != SortField::Name) {
+    std::unordered_map<std::string_view, std::size_t> wanted;
+    for (std::size_t i = 0; i < updates.size(); i++)
+      wanted.emplace(updates[i].name, i);
+    for (auto index : self->order) {
+      auto it = wanted.find(listing.name(listing[index]));
+      if (it != wanted.end())
+        found[it->second] = index;
+    }
+    return found;
+  }
+
+  bool descending = self->sort.descending;
+  for (std::size_t i = 0; i < updates.size(); i++) {
+    std::string_view name = updates[i].name;
+    auto key = Listing::collation_key(name);
+    for (bool is_directory : {true, false}) {
+      auto it = std::partition_point(
+          self->order.begin(), self->order.end(), [&](std::uint32_t index) {
+            const auto &e = listing[index];
+            if (e.is_directory != is_directory)
+              return e.is_directory;
+            auto c = listing.key(e).compare(key);
+            if (c == 0)
+              c = listing.name(e).compare(name);
+            return descending ? c > 0 : c < 0;
+          });
+      if (it != self->order.end() &&
+          listing[*it].is_directory == is_directory &&
+          listing.name(listing[*it]) == name) {
+        found[i] = *it;
+        break;
+      }
+    }
+  }
+  return found;
+}
+
+// Whether a metadata change moves the entry under the current sort
+static bool sort_key_changed(SortOrder sort, const ListingEntry &before,
+                             const ListingEntry &after) {
+  switch (sort.field) {
+  case SortField::Name:
+    return false;
+  case SortField::Size:
+    return before.size != after.size;
+  case SortField::Type:
+    return before.type != after.type;
+  case SortField::Modified:
+    return before.mtime != after.mtime;
+  }
+  return false;
+}
+
+static void set_metadata(ListingEntry &e, const EntryUpdate &update) {
+  e.size = update.size;
+  e.mtime = update.mtime;
+  e.has_metadata = true;
+  if (update.type.content_type != atoms::kNone) {
+    e.content_type = update.type.content_type;
+    e.type = update.type.description;
+    e.icon = update.type.icon;
+  } else if (!update.is_directory) {
+    // Not settled by the name; the old type is shown until it is sniffed
+    e.content_type = atoms::kNone;
+  }
+}
+
+static void apply_exact(FileListModel *self,
+                        const std::vector<std::uint32_t> &removed,
+                        const std::vector<std::uint32_t> &added) {
+  // Made once per batch, ranking types walks the whole listing
+  EntryOrder less(*self->listing, self->sort);
+
+  auto rows = rows_of(self, less, removed);
+  // Bottom up, so the rows still to be removed stay where they are
+  std::sort(rows.begin(), rows.end(), std::greater<>());
+  for (auto pos : rows) {
+    self->order.erase(self->order.begin() + pos);
+    g_list_model_items_changed(G_LIST_MODEL(self), pos, 1, 0);
+  }
+  for (auto index : added) {
+    auto pos = std::lower_bound(self->order.begin(), self->order.end(), index,
+                                less) -
+               self->order.begin();
+    self->order.insert(self->order.begin() + pos, index);
+    g_list_model_items_changed(G_LIST_MODEL(self), pos, 0, 1);
+  }
+}
+
+static void apply_merged(FileListModel *self,
+                         std::vector<std::uint32_t> &removed,
+                         std::vector<std::uint32_t> &added) {
+  EntryOrder less(*self->listing, self->sort);
+
+  std::sort(removed.begin(), removed.end());
+  std::sort(added.begin(), added.end(), less);
+
+  std::vector<std::uint32_t> kept;
+  kept.reserve(self->order.size());
+  for (auto index : self->order) {
+    if (!std::binary_search(removed.begin(), removed.end(), index))
+      kept.push_back(index);
+  }
+
+  std::vector<std::uint32_t> merged;
+  merged.reserve(kept.size() + added.size());
+  std::merge(kept.begin(), kept.end(), added.begin(), added.end(),
+             std::back_inserter(merged), less);
+
+  const auto &old_order = self->order;
+  std::size_t old_n = old_order.size();
+  std::size_t new_n = merged.size();
+  std::size_t first = 0;
+  while (first < old_n && first < new_n && old_order[first] == merged[first])
+    first++;
+  std::size_t suffix = 0;
+  while (suffix < old_n - first && suffix < new_n - first &&
+         old_order[old_n - 1 - suffix] == merged[new_n - 1 - suffix])
+    suffix++;
+  self->order = std::move(merged);
+
+  if (first == old_n && first == new_n)
+    return;
+  g_list_model_items_changed(G_LIST_MODEL(self), first,
+                             old_n - suffix - first, new_n - suffix - first);
+}
+
+// Drops the entries no row shows, or is about to, if there are too many.
+// Entries keep their relative order, so views that made the same changes
+// to the same listing number them alike. Indices in `removed` and `added`
+// are renumbered; returns whether anything was.
+static bool compact(FileListModel *self, std::vector<std::uint32_t> &removed,
+                    std::vector<std::uint32_t> &added) {
+  const auto &old = *self->listing;
+  std::vector<bool> shown(old.size());
+  std::size_t live = 0;
+  for (const auto *indices : {&self->order, &added}) {
+    for (auto index : *indices) {
+      live += !shown[index];
+      shown[index] = true;
+    }
+  }
+  std::size_t dead = old.size() - live;
+  if (dead <= kMaxDeadEntries && dead <= live)
+    return false;
+
+  auto listing = std::make_shared<Listing>();
+  listing->reserve(live, old.packed_names().size() * live / old.size());
+  std::vector<std::uint32_t> moved(old.size());
+  for (std::uint32_t i = 0; i < old.size(); i++)
+    if (shown[i])
+      moved[i] = listing->add(old, old[i]);
+  for (auto *indices : {&self->order, &removed, &added})
+    for (auto &index : *indices)
+      index = moved[index];
+
+  // Items of dropped entries keep the old listing, they are just not handed
+  // out again
+  std::unordered_map<guint32, FileItemObject *> items;
+  for (auto &[index, item] : self->live) {
+    if (!shown[index]) {
+      g_object_weak_unref(G_OBJECT(item), on_item_finalized, self);
+      continue;
+    }
+    item->listing = listing;
+    item->index = moved[index];
+    items.emplace(item->index, item);
+  }
+  self->live = std::move(items);
+  self->owned = listing;
+  self->listing = std::move(listing);
+  return true;
+}
+
+bool file_list_model_apply(FileListModel *self,
+                           const std::vector<EntryUpdate> &updates) {
+  std::vector<std::uint32_t> removed;
+  std::vector<std::uint32_t> added;
+  // Whether any row goes away for good, so the rows change either way
+  bool dropped = false;
+
+  auto found = find_entries(self, updates);
+  for (std::size_t i = 0; i < updates.size(); i++) {
+    const auto &u = updates[i];
+    auto current = found[i];
+    // Not kept across iterations, the first change may copy it
+    auto &listing = writable_listing(self);
+    if (current && u.exists &&
+        listing[*current].is_directory == u.is_directory) {
+      auto before = listing[*current];
+      set_metadata(listing[*current], u);
+      if (sort_key_changed(self->sort, before, listing[*current])) {
+        removed.push_back(*current);
+        added.push_back(*current);
+      } else {
+        notify_item_changed(self, *current);
+      }
+      continue;
+    }
+
+    if (current) {
+      removed.push_back(*current);
+      dropped = true;
+    }
+    if (u.exists) {
+      auto index = listing.add(u.name, u.is_directory);
+      set_metadata(listing[index], u);
+      added.push_back(index);
+    }
+  }
+
+  // Done before the rows change, so whoever holds entry indices hears of
+  // the new listing with the change
+  bool renumbered = dropped && compact(self, removed, added);
+  if (removed.size() + added.size() <= kMaxExactDiffs)
+    apply_exact(self, removed, added);
+  else
+    apply_merged(self, removed, added);
+  return renumbered;
+}
+
+void file_list_model_refresh(FileListModel *self, std::string_view name) {
+  const auto &listing = *self->listing;
+  for (auto &[index, item] : self->live) {
+    if (listing.name(listing[index]) == name) {
+      g_signal_emit(item, item_signals[ITEM_CHANGED], 0);
+      break;
+    }
+  }
+}
+
+void file_list_model_refresh_all(FileListModel *self) {
+  for (auto &[index, item] : self->live)
+    g_signal_emit(item, item_signals[ITEM_CHANGED], 0);
+}
+
+void file_list_model_update_metadata(
+    FileListModel *self, const std::vector<MetadataResult> &results) {
+  auto &listing = writable_listing(self);
+  std::vector<std::uint32_t> moved;
+  for (const auto &r : results) {
+    if (r.index >= listing.size())
+      continue;
+    auto &e = listing[r.index];
+    auto before = e;
+    e.size = r.size;
+    e.mtime = r.mtime;
+    e.has_metadata = true;
+    if (r.type.content_type != atoms::kNone) {
+      e.content_type = r.type.content_type;
+      e.type = r.type.description;
+      e.icon = r.type.icon;
+    }
+    if (sort_key_changed(self->sort, before, e))
+      moved.push_back(r.index);
+    else
+      notify_item_changed(self, r.index);
+  }
+  if (moved.empty())
+    return;
+
+  // Rows sorted by size, type or date move as their real values arrive
+  auto removed = moved;
+  if (moved.size() * 2 <= kMaxExactDiffs)
+    apply_exact(self, removed, moved);
+  else
+    apply_merged(self, removed, moved);
+}
+
+FileItemObject *file_list_model_get_item_for_entry(FileListModel *self,
+                                                   std::uint32_t index) {
+  if (index >= self->listing->size())
+    return nullptr;
+  return item_for_entry(self, index);
+}
+
+void file_list_model_set_item_requested_func(
+    FileListModel *self, std::function<void(std::uint32_t)> func) {
+  self->item_requested = std::move(func);
+}
+
+} // namespace xafile
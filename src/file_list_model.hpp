@@ -0,0 +1,101 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "metadata_loader.hpp"
+#include "utility/listing.hpp"
+#include "utility/sort_order.hpp"
+#include <gio/gio.h>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+// The current state of one directory entry, as seen after a change
+struct EntryUpdate {
+  std::string name;
+  bool exists;
+  bool is_directory;
+  std::uint64_t size;
+  std::int64_t mtime;
+  ContentType type; // kNone for directories and files still to be sniffed
+};
+
+// Items emit "changed" when their entry's metadata is updated
+#define FILE_ITEM_TYPE (file_item_get_type())
+G_DECLARE_FINAL_TYPE(FileItemObject, file_item, FILE, ITEM, GObject)
+
+const ListingEntry &file_item_entry(FileItemObject *item);
+const char *file_item_get_name(FileItemObject *item);
+bool file_item_is_directory(FileItemObject *item);
+const char *file_item_get_icon_name(FileItemObject *item);
+const char *file_item_get_file_type(FileItemObject *item);
+char *file_item_format_size(FileItemObject *item);
+char *file_item_format_modified(FileItemObject *item);
+
+// A GListModel over a flat Listing. Rows are only turned into
+// FileItemObjects when a view asks for them, and an item stays shared for as
+// long as something holds a reference to it.
+#define FILE_LIST_MODEL_TYPE (file_list_model_get_type())
+G_DECLARE_FINAL_TYPE(FileListModel, file_list_model, FILE, LIST_MODEL,
+                     GObject)
+
+FileListModel *file_list_model_new();
+void file_list_model_clear(FileListModel *self);
+// Shows an already loaded listing; `order` maps rows to entry indices. The
+// listing is left as it is, changes go to a copy.
+void file_list_model_set_listing(FileListModel *self,
+                                 std::shared_ptr<const Listing> listing,
+                                 std::vector<std::uint32_t> order);
+const Listing &file_list_model_get_listing(FileListModel *self);
+// Hands the listing out to be kept. It is not changed after this; the model
+// copies it before its next change.
+std::shared_ptr<const Listing>
+file_list_model_share_listing(FileListModel *self);
+const std::vector<std::uint32_t> &file_list_model_get_order(FileListModel *self);
+void file_list_model_append(FileListModel *self, const Listing &entries,
+                            std::size_t begin, std::size_t end);
+// Reorders the rows by the current sort order
+void file_list_model_sort(FileListModel *self);
+void file_list_model_set_sort(FileListModel *self, SortOrder sort);
+SortOrder file_list_model_get_sort(FileListModel *self);
+// Inserts, removes, moves or refreshes the rows for the given names. Needs
+// the model to be sorted. Returns true if entries left behind by removed
+// rows were dropped, which renumbers the entries of the listing.
+bool file_list_model_apply(FileListModel *self,
+                           const std::vector<EntryUpdate> &updates);
+// Emits "changed" on the item for `name` if a view holds one
+void file_list_model_refresh(FileListModel *self, std::string_view name);
+// Emits "changed" on every item a view holds
+void file_list_model_refresh_all(FileListModel *self);
+void file_list_model_update_metadata(
+    FileListModel *self, const std::vector<MetadataResult> &results);
+// The shared item for an entry index, whatever row it is in. Returns a new
+// reference, or nullptr if there is no such entry.
+FileItemObject *file_list_model_get_item_for_entry(FileListModel *self,
+                                                   std::uint32_t index);
+// Called with the entry index whenever a view materializes a new item
+void file_list_model_set_item_requested_func(
+    FileListModel *self, std::function<void(std::uint32_t)> func);
+
+} // namespace xafile
@@ -0,0 +1,74 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "icon_cache.hpp"
+
+namespace xafile {
+
+IconCache &IconCache::instance() {
+  static IconCache cache;
+  return cache;
+}
+
+GdkPaintable *IconCache::lookup(Atom icon, int size, int scale) {
+  if (!theme_) {
+    theme_ = gtk_icon_theme_get_for_display(gdk_display_get_default());
+    g_signal_connect(theme_, "changed", G_CALLBACK(on_theme_changed), this);
+  }
+
+  auto key = std::uint64_t(icon) << 32 | std::uint64_t(size) << 8 |
+             static_cast<std::uint8_t>(scale);
+  if (auto it = paintables_.find(key); it != paintables_.end()) {
+    stats_.hits++;
+    return it->second;
+  }
+
+  stats_.misses++;
+  auto *paintable = GDK_PAINTABLE(gtk_icon_theme_lookup_icon(
+      theme_, atom_string(icon), nullptr, size, scale,
+      gtk_widget_get_default_direction(), GtkIconLookupFlags(0)));
+  paintables_.emplace(key, paintable);
+  return paintable;
+}
+
+void IconCache::on_theme_changed(GtkIconTheme *, gpointer user_data) {
+  auto *self = static_cast<IconCache *>(user_data);
+  for (auto &[key, paintable] : self->paintables_)
+    g_object_unref(paintable);
+  self->paintables_.clear();
+  self->stats_.invalidations++;
+  for (const auto &[id, callback] : self->listeners_)
+    callback();
+}
+
+std::size_t IconCache::connect(std::function<void()> callback) {
+  listeners_.emplace_back(next_listener_, std::move(callback));
+  return next_listener_++;
+}
+
+void IconCache::disconnect(std::size_t id) {
+  std::erase_if(listeners_, [id](const auto &l) { return l.first == id; });
+}
+
+IconCache::Stats IconCache::stats() const {
+  Stats stats = stats_;
+  stats.entries = paintables_.size();
+  return stats;
+}
+
+} // namespace xafile
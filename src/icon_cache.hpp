@@ -0,0 +1,68 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "utility/atoms.hpp"
+#include <gtk/gtk.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xafile {
+
+// Resolved icon theme lookups, keyed by icon atom, size and scale, shared by
+// every view. Cleared whenever the icon theme changes. Main thread only.
+class IconCache {
+public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t invalidations = 0;
+    std::size_t entries = 0;
+  };
+
+  static IconCache &instance();
+
+  // The cache keeps the reference
+  GdkPaintable *lookup(Atom icon, int size, int scale);
+
+  // Callbacks run after a theme change emptied the cache, so views can
+  // rebind what they show
+  std::size_t connect(std::function<void()> callback);
+  void disconnect(std::size_t id);
+
+  Stats stats() const;
+
+private:
+  IconCache() = default;
+
+  static void on_theme_changed(GtkIconTheme *theme, gpointer user_data);
+
+  GtkIconTheme *theme_ = nullptr;
+  std::unordered_map<std::uint64_t, GdkPaintable *> paintables_;
+  Stats stats_;
+  std::vector<std::pair<std::size_t, std::function<void()>>> listeners_;
+  std::size_t next_listener_ = 1;
+};
+
+} // namespace xafile
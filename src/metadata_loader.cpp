@@ -0,0 +1,173 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "metadata_loader.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr unsigned kMaxWorkers = 4;
+// Requested rows are few and wanted now, background work is taken in larger
+// chunks to keep lock traffic low.
+constexpr std::size_t kUrgentChunk = 16;
+constexpr std::size_t kBackgroundChunk = 256;
+
+} // namespace
+
+MetadataLoader::MetadataLoader(int dir_fd,
+                               std::shared_ptr<const Listing> listing,
+                               std::vector<std::uint32_t> order,
+                               ResultsCallback on_results)
+    : dir_fd_(dir_fd), listing_(std::move(listing)),
+      on_results_(std::move(on_results)), order_(std::move(order)),
+      taken_(listing_->size(), false), needs_type_(listing_->size(), false) {
+  // Types are filled in on the main thread as results arrive, so workers
+  // never look at them
+  for (auto index : order_) {
+    const auto &entry = (*listing_)[index];
+    needs_type_[index] =
+        !entry.is_directory && entry.content_type == atoms::kNone;
+  }
+}
+
+MetadataLoader::~MetadataLoader() {
+  if (dir_fd_ >= 0)
+    close(dir_fd_);
+}
+
+std::shared_ptr<MetadataLoader>
+MetadataLoader::start(const std::string &path,
+                      std::shared_ptr<const Listing> listing,
+                      std::vector<std::uint32_t> order,
+                      ResultsCallback on_results) {
+  int dir_fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  std::shared_ptr<MetadataLoader> loader(new MetadataLoader(
+      dir_fd, std::move(listing), std::move(order), std::move(on_results)));
+  if (dir_fd < 0)
+    return loader;
+
+  unsigned workers = std::clamp(std::thread::hardware_concurrency(), 1u,
+                                kMaxWorkers);
+  for (unsigned i = 0; i < workers; i++)
+    std::thread([loader] { loader->run(); }).detach();
+  return loader;
+}
+
+void MetadataLoader::prioritize(std::uint32_t index) {
+  std::lock_guard lock(mutex_);
+  if (index < taken_.size() && !taken_[index])
+    urgent_.push_back(index);
+}
+
+bool MetadataLoader::take(std::vector<std::uint32_t> &work) {
+  work.clear();
+  std::lock_guard lock(mutex_);
+
+  // Most recently requested rows first, they are the ones on screen
+  while (!urgent_.empty() && work.size() < kUrgentChunk) {
+    auto index = urgent_.back();
+    urgent_.pop_back();
+    if (!taken_[index]) {
+      taken_[index] = true;
+      work.push_back(index);
+    }
+  }
+  while (work.empty() && cursor_ < order_.size()) {
+    auto end = std::min(cursor_ + kBackgroundChunk, order_.size());
+    for (; cursor_ < end; cursor_++) {
+      auto index = order_[cursor_];
+      if (!taken_[index]) {
+        taken_[index] = true;
+        work.push_back(index);
+      }
+    }
+  }
+  return !work.empty();
+}
+
+void MetadataLoader::run() {
+  std::vector<std::uint32_t> work;
+  std::vector<MetadataResult> results;
+  auto &types = ContentTypeDetector::instance();
+
+  while (!is_cancelled() && take(work)) {
+    results.clear();
+    for (auto index : work) {
+      struct statx stx;
+      const char *name = listing_->c_name((*listing_)[index]);
+      if (statx(dir_fd_, name, AT_STATX_DONT_SYNC,
+                STATX_SIZE | STATX_MTIME | STATX_INO, &stx) != 0)
+        continue;
+
+      ContentType type{atoms::kNone, atoms::kNone, atoms::kNone};
+      if (needs_type_[index])
+        type = types.detect(dir_fd_, name,
+                            makedev(stx.stx_dev_major, stx.stx_dev_minor),
+                            stx.stx_ino, stx.stx_mtime.tv_sec,
+                            stx.stx_mtime.tv_nsec, stx.stx_size);
+      results.push_back({index, stx.stx_size, stx.stx_mtime.tv_sec, type});
+    }
+    if (!results.empty())
+      push(std::move(results));
+  }
+}
+
+void MetadataLoader::push(std::vector<MetadataResult> &&results) {
+  bool schedule = false;
+  {
+    std::lock_guard lock(mutex_);
+    results_.insert(results_.end(), results.begin(), results.end());
+    if (!dispatch_scheduled_) {
+      dispatch_scheduled_ = true;
+      schedule = true;
+    }
+  }
+
+  if (schedule) {
+    g_idle_add_full(
+        G_PRIORITY_DEFAULT_IDLE, dispatch,
+        new std::shared_ptr<MetadataLoader>(shared_from_this()),
+        +[](gpointer data) {
+          delete static_cast<std::shared_ptr<MetadataLoader> *>(data);
+        });
+  }
+}
+
+gboolean MetadataLoader::dispatch(gpointer user_data) {
+  auto &self = *static_cast<std::shared_ptr<MetadataLoader> *>(user_data);
+  if (self->is_cancelled())
+    return G_SOURCE_REMOVE;
+
+  std::vector<MetadataResult> results;
+  {
+    std::lock_guard lock(self->mutex_);
+    results.swap(self->results_);
+    self->dispatch_scheduled_ = false;
+  }
+  self->on_results_(std::move(results));
+  return G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
@@ -0,0 +1,89 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "content_types.hpp"
+#include "utility/listing.hpp"
+#include <glib.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+struct MetadataResult {
+  std::uint32_t index;
+  std::uint64_t size;
+  std::int64_t mtime;
+  ContentType type; // all kNone when the entry already had one
+};
+
+// Fills in size, modified time and, for files the name alone did not
+// settle, the content type on a small worker pool. Rows
+// a view asks for jump the queue, everything else is done in display order.
+// Results come back to the main loop in batches; nothing is delivered once
+// cancel() has returned.
+class MetadataLoader : public std::enable_shared_from_this<MetadataLoader> {
+public:
+  using ResultsCallback = std::function<void(std::vector<MetadataResult> &&)>;
+
+  // Workers only read names from `listing`, which the model hands out and
+  // then leaves alone; its copies keep the same indices. `order` lists the
+  // entry indices that still need metadata.
+  static std::shared_ptr<MetadataLoader>
+  start(const std::string &path, std::shared_ptr<const Listing> listing,
+        std::vector<std::uint32_t> order, ResultsCallback on_results);
+  ~MetadataLoader();
+
+  void prioritize(std::uint32_t index);
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool is_cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+private:
+  MetadataLoader(int dir_fd, std::shared_ptr<const Listing> listing,
+                 std::vector<std::uint32_t> order, ResultsCallback on_results);
+
+  void run();
+  bool take(std::vector<std::uint32_t> &work);
+  void push(std::vector<MetadataResult> &&results);
+  static gboolean dispatch(gpointer user_data);
+
+  int dir_fd_;
+  std::shared_ptr<const Listing> listing_;
+  ResultsCallback on_results_;
+  std::atomic<bool> cancelled_{false};
+
+  std::mutex mutex_;
+  std::vector<std::uint32_t> order_;
+  std::size_t cursor_ = 0;
+  std::vector<std::uint32_t> urgent_;
+  std::vector<bool> taken_;
+  std::vector<bool> needs_type_; // set before the workers start
+  std::vector<MetadataResult> results_;
+  bool dispatch_scheduled_ = false;
+};
+
+} // namespace xafile
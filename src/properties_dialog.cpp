@@ -0,0 +1,129 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "properties_dialog.hpp"
+#include <algorithm>
+#include <sys/stat.h>
+
+namespace xafile {
+
+namespace {
+
+std::string formatted_size(std::uint64_t bytes) {
+  char *text = g_format_size_full(bytes, G_FORMAT_SIZE_LONG_FORMAT);
+  std::string result(text);
+  g_free(text);
+  return result;
+}
+
+std::string counted(std::uint64_t count, const char *one, const char *many) {
+  return std::to_string(count) + " " + (count == 1 ? one : many);
+}
+
+} // namespace
+
+void PropertiesDialog::present(GtkWidget *parent,
+                               std::vector<std::string> paths) {
+  if (paths.empty())
+    return;
+  auto *self = new PropertiesDialog(std::move(paths));
+  adw_dialog_present(self->dialog_, parent);
+}
+
+PropertiesDialog::PropertiesDialog(std::vector<std::string> paths) {
+  dialog_ = adw_dialog_new();
+  adw_dialog_set_content_width(dialog_, 420);
+
+  auto *group = ADW_PREFERENCES_GROUP(adw_preferences_group_new());
+  if (paths.size() == 1) {
+    char *name = g_path_get_basename(paths.front().c_str());
+    char *location = g_path_get_dirname(paths.front().c_str());
+    adw_dialog_set_title(dialog_, name);
+    add_row(group, "Name", name);
+    add_row(group, "Location", location);
+    g_free(name);
+    g_free(location);
+  } else {
+    adw_dialog_set_title(
+        dialog_, counted(paths.size(), "Item", "Items").c_str());
+  }
+
+  // The selected folders themselves are not part of their contents
+  for (const auto &path : paths) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+      selected_dirs_++;
+  }
+  contents_row_ = add_row(group, "Contents", "…");
+  size_row_ = add_row(group, "Size", "…");
+  disk_row_ = add_row(group, "Size on Disk", "…");
+
+  auto *page = adw_preferences_page_new();
+  adw_preferences_page_add(ADW_PREFERENCES_PAGE(page), group);
+  auto *toolbar = adw_toolbar_view_new();
+  adw_toolbar_view_add_top_bar(ADW_TOOLBAR_VIEW(toolbar),
+                               adw_header_bar_new());
+  adw_toolbar_view_set_content(ADW_TOOLBAR_VIEW(toolbar), page);
+  adw_dialog_set_child(dialog_, toolbar);
+  g_signal_connect(dialog_, "closed", G_CALLBACK(on_closed), this);
+
+  job_ = SizeJob::start(std::move(paths),
+                        [this](const SizeTotals &totals, bool finished) {
+                          update(totals, finished);
+                        });
+}
+
+PropertiesDialog::~PropertiesDialog() = default;
+
+GtkWidget *PropertiesDialog::add_row(AdwPreferencesGroup *group,
+                                     const char *title,
+                                     const std::string &value) {
+  auto *row = adw_action_row_new();
+  adw_preferences_row_set_title(ADW_PREFERENCES_ROW(row), title);
+  adw_action_row_set_subtitle(ADW_ACTION_ROW(row), value.c_str());
+  adw_action_row_set_subtitle_selectable(ADW_ACTION_ROW(row), TRUE);
+  gtk_widget_add_css_class(row, "property");
+  adw_preferences_group_add(group, row);
+  return row;
+}
+
+void PropertiesDialog::update(const SizeTotals &totals, bool finished) {
+  // Still counting
+  const char *suffix = finished ? "" : "…";
+  auto contents = counted(totals.files, "file", "files");
+  auto folders = totals.directories - std::min(totals.directories,
+                                               std::uint64_t(selected_dirs_));
+  if (folders > 0)
+    contents += ", " + counted(folders, "folder", "folders");
+  adw_action_row_set_subtitle(ADW_ACTION_ROW(contents_row_),
+                              (contents + suffix).c_str());
+  adw_action_row_set_subtitle(
+      ADW_ACTION_ROW(size_row_),
+      (formatted_size(totals.bytes) + suffix).c_str());
+  adw_action_row_set_subtitle(
+      ADW_ACTION_ROW(disk_row_),
+      (formatted_size(totals.disk_bytes) + suffix).c_str());
+}
+
+void PropertiesDialog::on_closed(AdwDialog *, gpointer user_data) {
+  auto *self = static_cast<PropertiesDialog *>(user_data);
+  self->job_->cancel();
+  delete self;
+}
+
+} // namespace xafile
@@ -0,0 +1,55 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "size_job.hpp"
+#include <adwaita.h>
+#include <gtk/gtk.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+// Name, location, contents and size of a selection. The size is added up
+// by a SizeJob and fills in while it runs; closing the dialog cancels it.
+// The dialog owns itself and is freed once closed.
+class PropertiesDialog {
+public:
+  static void present(GtkWidget *parent, std::vector<std::string> paths);
+
+private:
+  explicit PropertiesDialog(std::vector<std::string> paths);
+  ~PropertiesDialog();
+
+  GtkWidget *add_row(AdwPreferencesGroup *group, const char *title,
+                     const std::string &value);
+  void update(const SizeTotals &totals, bool finished);
+  static void on_closed(AdwDialog *dialog, gpointer user_data);
+
+  AdwDialog *dialog_;
+  GtkWidget *contents_row_;
+  GtkWidget *size_row_;
+  GtkWidget *disk_row_;
+  std::size_t selected_dirs_ = 0;
+  std::shared_ptr<SizeJob> job_;
+};
+
+} // namespace xafile
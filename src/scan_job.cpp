@@ -0,0 +1,167 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "scan_job.hpp"
+#include "content_types.hpp"
+#include "utility/dir_reader.hpp"
+#include "utility/trace.hpp"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+// The first batch leaves the worker after roughly one frame so something is
+// on screen quickly; small directories finish well within that and arrive
+// sorted in a single batch. Later batches are bounded in size so one main
+// loop dispatch never stalls on a huge insertion.
+constexpr auto kFirstFlush = std::chrono::milliseconds(8);
+constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+constexpr std::size_t kMaxBatch = 4096;
+
+} // namespace
+
+ScanJob::ScanJob(std::string path, BatchCallback on_batch,
+                 DoneCallback on_done)
+    : path_(std::move(path)), on_batch_(std::move(on_batch)),
+      on_done_(std::move(on_done)) {}
+
+std::shared_ptr<ScanJob> ScanJob::start(std::string path,
+                                        BatchCallback on_batch,
+                                        DoneCallback on_done) {
+  std::shared_ptr<ScanJob> job(
+      new ScanJob(std::move(path), std::move(on_batch), std::move(on_done)));
+  std::thread([job] { job->run(); }).detach();
+  return job;
+}
+
+void ScanJob::run() {
+  using clock = std::chrono::steady_clock;
+  TraceSpan span("scan");
+  std::size_t scanned = 0;
+
+  Listing batch;
+  bool flushed = false;
+  auto deadline = clock::now() + kFirstFlush;
+
+  // Name based content types cost no I/O, so the first batch already shows
+  // the right icons.
+  auto &types = ContentTypeDetector::instance();
+  DirReader reader(path_.c_str());
+  // Hidden entries are kept and flagged, the view decides whether to show
+  // them
+  auto hidden = HiddenNames::read(reader.fd());
+  std::vector<DirEntry> entries;
+  while (reader.read(entries)) {
+    if (is_cancelled())
+      return;
+
+    for (const auto &e : entries) {
+      if (e.kind == EntryKind::Other)
+        continue;
+      bool is_directory = e.kind == EntryKind::Directory;
+      auto &entry = batch[batch.add(e.name, is_directory)];
+      if (hidden.contains(e.name))
+        entry.is_hidden = true;
+      if (is_directory)
+        continue;
+      if (auto type = types.from_name(e.name)) {
+        entry.content_type = type->content_type;
+        entry.type = type->description;
+        entry.icon = type->icon;
+      }
+    }
+
+    if (batch.size() >= kMaxBatch || clock::now() >= deadline) {
+      scanned += batch.size();
+      push(std::move(batch), false, false);
+      batch = Listing();
+      flushed = true;
+      deadline = clock::now() + kFlushInterval;
+    }
+  }
+  if (reader.error() != 0)
+    std::cerr << path_ << ": " << std::strerror(reader.error()) << '\n';
+
+  if (is_cancelled())
+    return;
+  if (!flushed)
+    batch.sort();
+  span.set_count(scanned + batch.size());
+  push(std::move(batch), true, !flushed);
+}
+
+void ScanJob::push(Listing &&batch, bool finished, bool sorted) {
+  bool schedule = false;
+  {
+    std::lock_guard lock(mutex_);
+    if (!batch.empty())
+      pending_.push_back(std::move(batch));
+    finished_ = finished;
+    sorted_ = sorted;
+    if (!dispatch_scheduled_) {
+      dispatch_scheduled_ = true;
+      schedule = true;
+    }
+  }
+
+  if (schedule) {
+    g_idle_add_full(
+        G_PRIORITY_DEFAULT_IDLE, dispatch,
+        new std::shared_ptr<ScanJob>(shared_from_this()), +[](gpointer data) {
+          delete static_cast<std::shared_ptr<ScanJob> *>(data);
+        });
+  }
+}
+
+gboolean ScanJob::dispatch(gpointer user_data) {
+  auto &self = *static_cast<std::shared_ptr<ScanJob> *>(user_data);
+  if (self->is_cancelled())
+    return G_SOURCE_REMOVE;
+
+  Listing batch;
+  bool more = false;
+  bool done = false;
+  bool sorted = false;
+  {
+    std::lock_guard lock(self->mutex_);
+    if (!self->pending_.empty()) {
+      batch = std::move(self->pending_.front());
+      self->pending_.pop_front();
+    }
+    more = !self->pending_.empty();
+    if (!more) {
+      self->dispatch_scheduled_ = false;
+      done = self->finished_;
+      sorted = self->sorted_;
+    }
+  }
+
+  if (!batch.empty())
+    self->on_batch_(std::move(batch));
+  if (done && !self->is_cancelled())
+    self->on_done_(sorted);
+
+  return more ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
@@ -0,0 +1,69 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "utility/listing.hpp"
+#include <glib.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace xafile {
+
+// Lists a directory on a worker thread and streams the entries back to the
+// main loop in batches. No callback runs once cancel() has returned.
+class ScanJob : public std::enable_shared_from_this<ScanJob> {
+public:
+  using BatchCallback = std::function<void(Listing &&)>;
+  // `sorted` is true when every entry arrived in one already sorted batch.
+  using DoneCallback = std::function<void(bool sorted)>;
+
+  static std::shared_ptr<ScanJob> start(std::string path,
+                                        BatchCallback on_batch,
+                                        DoneCallback on_done);
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool is_cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+private:
+  ScanJob(std::string path, BatchCallback on_batch, DoneCallback on_done);
+
+  void run();
+  void push(Listing &&batch, bool finished, bool sorted);
+  static gboolean dispatch(gpointer user_data);
+
+  std::string path_;
+  BatchCallback on_batch_;
+  DoneCallback on_done_;
+  std::atomic<bool> cancelled_{false};
+
+  std::mutex mutex_;
+  std::deque<Listing> pending_;
+  bool finished_ = false;
+  bool sorted_ = false;
+  bool dispatch_scheduled_ = false;
+};
+
+} // namespace xafile
@@ -0,0 +1,347 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "search_job.hpp"
+#include "content_types.hpp"
+#include "file_index.hpp"
+#include "utility/dir_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+// Same pacing as ScanJob: a first batch after about a frame, then bounded
+// batches so one main loop dispatch stays short.
+constexpr auto kFirstFlush = std::chrono::milliseconds(8);
+constexpr auto kFlushInterval = std::chrono::milliseconds(50);
+constexpr std::size_t kMaxBatch = 4096;
+// Idle workers look for work to steal this often
+constexpr auto kIdlePoll = std::chrono::milliseconds(1);
+
+bool is_ascii(std::string_view s) {
+  return std::all_of(s.begin(), s.end(), [](char c) {
+    return static_cast<unsigned char>(c) < 0x80;
+  });
+}
+
+char ascii_fold(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+std::string utf8_fold(std::string_view s) {
+  char *folded = g_utf8_casefold(s.data(), s.size());
+  std::string result(folded);
+  g_free(folded);
+  return result;
+}
+
+} // namespace
+
+NameMatcher::NameMatcher(std::string_view query) : ascii_(is_ascii(query)) {
+  if (ascii_) {
+    folded_.reserve(query.size());
+    for (char c : query)
+      folded_.push_back(ascii_fold(c));
+  } else {
+    folded_ = utf8_fold(query);
+  }
+}
+
+bool NameMatcher::matches(std::string_view name) const {
+  if (ascii_) {
+    auto it = std::search(name.begin(), name.end(), folded_.begin(),
+                          folded_.end(), [](char a, char b) {
+                            return ascii_fold(a) == b;
+                          });
+    return it != name.end() || folded_.empty();
+  }
+  // Names that are not UTF-8 cannot contain a non-ASCII query
+  if (is_ascii(name) || !g_utf8_validate(name.data(), name.size(), nullptr))
+    return false;
+  return utf8_fold(name).find(folded_) != std::string::npos;
+}
+
+SearchJob::SearchJob(int root_fd, std::string query, BatchCallback on_batch,
+                     DoneCallback on_done, unsigned workers)
+    : root_fd_(root_fd), matcher_(query), on_batch_(std::move(on_batch)),
+      on_done_(std::move(on_done)), running_workers_(workers) {
+  for (unsigned i = 0; i < workers; i++)
+    queues_.push_back(std::make_unique<WorkQueue>());
+}
+
+SearchJob::~SearchJob() {
+  if (root_fd_ >= 0)
+    close(root_fd_);
+}
+
+std::shared_ptr<SearchJob> SearchJob::start(std::string root,
+                                            std::string query,
+                                            BatchCallback on_batch,
+                                            DoneCallback on_done) {
+  int root_fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  unsigned workers = std::max(std::thread::hardware_concurrency(), 2u);
+  std::shared_ptr<SearchJob> job(new SearchJob(
+      root_fd, std::move(query), std::move(on_batch), std::move(on_done),
+      workers));
+  if (root_fd < 0) {
+    job->push(Listing(), true);
+    return job;
+  }
+
+  // Inside the home directory the index answers without touching the disk
+  if (FileIndex::instance().covers(root)) {
+    std::thread([job, root = std::move(root)] {
+      if (!job->search_index(root))
+        job->start_walk();
+    }).detach();
+    return job;
+  }
+  job->start_walk();
+  return job;
+}
+
+bool SearchJob::search_index(const std::string &root) {
+  std::vector<FileIndex::StaleDir> stale;
+  bool answered = FileIndex::instance().search(
+      root, matcher_,
+      [this](Listing &&batch) { push(std::move(batch), false); },
+      cancelled_, stale);
+  if (!answered || is_cancelled())
+    return answered;
+
+  // What changed since the index was built is read like any other search
+  struct stat st;
+  if (stale.empty() || fstat(root_fd_, &st) != 0) {
+    push(Listing(), true);
+    return true;
+  }
+  std::vector<PendingDir> dirs;
+  for (auto &dir : stale)
+    dirs.push_back({std::move(dir.path), st.st_dev,
+                    std::make_shared<const std::unordered_set<std::string>>(
+                        std::move(dir.indexed))});
+  walk_from(std::move(dirs));
+  return true;
+}
+
+void SearchJob::start_walk() {
+  struct stat st;
+  if (fstat(root_fd_, &st) != 0) {
+    push(Listing(), true);
+    return;
+  }
+  // The root is searched even when it is a pseudo-filesystem itself
+  walk_from({{std::string(), st.st_dev, nullptr}});
+}
+
+void SearchJob::walk_from(std::vector<PendingDir> &&dirs) {
+  outstanding_ = dirs.size();
+  for (std::size_t i = 0; i < dirs.size(); i++)
+    queues_[i % queues_.size()]->dirs.push_back(std::move(dirs[i]));
+  for (unsigned i = 0; i < queues_.size(); i++)
+    std::thread([job = shared_from_this(), i] { job->run(i); }).detach();
+}
+
+void SearchJob::run(unsigned worker) {
+  using clock = std::chrono::steady_clock;
+
+  Listing matches;
+  auto deadline = clock::now() + kFirstFlush;
+  PendingDir dir;
+  while (take(worker, dir)) {
+    walk(worker, dir, matches);
+    // Children were queued before this count drops
+    if (outstanding_.fetch_sub(1) == 1)
+      idle_cv_.notify_all();
+
+    if (matches.size() >= kMaxBatch ||
+        (!matches.empty() && clock::now() >= deadline)) {
+      push(std::move(matches), false);
+      matches = Listing();
+      deadline = clock::now() + kFlushInterval;
+    }
+  }
+
+  if (!matches.empty() && !is_cancelled())
+    push(std::move(matches), false);
+  finish_worker();
+}
+
+// Own queue from the back, so each worker goes depth first and keeps its
+// queue short; others' from the front, where the biggest subtrees wait.
+bool SearchJob::take(unsigned worker, PendingDir &dir) {
+  while (!is_cancelled()) {
+    {
+      auto &own = *queues_[worker];
+      std::lock_guard lock(own.mutex);
+      if (!own.dirs.empty()) {
+        dir = std::move(own.dirs.back());
+        own.dirs.pop_back();
+        return true;
+      }
+    }
+    for (std::size_t i = 1; i < queues_.size(); i++) {
+      auto &victim = *queues_[(worker + i) % queues_.size()];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.dirs.empty()) {
+        dir = std::move(victim.dirs.front());
+        victim.dirs.pop_front();
+        return true;
+      }
+    }
+
+    std::unique_lock lock(idle_mutex_);
+    if (outstanding_.load() == 0)
+      return false;
+    idle_cv_.wait_for(lock, kIdlePoll);
+  }
+  return false;
+}
+
+void SearchJob::enqueue(unsigned worker, PendingDir &&dir) {
+  outstanding_.fetch_add(1);
+  {
+    auto &own = *queues_[worker];
+    std::lock_guard lock(own.mutex);
+    own.dirs.push_back(std::move(dir));
+  }
+  idle_cv_.notify_one();
+}
+
+void SearchJob::walk(unsigned worker, const PendingDir &dir,
+                     Listing &matches) {
+  if (is_cancelled())
+    return;
+
+  DirReader reader(root_fd_, dir.path.empty() ? "." : dir.path.c_str());
+  if (!reader.is_open())
+    return;
+  struct stat st;
+  if (fstat(reader.fd(), &st) != 0)
+    return;
+  // Only a mount point can change the filesystem type
+  if (st.st_dev != dir.parent_device && is_pseudo_filesystem(reader.fd()))
+    return;
+  // Bind mounts can make a directory reachable from inside itself
+  if (!first_visit(st.st_dev, st.st_ino))
+    return;
+
+  auto &types = ContentTypeDetector::instance();
+  std::string child = dir.path;
+  if (!child.empty())
+    child += '/';
+  std::size_t prefix = child.size();
+
+  std::vector<DirEntry> entries;
+  while (reader.read(entries)) {
+    if (is_cancelled())
+      return;
+
+    for (const auto &e : entries) {
+      if (e.kind == EntryKind::Other)
+        continue;
+      bool is_directory = e.kind == EntryKind::Directory;
+      child.resize(prefix);
+      child.append(e.name);
+
+      if (matcher_.matches(e.name)) {
+        auto &entry = matches[matches.add(child, is_directory)];
+        if (!is_directory) {
+          if (auto type = types.from_name(e.name)) {
+            entry.content_type = type->content_type;
+            entry.type = type->description;
+            entry.icon = type->icon;
+          }
+        }
+      }
+      // Symlinked directories are listed, following them could loop
+      if (is_directory && !e.is_symlink &&
+          !(dir.indexed && dir.indexed->contains(std::string(e.name))))
+        enqueue(worker, {child, st.st_dev, nullptr});
+    }
+  }
+}
+
+bool SearchJob::first_visit(dev_t device, ino_t inode) {
+  DirId id{device, inode};
+  auto &shard = visited_[DirIdHash()(id) % visited_.size()];
+  std::lock_guard lock(shard.mutex);
+  return shard.ids.insert(id).second;
+}
+
+void SearchJob::finish_worker() {
+  if (running_workers_.fetch_sub(1) == 1 && !is_cancelled())
+    push(Listing(), true);
+}
+
+void SearchJob::push(Listing &&batch, bool finished) {
+  bool schedule = false;
+  {
+    std::lock_guard lock(mutex_);
+    if (!batch.empty())
+      pending_.push_back(std::move(batch));
+    finished_ = finished_ || finished;
+    if (!dispatch_scheduled_) {
+      dispatch_scheduled_ = true;
+      schedule = true;
+    }
+  }
+
+  if (schedule) {
+    g_idle_add_full(
+        G_PRIORITY_DEFAULT_IDLE, dispatch,
+        new std::shared_ptr<SearchJob>(shared_from_this()), +[](gpointer data) {
+          delete static_cast<std::shared_ptr<SearchJob> *>(data);
+        });
+  }
+}
+
+gboolean SearchJob::dispatch(gpointer user_data) {
+  auto &self = *static_cast<std::shared_ptr<SearchJob> *>(user_data);
+  if (self->is_cancelled())
+    return G_SOURCE_REMOVE;
+
+  Listing batch;
+  bool more = false;
+  bool done = false;
+  {
+    std::lock_guard lock(self->mutex_);
+    if (!self->pending_.empty()) {
+      batch = std::move(self->pending_.front());
+      self->pending_.pop_front();
+    }
+    more = !self->pending_.empty();
+    if (!more) {
+      self->dispatch_scheduled_ = false;
+      done = self->finished_;
+    }
+  }
+
+  if (!batch.empty())
+    self->on_batch_(std::move(batch));
+  if (done && !self->is_cancelled())
+    self->on_done_();
+
+  return more ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
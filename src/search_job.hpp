@@ -0,0 +1,145 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "utility/listing.hpp"
+#include <glib.h>
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+// Case-insensitive substring match on file names. ASCII queries are folded
+// byte by byte; anything else goes through g_utf8_casefold.
+class NameMatcher {
+public:
+  explicit NameMatcher(std::string_view query);
+
+  bool matches(std::string_view name) const;
+  // The query as compared against names
+  const std::string &folded() const { return folded_; }
+  bool ascii_only() const { return ascii_; }
+
+private:
+  std::string folded_;
+  bool ascii_;
+};
+
+// Walks the tree below a directory on a pool of worker threads and streams
+// the entries whose name matches back to the main loop. Each worker takes
+// directories from its own queue and steals from the others when it runs
+// dry. Symlinked directories are listed but not entered, every directory is
+// entered at most once, and pseudo-filesystems such as /proc are skipped.
+// Below the home directory the search is answered from the FileIndex
+// instead, and only directories changed since it was built are read. Entry
+// names are paths relative to the root. No callback runs once
+// cancel() has returned.
+class SearchJob : public std::enable_shared_from_this<SearchJob> {
+public:
+  using BatchCallback = std::function<void(Listing &&)>;
+  using DoneCallback = std::function<void()>;
+
+  static std::shared_ptr<SearchJob> start(std::string root, std::string query,
+                                          BatchCallback on_batch,
+                                          DoneCallback on_done);
+  ~SearchJob();
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool is_cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct PendingDir {
+    std::string path; // relative to the root, empty for the root itself
+    dev_t parent_device;
+    // Subdirectories the FileIndex answered for, which are not entered
+    std::shared_ptr<const std::unordered_set<std::string>> indexed;
+  };
+
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<PendingDir> dirs;
+  };
+
+  SearchJob(int root_fd, std::string query, BatchCallback on_batch,
+            DoneCallback on_done, unsigned workers);
+
+  bool search_index(const std::string &root);
+  void start_walk();
+  void walk_from(std::vector<PendingDir> &&dirs);
+  void run(unsigned worker);
+  bool take(unsigned worker, PendingDir &dir);
+  void enqueue(unsigned worker, PendingDir &&dir);
+  void walk(unsigned worker, const PendingDir &dir, Listing &matches);
+  bool first_visit(dev_t device, ino_t inode);
+  void push(Listing &&batch, bool finished);
+  void finish_worker();
+  static gboolean dispatch(gpointer user_data);
+
+  int root_fd_;
+  NameMatcher matcher_;
+  BatchCallback on_batch_;
+  DoneCallback on_done_;
+  std::atomic<bool> cancelled_{false};
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  // Directories queued or being read; the walk is over when it drops to 0
+  std::atomic<std::size_t> outstanding_{0};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  std::atomic<unsigned> running_workers_;
+
+  // Directories already entered, sharded to keep workers off one lock
+  struct DirId {
+    dev_t device;
+    ino_t inode;
+    bool operator==(const DirId &) const = default;
+  };
+  struct DirIdHash {
+    std::size_t operator()(const DirId &id) const {
+      return std::hash<std::uint64_t>()(id.inode ^ (std::uint64_t(id.device)
+                                                    << 32));
+    }
+  };
+  struct VisitedShard {
+    std::mutex mutex;
+    std::unordered_set<DirId, DirIdHash> ids;
+  };
+  std::array<VisitedShard, 64> visited_;
+
+  std::mutex mutex_;
+  std::deque<Listing> pending_;
+  bool finished_ = false;
+  bool dispatch_scheduled_ = false;
+};
+
+} // namespace xafile
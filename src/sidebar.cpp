@@ -20,7 +20,6 @@
 #include "content_view.hpp"
 #include "glib.h"
 #include "gtk/gtk.h"
-#include "utility/utilitas.hpp"
 #include <filesystem>
 namespace xafile {
 
@@ -39,7 +38,6 @@ Sidebar::Sidebar() {
 }
 
 Sidebar *Sidebar::create() { return new Sidebar(); }
-static Utility utly{};
 void Sidebar::setup_places() {
   places_list_ = GTK_LIST_BOX(gtk_list_box_new());
   gtk_widget_add_css_class(GTK_WIDGET(places_list_), "navigation-sidebar");
@@ -109,9 +107,8 @@ void Sidebar::on_row_activated(GtkListBox *list_box, GtkListBoxRow *row,
     path = std::string(g_get_home_dir()) + "/Documents";
     break;
   }
-  utly.setCurDir(path);
   if (self->content_view_) {
-    self->content_view_->reload_items();
+    self->content_view_->show_directory(path);
   }
 }
 } // namespace xafile
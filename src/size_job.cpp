@@ -0,0 +1,375 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "size_job.hpp"
+#include "utility/dir_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace xafile {
+
+namespace {
+
+constexpr guint kReportIntervalMs = 100;
+// Idle workers look for work to steal this often
+constexpr auto kIdlePoll = std::chrono::milliseconds(1);
+// Waiting on stat rather than the CPU, so a few more than there are cores
+constexpr unsigned kMinWorkers = 4;
+// Roughly 100 MB for a few million directories; a full shard starts over
+constexpr std::size_t kMaxCachedDirs = 1 << 21;
+// A directory changed this recently could change again within the same
+// mtime tick, so it is not remembered yet
+constexpr std::int64_t kRacyNs = 1'000'000'000;
+
+std::int64_t nanoseconds(const struct timespec &ts) {
+  return std::int64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// What one directory holds directly
+struct DirContents {
+  struct timespec mtime;
+  struct timespec ctime;
+  std::uint64_t bytes = 0;
+  std::uint64_t disk_bytes = 0;
+  std::uint64_t files = 0; // with a single link
+  // Files with several links, which may already be counted elsewhere
+  struct Linked {
+    ino_t inode;
+    std::uint64_t bytes;
+    std::uint64_t disk_bytes;
+  };
+  std::vector<Linked> linked;
+  std::vector<std::string> subdirs;
+
+  bool matches(const struct stat &st) const {
+    return nanoseconds(mtime) == nanoseconds(st.st_mtim) &&
+           nanoseconds(ctime) == nanoseconds(st.st_ctim);
+  }
+};
+
+class DirSizeCache {
+public:
+  static DirSizeCache &instance() {
+    static DirSizeCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<const DirContents> lookup(const struct stat &st) {
+    auto &shard = shard_for(st.st_dev, st.st_ino);
+    std::lock_guard lock(shard.mutex);
+    auto it = shard.dirs.find(key(st.st_dev, st.st_ino));
+    if (it == shard.dirs.end())
+      return nullptr;
+    if (!it->second->matches(st)) {
+      shard.dirs.erase(it);
+      return nullptr;
+    }
+    return it->second;
+  }
+
+  void store(const struct stat &st, std::shared_ptr<const DirContents> dir) {
+    auto &shard = shard_for(st.st_dev, st.st_ino);
+    std::lock_guard lock(shard.mutex);
+    if (shard.dirs.size() >= kMaxCachedDirs / kShards)
+      shard.dirs.clear();
+    shard.dirs[key(st.st_dev, st.st_ino)] = std::move(dir);
+  }
+
+  void erase(dev_t device, ino_t inode) {
+    auto &shard = shard_for(device, inode);
+    std::lock_guard lock(shard.mutex);
+    shard.dirs.erase(key(device, inode));
+  }
+
+private:
+  static constexpr std::size_t kShards = 64;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<const DirContents>>
+        dirs;
+  };
+
+  static std::uint64_t key(dev_t device, ino_t inode) {
+    return std::uint64_t(inode) ^ (std::uint64_t(device) << 40);
+  }
+  Shard &shard_for(dev_t device, ino_t inode) {
+    return shards_[std::hash<std::uint64_t>()(key(device, inode)) % kShards];
+  }
+
+  std::array<Shard, kShards> shards_;
+};
+
+} // namespace
+
+SizeJob::SizeJob(std::vector<std::string> paths, ProgressCallback on_progress,
+                 unsigned workers)
+    : paths_(std::move(paths)), on_progress_(std::move(on_progress)),
+      running_workers_(workers) {
+  for (unsigned i = 0; i < workers; i++)
+    queues_.push_back(std::make_unique<WorkQueue>());
+}
+
+SizeJob::~SizeJob() = default;
+
+std::shared_ptr<SizeJob> SizeJob::start(std::vector<std::string> paths,
+                                        ProgressCallback on_progress) {
+  unsigned workers = std::max(std::thread::hardware_concurrency(), kMinWorkers);
+  std::shared_ptr<SizeJob> job(
+      new SizeJob(std::move(paths), std::move(on_progress), workers));
+  job->begin();
+  g_timeout_add_full(
+      G_PRIORITY_DEFAULT, kReportIntervalMs, report,
+      new std::shared_ptr<SizeJob>(job), +[](gpointer data) {
+        delete static_cast<std::shared_ptr<SizeJob> *>(data);
+      });
+  return job;
+}
+
+void SizeJob::begin() {
+  auto workers = static_cast<unsigned>(queues_.size());
+  running_workers_ = workers;
+  // Plain files among the paths are counted right away
+  for (const auto &path : paths_) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0)
+      continue;
+    if (S_ISDIR(st.st_mode)) {
+      outstanding_++;
+      queues_[outstanding_ % workers]->dirs.push_back({path, st.st_dev});
+    } else {
+      add_file(st.st_dev, st);
+    }
+  }
+
+  for (unsigned i = 0; i < workers; i++)
+    std::thread([job = shared_from_this(), i] { job->run(i); }).detach();
+}
+
+// Called once the workers are gone. Cached directories are stored again
+// as they are read.
+void SizeJob::recount() {
+  recounting_ = true;
+  bytes_ = 0;
+  disk_bytes_ = 0;
+  files_ = 0;
+  directories_ = 0;
+  for (auto &shard : seen_) {
+    std::lock_guard lock(shard.mutex);
+    shard.ids.clear();
+  }
+  begin();
+}
+
+SizeTotals SizeJob::totals() const {
+  SizeTotals totals;
+  totals.bytes = bytes_;
+  totals.disk_bytes = disk_bytes_;
+  totals.files = files_;
+  totals.directories = directories_;
+  return totals;
+}
+
+void SizeJob::invalidate(const std::string &dir_path) {
+  struct stat st;
+  if (stat(dir_path.c_str(), &st) == 0)
+    DirSizeCache::instance().erase(st.st_dev, st.st_ino);
+}
+
+void SizeJob::run(unsigned worker) {
+  PendingDir dir;
+  while (take(worker, dir)) {
+    walk(worker, dir);
+    // Children were queued before this count drops
+    if (outstanding_.fetch_sub(1) == 1)
+      idle_cv_.notify_all();
+  }
+  running_workers_.fetch_sub(1);
+}
+
+// Own queue from the back, others' from the front, as in SearchJob
+bool SizeJob::take(unsigned worker, PendingDir &dir) {
+  while (!is_cancelled()) {
+    {
+      auto &own = *queues_[worker];
+      std::lock_guard lock(own.mutex);
+      if (!own.dirs.empty()) {
+        dir = std::move(own.dirs.back());
+        own.dirs.pop_back();
+        return true;
+      }
+    }
+    for (std::size_t i = 1; i < queues_.size(); i++) {
+      auto &victim = *queues_[(worker + i) % queues_.size()];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.dirs.empty()) {
+        dir = std::move(victim.dirs.front());
+        victim.dirs.pop_front();
+        return true;
+      }
+    }
+
+    std::unique_lock lock(idle_mutex_);
+    if (outstanding_.load() == 0)
+      return false;
+    idle_cv_.wait_for(lock, kIdlePoll);
+  }
+  return false;
+}
+
+void SizeJob::enqueue(unsigned worker, PendingDir &&dir) {
+  outstanding_.fetch_add(1);
+  {
+    auto &own = *queues_[worker];
+    std::lock_guard lock(own.mutex);
+    own.dirs.push_back(std::move(dir));
+  }
+  idle_cv_.notify_one();
+}
+
+void SizeJob::walk(unsigned worker, const PendingDir &dir) {
+  if (is_cancelled())
+    return;
+
+  struct stat st;
+  if (lstat(dir.path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) ||
+      st.st_dev != dir.device || !first_sight(st.st_dev, st.st_ino))
+    return;
+  directories_ += 1;
+  disk_bytes_ += std::uint64_t(st.st_blocks) * 512;
+
+  auto &cache = DirSizeCache::instance();
+  auto contents = recounting_ ? nullptr : cache.lookup(st);
+  if (contents)
+    used_cache_ = true;
+  if (!contents) {
+    DirReader reader(dir.path.c_str());
+    if (!reader.is_open())
+      return;
+    auto listed = std::make_shared<DirContents>();
+    listed->mtime = st.st_mtim;
+    listed->ctime = st.st_ctim;
+    std::vector<DirEntry> entries;
+    while (reader.read(entries)) {
+      if (is_cancelled())
+        return;
+      for (const auto &e : entries) {
+        if (e.kind == EntryKind::Directory && !e.is_symlink) {
+          listed->subdirs.emplace_back(e.name);
+          continue;
+        }
+        struct stat file;
+        if (fstatat(reader.fd(), e.name.data(), &file, AT_SYMLINK_NOFOLLOW) !=
+            0)
+          continue;
+        // A directory that appeared after the listing said otherwise
+        if (S_ISDIR(file.st_mode)) {
+          listed->subdirs.emplace_back(e.name);
+          continue;
+        }
+        std::uint64_t disk = std::uint64_t(file.st_blocks) * 512;
+        if (file.st_nlink > 1) {
+          listed->linked.push_back({file.st_ino, std::uint64_t(file.st_size),
+                                    disk});
+          continue;
+        }
+        listed->bytes += file.st_size;
+        listed->disk_bytes += disk;
+        listed->files++;
+      }
+    }
+    if (reader.error() != 0)
+      return;
+
+    // The directory may have changed while it was read
+    struct stat after;
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    if (fstat(reader.fd(), &after) == 0 && listed->matches(after) &&
+        std::chrono::nanoseconds(now).count() - nanoseconds(after.st_mtim) >
+            kRacyNs)
+      cache.store(st, listed);
+    contents = std::move(listed);
+  }
+
+  bytes_ += contents->bytes;
+  disk_bytes_ += contents->disk_bytes;
+  files_ += contents->files;
+  for (const auto &file : contents->linked)
+    add_linked(st.st_dev, file.inode, file.bytes, file.disk_bytes);
+
+  std::string child = dir.path;
+  if (child.back() != '/')
+    child += '/';
+  std::size_t prefix = child.size();
+  for (const auto &name : contents->subdirs) {
+    child.resize(prefix);
+    child += name;
+    enqueue(worker, {child, dir.device});
+  }
+}
+
+void SizeJob::add_file(dev_t device, const struct stat &st) {
+  std::uint64_t disk = std::uint64_t(st.st_blocks) * 512;
+  if (st.st_nlink > 1) {
+    add_linked(device, st.st_ino, st.st_size, disk);
+    return;
+  }
+  bytes_ += st.st_size;
+  disk_bytes_ += disk;
+  files_ += 1;
+}
+
+void SizeJob::add_linked(dev_t device, ino_t inode, std::uint64_t bytes,
+                         std::uint64_t disk_bytes) {
+  if (!first_sight(device, inode))
+    return;
+  bytes_ += bytes;
+  disk_bytes_ += disk_bytes;
+  files_ += 1;
+}
+
+bool SizeJob::first_sight(dev_t device, ino_t inode) {
+  FileId id{device, inode};
+  auto &shard = seen_[FileIdHash()(id) % seen_.size()];
+  std::lock_guard lock(shard.mutex);
+  return shard.ids.insert(id).second;
+}
+
+gboolean SizeJob::report(gpointer user_data) {
+  auto &self = *static_cast<std::shared_ptr<SizeJob> *>(user_data);
+  if (self->is_cancelled())
+    return G_SOURCE_REMOVE;
+
+  bool finished = self->running_workers_.load() == 0;
+  if (finished && self->used_cache_ && !self->recounting_) {
+    self->provisional_ = self->totals();
+    self->recount();
+    finished = false;
+  }
+  self->on_progress_(finished || !self->provisional_ ? self->totals()
+                                                     : *self->provisional_,
+                     finished);
+  return finished ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+} // namespace xafile
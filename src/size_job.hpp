@@ -0,0 +1,144 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+struct SizeTotals {
+  std::uint64_t bytes = 0;      // apparent size of the files
+  std::uint64_t disk_bytes = 0; // blocks in use, folders included
+  std::uint64_t files = 0;
+  std::uint64_t directories = 0;
+};
+
+// Adds up what is below a set of paths on a pool of worker threads, the
+// way SearchJob walks: per-worker queues, stealing when one runs dry.
+// Files with several hard links count once, and the walk stays on the
+// filesystem of each path. Totals so far reach the main loop about ten
+// times a second.
+//
+// What each directory holds directly is remembered across jobs, keyed by
+// its device and inode and checked against its mtime and ctime, so an
+// unchanged tree is added up again at one stat per directory. Files grown
+// or rewritten in place leave those times alone, so a total that used
+// remembered directories is only provisional: it is shown as not finished
+// while the tree is counted again file by file. invalidate() drops a
+// directory known to have changed.
+class SizeJob : public std::enable_shared_from_this<SizeJob> {
+public:
+  using ProgressCallback =
+      std::function<void(const SizeTotals &totals, bool finished)>;
+
+  static std::shared_ptr<SizeJob> start(std::vector<std::string> paths,
+                                        ProgressCallback on_progress);
+  ~SizeJob();
+
+  // No callback runs once this has returned
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool is_cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  static void invalidate(const std::string &dir_path);
+
+private:
+  struct PendingDir {
+    std::string path;
+    dev_t device; // of the path the walk started from
+  };
+
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<PendingDir> dirs;
+  };
+
+  struct FileId {
+    dev_t device;
+    ino_t inode;
+    bool operator==(const FileId &) const = default;
+  };
+  struct FileIdHash {
+    std::size_t operator()(const FileId &id) const {
+      return std::hash<std::uint64_t>()(id.inode ^ (std::uint64_t(id.device)
+                                                    << 32));
+    }
+  };
+
+  SizeJob(std::vector<std::string> paths, ProgressCallback on_progress,
+          unsigned workers);
+
+  void begin();
+  void recount();
+  SizeTotals totals() const;
+  void run(unsigned worker);
+  bool take(unsigned worker, PendingDir &dir);
+  void enqueue(unsigned worker, PendingDir &&dir);
+  void walk(unsigned worker, const PendingDir &dir);
+  void add_file(dev_t device, const struct stat &st);
+  void add_linked(dev_t device, ino_t inode, std::uint64_t bytes,
+                  std::uint64_t disk_bytes);
+  static gboolean report(gpointer user_data);
+
+  std::vector<std::string> paths_;
+  ProgressCallback on_progress_;
+  std::atomic<bool> cancelled_{false};
+  // Set before the workers start, for the count that skips the cache
+  bool recounting_ = false;
+  std::atomic<bool> used_cache_{false};
+  // Main thread only: the cached total shown while the recount runs
+  std::optional<SizeTotals> provisional_;
+
+  std::atomic<std::uint64_t> bytes_{0};
+  std::atomic<std::uint64_t> disk_bytes_{0};
+  std::atomic<std::uint64_t> files_{0};
+  std::atomic<std::uint64_t> directories_{0};
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  // Directories queued or being read; the walk is over when it drops to 0
+  std::atomic<std::size_t> outstanding_{0};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+  std::atomic<unsigned> running_workers_;
+
+  // Files with more than one link, and directories, already counted
+  struct SeenShard {
+    std::mutex mutex;
+    std::unordered_set<FileId, FileIdHash> ids;
+  };
+  std::array<SeenShard, 64> seen_;
+  bool first_sight(dev_t device, ino_t inode);
+};
+
+} // namespace xafile
@@ -0,0 +1,89 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "stat_job.hpp"
+#include "content_types.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+StatJob::StatJob(std::string path, std::vector<std::string> names,
+                 DoneCallback on_done)
+    : path_(std::move(path)), names_(std::move(names)),
+      on_done_(std::move(on_done)) {}
+
+std::shared_ptr<StatJob> StatJob::start(std::string path,
+                                        std::vector<std::string> names,
+                                        DoneCallback on_done) {
+  std::shared_ptr<StatJob> job(
+      new StatJob(std::move(path), std::move(names), std::move(on_done)));
+  std::thread([job] { job->run(); }).detach();
+  return job;
+}
+
+void StatJob::run() {
+  // A directory that cannot be opened any more changes nothing
+  int dir_fd = open(path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd >= 0) {
+    auto &types = ContentTypeDetector::instance();
+    updates_.reserve(names_.size());
+    for (auto &name : names_) {
+      if (is_cancelled())
+        break;
+      EntryUpdate update{std::move(name), false, false, 0, 0,
+                         {atoms::kNone, atoms::kNone, atoms::kNone}};
+      struct stat st;
+      if (fstatat(dir_fd, update.name.c_str(), &st, 0) == 0 &&
+          (S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) {
+        update.exists = true;
+        update.is_directory = S_ISDIR(st.st_mode);
+        update.size = st.st_size;
+        update.mtime = st.st_mtim.tv_sec;
+        // Sniffing reads the file, which is left to the metadata workers
+        if (!update.is_directory) {
+          if (auto type = types.from_name(update.name))
+            update.type = *type;
+          else
+            unsettled_ = true;
+        }
+      }
+      updates_.push_back(std::move(update));
+    }
+    close(dir_fd);
+  }
+  if (is_cancelled())
+    return;
+
+  g_idle_add_full(
+      G_PRIORITY_DEFAULT_IDLE, dispatch,
+      new std::shared_ptr<StatJob>(shared_from_this()), +[](gpointer data) {
+        delete static_cast<std::shared_ptr<StatJob> *>(data);
+      });
+}
+
+gboolean StatJob::dispatch(gpointer user_data) {
+  auto &self = *static_cast<std::shared_ptr<StatJob> *>(user_data);
+  if (!self->is_cancelled())
+    self->on_done_(std::move(self->updates_), self->unsettled_);
+  return G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
@@ -0,0 +1,67 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "file_list_model.hpp"
+#include <glib.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+// Looks changed names up in a directory on a worker thread and hands what
+// is there now back to the main loop. Types come from the names alone. No
+// callback runs once cancel() has returned.
+class StatJob : public std::enable_shared_from_this<StatJob> {
+public:
+  // `unsettled` is true when some file's type still has to be sniffed
+  using DoneCallback =
+      std::function<void(std::vector<EntryUpdate> &&, bool unsettled)>;
+
+  static std::shared_ptr<StatJob> start(std::string path,
+                                        std::vector<std::string> names,
+                                        DoneCallback on_done);
+
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool is_cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+private:
+  StatJob(std::string path, std::vector<std::string> names,
+          DoneCallback on_done);
+
+  void run();
+  static gboolean dispatch(gpointer user_data);
+
+  std::string path_;
+  std::vector<std::string> names_;
+  DoneCallback on_done_;
+  std::atomic<bool> cancelled_{false};
+
+  // Written by the worker before the dispatch is scheduled
+  std::vector<EntryUpdate> updates_;
+  bool unsettled_ = false;
+};
+
+} // namespace xafile
@@ -0,0 +1,513 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "thumbnailer.hpp"
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr unsigned kWorkers = 2;
+constexpr int kSize = 128; // the spec's "normal" size
+constexpr std::size_t kDefaultBudget = 32u << 20;
+// Failed lookups are remembered too, charge them something
+constexpr std::size_t kFailedSlotBytes = 256;
+// Past this many superseded requests the queue is swept
+constexpr std::size_t kMaxStaleRequests = 256;
+// The spec names failures after the application and its version, so they
+// are tried again once it is upgraded
+constexpr char kFailDir[] = "fail/xafile-" XAFILE_VERSION;
+
+std::size_t budget_from_env() {
+  if (const char *mb = std::getenv("XAFILE_THUMBNAIL_CACHE_MB"))
+    return static_cast<std::size_t>(std::strtoull(mb, nullptr, 10)) << 20;
+  return kDefaultBudget;
+}
+
+std::string cache_dir(const char *kind) {
+  return std::string(g_get_user_cache_dir()) + "/thumbnails/" + kind;
+}
+
+bool in_directory(const std::string &path, const std::string &directory) {
+  return path.size() > directory.size() && path.starts_with(directory) &&
+         path.find('/', directory.size()) == std::string::npos;
+}
+
+// Image formats gdk-pixbuf can decode, and the thumbnailers installed as
+// described by the freedesktop thumbnailer spec. Both are read once.
+class Renderers {
+public:
+  static const Renderers &get() {
+    static Renderers renderers;
+    return renderers;
+  }
+
+  bool has_loader(std::string_view mime) const {
+    return loaders_.contains(std::string(mime));
+  }
+  const std::string *command(std::string_view mime) const {
+    auto it = commands_.find(std::string(mime));
+    return it == commands_.end() ? nullptr : &it->second;
+  }
+
+private:
+  Renderers() {
+    GSList *formats = gdk_pixbuf_get_formats();
+    for (GSList *l = formats; l; l = l->next) {
+      auto *format = static_cast<GdkPixbufFormat *>(l->data);
+      char **types = gdk_pixbuf_format_get_mime_types(format);
+      for (char **type = types; type && *type; type++)
+        loaders_.emplace(*type);
+      g_strfreev(types);
+    }
+    g_slist_free(formats);
+
+    // Earlier data directories take precedence
+    load_thumbnailers(g_get_user_data_dir());
+    for (auto dirs = g_get_system_data_dirs(); *dirs; dirs++)
+      load_thumbnailers(*dirs);
+  }
+
+  void load_thumbnailers(const char *data_dir) {
+    std::string dir = std::string(data_dir) + "/thumbnailers";
+    GDir *listing = g_dir_open(dir.c_str(), 0, nullptr);
+    if (!listing)
+      return;
+
+    while (const char *name = g_dir_read_name(listing)) {
+      if (!g_str_has_suffix(name, ".thumbnailer"))
+        continue;
+      std::string file = dir + "/" + name;
+      GKeyFile *key_file = g_key_file_new();
+      if (g_key_file_load_from_file(key_file, file.c_str(), G_KEY_FILE_NONE,
+                                    nullptr))
+        add_thumbnailer(key_file);
+      g_key_file_free(key_file);
+    }
+    g_dir_close(listing);
+  }
+
+  void add_thumbnailer(GKeyFile *key_file) {
+    constexpr const char *group = "Thumbnailer Entry";
+    char *try_exec =
+        g_key_file_get_string(key_file, group, "TryExec", nullptr);
+    char *program = try_exec ? g_find_program_in_path(try_exec) : nullptr;
+    char *exec = g_key_file_get_string(key_file, group, "Exec", nullptr);
+    char **types = g_key_file_get_string_list(key_file, group, "MimeType",
+                                              nullptr, nullptr);
+    if (exec && (!try_exec || program)) {
+      for (char **type = types; type && *type; type++)
+        commands_.emplace(*type, exec);
+    }
+    g_strfreev(types);
+    g_free(exec);
+    g_free(program);
+    g_free(try_exec);
+  }
+
+  std::unordered_set<std::string> loaders_;
+  std::unordered_map<std::string, std::string> commands_;
+};
+
+// The Thumb::MTime a cached thumbnail was written for
+std::optional<std::int64_t> thumbnail_mtime(const char *data, gsize size) {
+  constexpr std::string_view signature("\x89PNG\r\n\x1a\n", 8);
+  constexpr std::string_view key("Thumb::MTime\0", 13);
+  std::string_view png(data, size);
+  if (!png.starts_with(signature))
+    return std::nullopt;
+
+  for (std::size_t pos = signature.size(); pos + 12 <= png.size();) {
+    auto *p = reinterpret_cast<const guchar *>(png.data() + pos);
+    std::size_t length = std::size_t(p[0]) << 24 | std::size_t(p[1]) << 16 |
+                         std::size_t(p[2]) << 8 | p[3];
+    if (length > png.size() - pos - 12)
+      break;
+    auto type = png.substr(pos + 4, 4);
+    auto body = png.substr(pos + 8, length);
+    if (type == "IEND")
+      break;
+    if (type == "tEXt" && body.starts_with(key)) {
+      std::int64_t mtime;
+      auto text = body.substr(key.size());
+      auto [end, ec] =
+          std::from_chars(text.data(), text.data() + text.size(), mtime);
+      if (ec == std::errc() && end == text.data() + text.size())
+        return mtime;
+      return std::nullopt;
+    }
+    pos += 12 + length;
+  }
+  return std::nullopt;
+}
+
+GBytes *read_current(const std::string &file, std::int64_t mtime) {
+  char *data;
+  gsize size;
+  if (!g_file_get_contents(file.c_str(), &data, &size, nullptr))
+    return nullptr;
+  if (thumbnail_mtime(data, size) != mtime) {
+    g_free(data);
+    return nullptr;
+  }
+  return g_bytes_new_take(data, size);
+}
+
+GdkPixbuf *run_thumbnailer(const std::string &command, const char *path,
+                           const char *uri) {
+  char *output = nullptr;
+  int fd = g_file_open_tmp("xafile-thumbnail-XXXXXX.png", &output, nullptr);
+  if (fd < 0)
+    return nullptr;
+  close(fd);
+
+  GdkPixbuf *pixbuf = nullptr;
+  int argc;
+  char **argv;
+  if (g_shell_parse_argv(command.c_str(), &argc, &argv, nullptr)) {
+    std::vector<std::string> args;
+    for (int i = 0; i < argc; i++) {
+      std::string arg;
+      for (const char *c = argv[i]; *c; c++) {
+        if (*c != '%' || !c[1]) {
+          arg += *c;
+          continue;
+        }
+        switch (*++c) {
+        case 'i':
+          arg += path;
+          break;
+        case 'u':
+          arg += uri;
+          break;
+        case 'o':
+          arg += output;
+          break;
+        case 's':
+          arg += std::to_string(kSize);
+          break;
+        default:
+          arg += *c;
+          break;
+        }
+      }
+      args.push_back(std::move(arg));
+    }
+    g_strfreev(argv);
+
+    std::vector<char *> spawn_argv;
+    for (auto &arg : args)
+      spawn_argv.push_back(arg.data());
+    spawn_argv.push_back(nullptr);
+
+    int status;
+    if (g_spawn_sync(nullptr, spawn_argv.data(), nullptr,
+                     static_cast<GSpawnFlags>(G_SPAWN_SEARCH_PATH |
+                                              G_SPAWN_STDOUT_TO_DEV_NULL |
+                                              G_SPAWN_STDERR_TO_DEV_NULL),
+                     nullptr, nullptr, nullptr, nullptr, &status, nullptr) &&
+        g_spawn_check_wait_status(status, nullptr))
+      pixbuf =
+          gdk_pixbuf_new_from_file_at_scale(output, kSize, kSize, TRUE, nullptr);
+  }
+
+  unlink(output);
+  g_free(output);
+  return pixbuf;
+}
+
+GdkPixbuf *render(const char *path, const char *uri, std::string_view mime) {
+  const auto &renderers = Renderers::get();
+  if (renderers.has_loader(mime)) {
+    GdkPixbuf *pixbuf =
+        gdk_pixbuf_new_from_file_at_scale(path, kSize, kSize, TRUE, nullptr);
+    if (!pixbuf)
+      return nullptr;
+    GdkPixbuf *oriented = gdk_pixbuf_apply_embedded_orientation(pixbuf);
+    g_object_unref(pixbuf);
+    return oriented;
+  }
+  if (auto *command = renderers.command(mime))
+    return run_thumbnailer(*command, path, uri);
+  return nullptr;
+}
+
+// Encodes with the attributes the spec requires and writes it to `file`
+GBytes *save(GdkPixbuf *pixbuf, const std::string &dir,
+             const std::string &file, const char *uri, std::int64_t mtime) {
+  std::string mtime_text = std::to_string(mtime);
+  char *data;
+  gsize size;
+  if (!gdk_pixbuf_save_to_buffer(pixbuf, &data, &size, "png", nullptr,
+                                 "tEXt::Thumb::URI", uri, "tEXt::Thumb::MTime",
+                                 mtime_text.c_str(), "tEXt::Software",
+                                 "xafile", nullptr))
+    return nullptr;
+
+  g_mkdir_with_parents(dir.c_str(), 0700);
+  g_file_set_contents_full(file.c_str(), data, size,
+                           G_FILE_SET_CONTENTS_CONSISTENT, 0600, nullptr);
+  return g_bytes_new_take(data, size);
+}
+
+} // namespace
+
+Thumbnailer &Thumbnailer::instance() {
+  // The workers never exit, so neither does the instance
+  static auto *thumbnailer = new Thumbnailer(budget_from_env());
+  return *thumbnailer;
+}
+
+bool Thumbnailer::can_thumbnail(Atom content_type) {
+  if (content_type == atoms::kNone)
+    return false;
+  auto [it, inserted] = supported_.try_emplace(content_type, false);
+  if (inserted) {
+    std::string_view mime = atom_string(content_type);
+    const auto &renderers = Renderers::get();
+    it->second = renderers.has_loader(mime) || renderers.command(mime);
+  }
+  return it->second;
+}
+
+GdkTexture *Thumbnailer::lookup(const std::string &path, std::int64_t mtime,
+                                Atom content_type) {
+  if (auto it = index_.find(path); it != index_.end()) {
+    auto slot = it->second;
+    if (slot->mtime == mtime) {
+      lru_.splice(lru_.begin(), lru_, slot);
+      if (slot->texture)
+        stats_.memory_hits++;
+      return slot->texture;
+    }
+    erase(slot);
+  }
+  enqueue({path, mtime, content_type});
+  return nullptr;
+}
+
+void Thumbnailer::enqueue(Request &&request) {
+  std::lock_guard lock(mutex_);
+  auto [it, inserted] = queued_.try_emplace(request.path, 0);
+  // Already being worked on
+  if (!inserted && it->second == 0)
+    return;
+  // Asked for again, so it is back on screen: queued again at the back,
+  // and the copy further down is skipped once it comes up
+  it->second = request.generation = ++last_generation_;
+  queue_.push_back(std::move(request));
+  if (queue_.size() > 2 * queued_.size() + kMaxStaleRequests)
+    drop_stale_requests();
+
+  if (!workers_started_) {
+    workers_started_ = true;
+    for (unsigned i = 0; i < kWorkers; i++)
+      std::thread([this] { run(); }).detach();
+  }
+  wake_.notify_one();
+}
+
+void Thumbnailer::withdraw(const std::string &path) {
+  std::lock_guard lock(mutex_);
+  // The request itself stays in the queue and is skipped
+  auto it = queued_.find(path);
+  if (it == queued_.end() || it->second == 0)
+    return;
+  queued_.erase(it);
+  stats_.withdrawn++;
+}
+
+void Thumbnailer::withdraw_directory(const std::string &directory) {
+  std::string dir = directory;
+  if (dir.empty() || dir.back() != '/')
+    dir += '/';
+
+  std::lock_guard lock(mutex_);
+  std::erase_if(queue_, [&](const Request &r) {
+    if (!in_directory(r.path, dir))
+      return false;
+    if (is_current(r)) {
+      queued_.erase(r.path);
+      stats_.withdrawn++;
+    }
+    return true;
+  });
+}
+
+bool Thumbnailer::is_current(const Request &request) const {
+  auto it = queued_.find(request.path);
+  return it != queued_.end() && it->second == request.generation;
+}
+
+void Thumbnailer::drop_stale_requests() {
+  std::erase_if(queue_, [this](const Request &r) { return !is_current(r); });
+}
+
+std::size_t Thumbnailer::connect(ReadyCallback callback) {
+  listeners_.emplace_back(next_listener_, std::move(callback));
+  return next_listener_++;
+}
+
+void Thumbnailer::disconnect(std::size_t id) {
+  std::erase_if(listeners_, [id](const auto &l) { return l.first == id; });
+}
+
+Thumbnailer::Stats Thumbnailer::stats() const {
+  Stats stats = stats_;
+  stats.entries = lru_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
+void Thumbnailer::run() {
+  for (;;) {
+    Request request;
+    {
+      std::unique_lock lock(mutex_);
+      for (;;) {
+        wake_.wait(lock, [this] { return !queue_.empty(); });
+        request = std::move(queue_.back());
+        queue_.pop_back();
+        // Otherwise withdrawn, or queued again further up
+        if (is_current(request))
+          break;
+      }
+      queued_[request.path] = 0;
+    }
+
+    Result result{request.path, request.mtime, nullptr, Source::Failed};
+    char *uri = g_filename_to_uri(request.path.c_str(), nullptr, nullptr);
+    if (!uri) {
+      push(std::move(result));
+      continue;
+    }
+
+    char *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri, -1);
+    std::string name = std::string(md5) + ".png";
+    g_free(md5);
+    std::string normal_dir = cache_dir("normal");
+    std::string fail_dir = cache_dir(kFailDir);
+    std::string normal = normal_dir + "/" + name;
+    std::string fail = fail_dir + "/" + name;
+
+    GBytes *png = read_current(normal, request.mtime);
+    if (png) {
+      result.source = Source::Disk;
+    } else if (GBytes *failed = read_current(fail, request.mtime)) {
+      g_bytes_unref(failed);
+    } else if (GdkPixbuf *pixbuf = render(request.path.c_str(), uri,
+                                          atom_string(request.content_type))) {
+      png = save(pixbuf, normal_dir, normal, uri, request.mtime);
+      g_object_unref(pixbuf);
+      result.source = Source::Generated;
+    } else {
+      // A 1x1 placeholder keeps us and other programs from retrying
+      GdkPixbuf *placeholder =
+          gdk_pixbuf_new(GDK_COLORSPACE_RGB, TRUE, 8, 1, 1);
+      gdk_pixbuf_fill(placeholder, 0);
+      if (GBytes *bytes = save(placeholder, fail_dir, fail, uri, request.mtime))
+        g_bytes_unref(bytes);
+      g_object_unref(placeholder);
+    }
+    g_free(uri);
+
+    if (png) {
+      result.texture = gdk_texture_new_from_bytes(png, nullptr);
+      g_bytes_unref(png);
+      if (!result.texture)
+        result.source = Source::Failed;
+    }
+    push(std::move(result));
+  }
+}
+
+void Thumbnailer::push(Result &&result) {
+  std::lock_guard lock(mutex_);
+  queued_.erase(result.path);
+  results_.push_back(std::move(result));
+  if (!dispatch_scheduled_) {
+    dispatch_scheduled_ = true;
+    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, dispatch, this, nullptr);
+  }
+}
+
+gboolean Thumbnailer::dispatch(gpointer user_data) {
+  auto *self = static_cast<Thumbnailer *>(user_data);
+  std::vector<Result> results;
+  {
+    std::lock_guard lock(self->mutex_);
+    results.swap(self->results_);
+    self->dispatch_scheduled_ = false;
+  }
+
+  for (auto &result : results) {
+    std::string path = result.path;
+    self->store(std::move(result));
+    for (const auto &[id, callback] : self->listeners_)
+      callback(path);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+void Thumbnailer::store(Result &&result) {
+  switch (result.source) {
+  case Source::Disk:
+    stats_.disk_hits++;
+    break;
+  case Source::Generated:
+    stats_.generated++;
+    break;
+  case Source::Failed:
+    stats_.failed++;
+    break;
+  }
+
+  if (auto it = index_.find(result.path); it != index_.end())
+    erase(it->second);
+
+  std::size_t bytes = kFailedSlotBytes;
+  if (result.texture)
+    bytes += std::size_t(gdk_texture_get_width(result.texture)) *
+             gdk_texture_get_height(result.texture) * 4;
+  lru_.push_front({std::move(result.path), result.mtime, result.texture, bytes});
+  index_.emplace(lru_.front().path, lru_.begin());
+  bytes_ += bytes;
+
+  while (bytes_ > budget_ && lru_.size() > 1)
+    erase(std::prev(lru_.end()));
+}
+
+void Thumbnailer::erase(std::list<Slot>::iterator slot) {
+  bytes_ -= slot->bytes;
+  if (slot->texture)
+    g_object_unref(slot->texture);
+  index_.erase(slot->path);
+  lru_.erase(slot);
+}
+
+} // namespace xafile
@@ -0,0 +1,131 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "utility/atoms.hpp"
+#include <gtk/gtk.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace xafile {
+
+// Thumbnails images, and anything a freedesktop thumbnailer is installed
+// for, on two worker threads. Generated images go to the shared
+// ~/.cache/thumbnails store, decoded textures to an LRU bounded by
+// XAFILE_THUMBNAIL_CACHE_MB (32 MiB by default). Only requests that have
+// not been withdrawn are worked on, the most recent one first.
+//
+// Apart from the workers everything runs on the main thread.
+class Thumbnailer {
+public:
+  using ReadyCallback = std::function<void(const std::string &path)>;
+
+  struct Stats {
+    std::uint64_t memory_hits = 0;
+    std::uint64_t disk_hits = 0;
+    std::uint64_t generated = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t withdrawn = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+  };
+
+  static Thumbnailer &instance();
+
+  bool can_thumbnail(Atom content_type);
+  // Returns the texture if an up to date one is cached, otherwise queues
+  // the file and returns nullptr. The cache keeps the reference.
+  GdkTexture *lookup(const std::string &path, std::int64_t mtime,
+                     Atom content_type);
+  // Forgets a queued request, e.g. because its row scrolled out of view
+  void withdraw(const std::string &path);
+  // Forgets every queued request for files directly inside `directory`
+  void withdraw_directory(const std::string &directory);
+
+  // Callbacks run once a requested thumbnail is ready or has failed
+  std::size_t connect(ReadyCallback callback);
+  void disconnect(std::size_t id);
+
+  Stats stats() const;
+
+private:
+  enum class Source : std::uint8_t { Disk, Generated, Failed };
+
+  struct Request {
+    std::string path;
+    std::int64_t mtime;
+    Atom content_type;
+    std::uint64_t generation = 0; // set when queued
+  };
+  struct Result {
+    std::string path;
+    std::int64_t mtime;
+    GdkTexture *texture; // owned, nullptr when it failed
+    Source source;
+  };
+  struct Slot {
+    std::string path;
+    std::int64_t mtime;
+    GdkTexture *texture;
+    std::size_t bytes;
+  };
+
+  explicit Thumbnailer(std::size_t budget_bytes) : budget_(budget_bytes) {}
+
+  void enqueue(Request &&request);
+  bool is_current(const Request &request) const;
+  void drop_stale_requests();
+  void run();
+  void push(Result &&result);
+  static gboolean dispatch(gpointer user_data);
+  void store(Result &&result);
+  void erase(std::list<Slot>::iterator slot);
+
+  std::list<Slot> lru_; // most recently used first
+  std::unordered_map<std::string, std::list<Slot>::iterator> index_;
+  std::size_t budget_;
+  std::size_t bytes_ = 0;
+  Stats stats_;
+  std::unordered_map<Atom, bool> supported_;
+  std::vector<std::pair<std::size_t, ReadyCallback>> listeners_;
+  std::size_t next_listener_ = 1;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  // Served from the back. A file asked for again is pushed again, and
+  // whichever copy no longer matches queued_ is skipped.
+  std::vector<Request> queue_;
+  // Path -> generation of its live request, 0 while a worker has it
+  std::unordered_map<std::string, std::uint64_t> queued_;
+  std::uint64_t last_generation_ = 0;
+  std::vector<Result> results_;
+  bool dispatch_scheduled_ = false;
+  bool workers_started_ = false;
+};
+
+} // namespace xafile
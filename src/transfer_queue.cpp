@@ -0,0 +1,534 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "transfer_queue.hpp"
+#include "utility/dir_reader.hpp"
+#include "utility/file_copy.hpp"
+#include "utility/trash.hpp"
+#include "utility/tree_remover.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr guint kPollIntervalMs = 100;
+// Enough to keep the disk busy while other workers open and close small
+// files; large files are not split, so more would not help them
+constexpr std::size_t kWorkers = 4;
+// Errors past this many are only counted
+constexpr std::size_t kMaxErrors = 100;
+
+std::string_view base_name(std::string_view path) {
+  while (path.size() > 1 && path.back() == '/')
+    path.remove_suffix(1);
+  auto slash = path.rfind('/');
+  return slash == std::string_view::npos ? path : path.substr(slash + 1);
+}
+
+std::string join(std::string_view dir, std::string_view name) {
+  std::string path(dir);
+  if (path.empty() || path.back() != '/')
+    path += '/';
+  path += name;
+  return path;
+}
+
+// "name.ext", then "name (copy).ext", "name (copy 2).ext" and so on
+std::string unique_destination(std::string_view dir, std::string_view name,
+                               bool is_directory) {
+  auto path = join(dir, name);
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0)
+    return path;
+
+  auto dot = is_directory ? std::string_view::npos : name.rfind('.');
+  if (dot == 0)
+    dot = std::string_view::npos;
+  auto stem = name.substr(0, dot);
+  auto extension = dot == std::string_view::npos ? "" : name.substr(dot);
+  for (int n = 1;; n++) {
+    std::string candidate(stem);
+    candidate += n == 1 ? " (copy)" : " (copy " + std::to_string(n) + ")";
+    candidate += extension;
+    path = join(dir, candidate);
+    if (lstat(path.c_str(), &st) != 0)
+      return path;
+  }
+}
+
+} // namespace
+
+struct TransferQueue::Job {
+  std::uint64_t id;
+  TransferKind kind;
+  std::vector<std::string> sources;
+  std::string destination;
+
+  std::atomic<bool> cancelled{false};
+  std::atomic<std::uint64_t> bytes_done{0};
+  std::atomic<std::uint64_t> bytes_total{0};
+  std::atomic<std::uint32_t> items_done{0};
+  std::atomic<std::uint32_t> items_total{0};
+
+  std::mutex errors_mutex;
+  std::vector<std::string> errors;
+  std::size_t error_count = 0;
+
+  void fail(const std::string &path, int error) {
+    std::cerr << path << ": " << std::strerror(error) << '\n';
+    std::lock_guard lock(errors_mutex);
+    if (++error_count <= kMaxErrors)
+      errors.push_back(path + ": " + std::strerror(error));
+  }
+};
+
+struct TransferQueue::Item {
+  std::string from;
+  std::string to;
+  struct stat st;
+};
+
+TransferQueue &TransferQueue::instance() {
+  // The worker never exits, so neither does the instance
+  static auto *queue = new TransferQueue();
+  return *queue;
+}
+
+std::uint64_t TransferQueue::enqueue(TransferKind kind,
+                                     std::vector<std::string> sources,
+                                     std::string destination) {
+  auto job = std::make_shared<Job>();
+  job->id = next_id_++;
+  job->kind = kind;
+  job->sources = std::move(sources);
+  job->destination = std::move(destination);
+  {
+    std::lock_guard lock(mutex_);
+    queue_.push_back(job);
+    if (!worker_started_) {
+      worker_started_ = true;
+      std::thread([this] { run(); }).detach();
+    }
+  }
+  wake_.notify_one();
+  if (poll_source_ == 0)
+    poll_source_ = g_timeout_add(kPollIntervalMs, poll, this);
+  return job->id;
+}
+
+void TransferQueue::cancel(std::uint64_t id) {
+  std::lock_guard lock(mutex_);
+  if (current_ && current_->id == id)
+    current_->cancelled = true;
+  for (auto &job : queue_)
+    if (job->id == id)
+      job->cancelled = true;
+}
+
+std::size_t TransferQueue::connect(ProgressCallback callback) {
+  listeners_.emplace_back(next_listener_, std::move(callback));
+  return next_listener_++;
+}
+
+void TransferQueue::disconnect(std::size_t id) {
+  std::erase_if(listeners_,
+                [id](const auto &listener) { return listener.first == id; });
+}
+
+void TransferQueue::run() {
+  for (;;) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock lock(mutex_);
+      wake_.wait(lock, [this] { return !queue_.empty(); });
+      job = std::move(queue_.front());
+      queue_.pop_front();
+      current_ = job;
+    }
+    if (!job->cancelled)
+      execute(*job);
+    {
+      std::lock_guard lock(mutex_);
+      current_.reset();
+      done_.push_back(std::move(job));
+    }
+  }
+}
+
+void TransferQueue::execute(Job &job) {
+  switch (job.kind) {
+  case TransferKind::Trash:
+    trash(job);
+    break;
+  case TransferKind::Delete:
+    remove(job, job.sources);
+    break;
+  default:
+    transfer(job);
+  }
+}
+
+void TransferQueue::transfer(Job &job) {
+  // For a move, only what a rename could not move ends up in here
+  std::vector<Item> items;
+  std::vector<std::string> copied_sources;
+
+  for (const auto &source : job.sources) {
+    if (job.cancelled)
+      return;
+    struct stat st;
+    if (lstat(source.c_str(), &st) != 0) {
+      job.fail(source, errno);
+      continue;
+    }
+    bool is_directory = S_ISDIR(st.st_mode);
+    auto name = base_name(source);
+
+    // A folder cannot go inside itself
+    auto inside = join(source, "");
+    if (is_directory && join(job.destination, "").starts_with(inside)) {
+      job.fail(source, EINVAL);
+      continue;
+    }
+
+    if (job.kind == TransferKind::Move) {
+      job.items_total++;
+      // Already where it should be
+      if (join(job.destination, name) == source) {
+        job.items_done++;
+        continue;
+      }
+      auto to = unique_destination(job.destination, name, is_directory);
+      if (renameat2(AT_FDCWD, source.c_str(), AT_FDCWD, to.c_str(),
+                    RENAME_NOREPLACE) == 0) {
+        job.items_done++;
+        job.bytes_done += S_ISREG(st.st_mode) ? st.st_size : 0;
+        job.bytes_total += S_ISREG(st.st_mode) ? st.st_size : 0;
+        continue;
+      }
+      if (errno != EXDEV) {
+        job.fail(source, errno);
+        continue;
+      }
+      // Another filesystem: copied, then removed below
+      job.items_total--;
+      plan(job, source, to, items);
+      copied_sources.push_back(source);
+      continue;
+    }
+
+    plan(job, source, unique_destination(job.destination, name, is_directory),
+         items);
+  }
+
+  if (job.cancelled)
+    return;
+  copy_items(job, items);
+
+  // Sources copied across filesystems go only when all of them arrived
+  if (job.kind != TransferKind::Move || job.cancelled || job.error_count > 0)
+    return;
+  remove(job, copied_sources);
+}
+
+void TransferQueue::trash(Job &job) {
+  // One batch per filesystem, in the order the devices first show up
+  std::vector<std::pair<dev_t, std::vector<std::string>>> groups;
+  for (const auto &source : job.sources) {
+    struct stat st;
+    if (lstat(source.c_str(), &st) != 0) {
+      job.fail(source, errno);
+      continue;
+    }
+    job.items_total++;
+    auto group = std::find_if(groups.begin(), groups.end(), [&](auto &g) {
+      return g.first == st.st_dev;
+    });
+    if (group == groups.end())
+      group = groups.insert(groups.end(), {st.st_dev, {}});
+    group->second.push_back(source);
+  }
+
+  for (auto &[dev, paths] : groups) {
+    if (job.cancelled)
+      return;
+    auto dir = trash_for(paths.front(), dev);
+    bool copy = !dir;
+    // A filesystem without a trash of its own is copied into the home one
+    if (copy)
+      dir = home_trash();
+    if (!dir) {
+      for (const auto &path : paths)
+        job.fail(path, ENOTSUP);
+      continue;
+    }
+    TrashBatch batch(std::move(*dir));
+    if (batch.error() != 0) {
+      for (const auto &path : paths)
+        job.fail(path, batch.error());
+      continue;
+    }
+
+    // Every .trashinfo is written and synced before anything moves, so
+    // nothing ends up in the trash without one
+    std::vector<std::pair<std::string, std::string>> reserved;
+    for (const auto &path : paths) {
+      int error = 0;
+      if (auto name = batch.reserve(path, error))
+        reserved.emplace_back(path, std::move(*name));
+      else
+        job.fail(path, error);
+    }
+    batch.sync();
+
+    if (!copy) {
+      for (const auto &[path, name] : reserved) {
+        int error = job.cancelled ? ECANCELED : batch.move_in(path, name);
+        if (error != 0) {
+          batch.release(name);
+          if (error != ECANCELED)
+            job.fail(path, error);
+          continue;
+        }
+        job.items_done++;
+      }
+      continue;
+    }
+
+    job.items_total -= reserved.size();
+    std::vector<Item> items;
+    std::vector<std::string> sources, copies;
+    for (const auto &[path, name] : reserved) {
+      plan(job, path, batch.file_path(name), items);
+      sources.push_back(path);
+      copies.push_back(batch.file_path(name));
+    }
+    auto errors = job.error_count;
+    if (!job.cancelled)
+      copy_items(job, items);
+    if (!job.cancelled && job.error_count == errors) {
+      remove(job, sources);
+      continue;
+    }
+    // Half copied files are taken back out of the trash, even when the
+    // job was cancelled
+    std::atomic<bool> keep_going{false};
+    TreeRemover(
+        keep_going, [](std::uint64_t) {}, [](std::uint64_t) {},
+        [&job](const std::string &path, int error) { job.fail(path, error); })
+        .remove(copies);
+    for (const auto &[path, name] : reserved)
+      batch.release(name);
+  }
+}
+
+void TransferQueue::remove(Job &job, const std::vector<std::string> &paths) {
+  // Only a deletion counts what it removes; for the others, it is cleanup
+  bool counted = job.kind == TransferKind::Delete;
+  TreeRemover remover(
+      job.cancelled,
+      [&job, counted](std::uint64_t count) {
+        if (counted)
+          job.items_total += count;
+      },
+      [&job, counted](std::uint64_t count) {
+        if (counted)
+          job.items_done += count;
+      },
+      [&job](const std::string &path, int error) { job.fail(path, error); });
+  remover.remove(paths);
+}
+
+// Lists `from` and everything below it, directories before their contents
+void TransferQueue::plan(Job &job, const std::string &from,
+                         const std::string &to, std::vector<Item> &items) {
+  Item item{from, to, {}};
+  if (lstat(from.c_str(), &item.st) != 0) {
+    job.fail(from, errno);
+    return;
+  }
+  bool is_directory = S_ISDIR(item.st.st_mode);
+  if (S_ISREG(item.st.st_mode))
+    job.bytes_total += item.st.st_size;
+  job.items_total++;
+  items.push_back(std::move(item));
+  if (!is_directory)
+    return;
+
+  DirReader reader(from.c_str());
+  if (!reader.is_open()) {
+    job.fail(from, reader.error());
+    return;
+  }
+  std::vector<DirEntry> entries;
+  std::vector<std::string> names;
+  while (reader.read(entries))
+    for (const auto &e : entries)
+      names.emplace_back(e.name);
+  if (reader.error() != 0)
+    job.fail(from, reader.error());
+  for (const auto &name : names) {
+    if (job.cancelled)
+      return;
+    plan(job, join(from, name), join(to, name), items);
+  }
+}
+
+void TransferQueue::copy_items(Job &job, const std::vector<Item> &items) {
+  // Directories first, writable by us until their contents are in
+  std::vector<bool> failed_dirs(items.size(), false);
+  for (std::size_t i = 0; i < items.size(); i++) {
+    const auto &item = items[i];
+    if (!S_ISDIR(item.st.st_mode))
+      continue;
+    if (mkdir(item.to.c_str(), 0700) != 0) {
+      job.fail(item.to, errno);
+      failed_dirs[i] = true;
+    }
+    job.items_done++;
+  }
+
+  std::atomic<std::size_t> next{0};
+  auto work = [&] {
+    std::size_t i;
+    while ((i = next.fetch_add(1)) < items.size()) {
+      if (job.cancelled)
+        return;
+      const auto &item = items[i];
+      int error = 0;
+      if (S_ISDIR(item.st.st_mode)) {
+        continue;
+      } else if (S_ISREG(item.st.st_mode)) {
+        error = copy_regular_file(item.from.c_str(), item.to.c_str(), item.st,
+                                  job.cancelled, [&](std::uint64_t bytes) {
+                                    job.bytes_done += bytes;
+                                  })
+                    .error;
+      } else if (S_ISLNK(item.st.st_mode)) {
+        error = copy_symlink(item.from.c_str(), item.to.c_str());
+      } else {
+        // Sockets, fifos and devices are not copied
+        error = ENOTSUP;
+      }
+      // Files that vanished meanwhile, or sit in a folder that could not
+      // be created, are skipped
+      if (error != 0 && error != ECANCELED && error != ENOENT)
+        job.fail(item.from, error);
+      job.items_done++;
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t i = 1; i < kWorkers; i++)
+      workers.emplace_back(work);
+    work();
+  }
+
+  // Permissions and dates last, innermost first, so writing into them
+  // does not change them again
+  for (std::size_t i = items.size(); i-- > 0;) {
+    const auto &item = items[i];
+    if (!S_ISDIR(item.st.st_mode) || failed_dirs[i])
+      continue;
+    chmod(item.to.c_str(), item.st.st_mode & 07777);
+    struct timespec times[2] = {item.st.st_atim, item.st.st_mtim};
+    utimensat(AT_FDCWD, item.to.c_str(), times, 0);
+  }
+}
+
+TransferProgress TransferQueue::snapshot(Job &job) {
+  TransferProgress progress;
+  progress.id = job.id;
+  progress.kind = job.kind;
+  progress.bytes_done = job.bytes_done;
+  progress.bytes_total = job.bytes_total;
+  progress.items_done = job.items_done;
+  progress.items_total = job.items_total;
+  progress.cancelled = job.cancelled;
+
+  auto now = std::chrono::steady_clock::now();
+  if (rate_job_ != job.id) {
+    rate_job_ = job.id;
+    rate_bytes_ = 0;
+    rate_time_ = now;
+    rate_ = 0;
+  }
+  std::chrono::duration<double> elapsed = now - rate_time_;
+  if (elapsed.count() > 0) {
+    double current = (progress.bytes_done - rate_bytes_) / elapsed.count();
+    rate_ = rate_ == 0 ? current : 0.7 * rate_ + 0.3 * current;
+  }
+  rate_bytes_ = progress.bytes_done;
+  rate_time_ = now;
+  progress.bytes_per_second = rate_;
+  return progress;
+}
+
+gboolean TransferQueue::poll(gpointer user_data) {
+  auto *self = static_cast<TransferQueue *>(user_data);
+  std::vector<std::shared_ptr<Job>> done;
+  std::shared_ptr<Job> current;
+  std::size_t queued;
+  {
+    std::lock_guard lock(self->mutex_);
+    done.swap(self->done_);
+    current = self->current_;
+    queued = self->queue_.size();
+  }
+
+  std::vector<TransferProgress> updates;
+  for (auto &job : done) {
+    auto progress = self->snapshot(*job);
+    progress.finished = true;
+    progress.queued = queued + (current ? 1 : 0);
+    std::lock_guard lock(job->errors_mutex);
+    progress.errors = std::move(job->errors);
+    if (job->error_count > progress.errors.size())
+      progress.errors.push_back(
+          std::to_string(job->error_count - progress.errors.size()) +
+          " more errors");
+    updates.push_back(std::move(progress));
+  }
+  if (current) {
+    updates.push_back(self->snapshot(*current));
+    updates.back().queued = queued;
+  }
+
+  // Listeners may enqueue more work
+  auto listeners = self->listeners_;
+  for (const auto &progress : updates)
+    for (const auto &listener : listeners)
+      listener.second(progress);
+
+  std::lock_guard lock(self->mutex_);
+  if (self->current_ || !self->queue_.empty() || !self->done_.empty())
+    return G_SOURCE_CONTINUE;
+  self->poll_source_ = 0;
+  return G_SOURCE_REMOVE;
+}
+
+} // namespace xafile
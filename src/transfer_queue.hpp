@@ -0,0 +1,113 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+enum class TransferKind : std::uint8_t { Copy, Move, Trash, Delete };
+
+struct TransferProgress {
+  std::uint64_t id = 0;
+  TransferKind kind = TransferKind::Copy;
+  std::uint64_t bytes_done = 0;
+  std::uint64_t bytes_total = 0;
+  std::uint32_t items_done = 0;
+  std::uint32_t items_total = 0;
+  double bytes_per_second = 0;
+  std::size_t queued = 0; // jobs waiting behind this one
+  bool finished = false;
+  bool cancelled = false;
+  std::vector<std::string> errors; // set once finished
+};
+
+// Copies, moves, trashes and deletes files in the background, one job
+// after another. Moves within a filesystem are a rename, and so is moving
+// to the trash of the file's own filesystem. Everything else is copied by
+// a few workers sharing the job's files, so many small files overlap their
+// opens and closes, and large ones are cloned or copied in the kernel
+// (see copy_contents). Deleting, and removing what a move copied, is done
+// by a TreeRemover. Listeners hear about the running job about ten times a
+// second, on the main thread.
+class TransferQueue {
+public:
+  using ProgressCallback = std::function<void(const TransferProgress &)>;
+
+  static TransferQueue &instance();
+
+  // Copies or moves `sources` into the directory `destination`. A name
+  // that is already taken there gets a " (copy)" suffix. Trash and Delete
+  // ignore `destination`.
+  std::uint64_t enqueue(TransferKind kind, std::vector<std::string> sources,
+                        std::string destination);
+  // Stops a queued or running job; files already done are kept
+  void cancel(std::uint64_t id);
+
+  std::size_t connect(ProgressCallback callback);
+  void disconnect(std::size_t id);
+
+private:
+  struct Job;
+  struct Item;
+
+  TransferQueue() = default;
+
+  void run();
+  void execute(Job &job);
+  void transfer(Job &job);
+  void trash(Job &job);
+  void remove(Job &job, const std::vector<std::string> &paths);
+  void plan(Job &job, const std::string &from, const std::string &to,
+            std::vector<Item> &items);
+  void copy_items(Job &job, const std::vector<Item> &items);
+  static gboolean poll(gpointer user_data);
+  TransferProgress snapshot(Job &job);
+
+  std::vector<std::pair<std::size_t, ProgressCallback>> listeners_;
+  std::size_t next_listener_ = 1;
+  std::uint64_t next_id_ = 1;
+  guint poll_source_ = 0;
+
+  // Throughput, smoothed across polls of the running job
+  std::uint64_t rate_job_ = 0;
+  std::uint64_t rate_bytes_ = 0;
+  std::chrono::steady_clock::time_point rate_time_;
+  double rate_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::shared_ptr<Job>> queue_;
+  std::shared_ptr<Job> current_;
+  std::vector<std::shared_ptr<Job>> done_;
+  bool worker_started_ = false;
+};
+
+} // namespace xafile
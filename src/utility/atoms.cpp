@@ -0,0 +1,74 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "atoms.hpp"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace xafile {
+
+namespace {
+
+constexpr std::size_t kMaxAtoms = 1 << 16;
+
+struct AtomTable {
+  std::mutex mutex;
+  std::deque<std::string> storage;
+  std::unordered_map<std::string_view, Atom> ids;
+  // Fixed size so lookups never race with a reallocation
+  std::unique_ptr<const char *[]> strings{new const char *[kMaxAtoms]};
+  std::size_t count = 0;
+
+  AtomTable() {
+    for (const char *s : {"", "folder-symbolic", "Folder", "text-x-generic",
+                          "file"})
+      add(s);
+  }
+
+  Atom add(std::string_view str) {
+    const auto &stored = storage.emplace_back(str);
+    auto atom = static_cast<Atom>(count++);
+    strings[atom] = stored.c_str();
+    ids.emplace(stored, atom);
+    return atom;
+  }
+};
+
+AtomTable &table() {
+  static AtomTable instance;
+  return instance;
+}
+
+} // namespace
+
+Atom atom_intern(std::string_view str) {
+  auto &t = table();
+  std::lock_guard lock(t.mutex);
+  if (auto it = t.ids.find(str); it != t.ids.end())
+    return it->second;
+  if (t.count == kMaxAtoms)
+    return atoms::kNone;
+  return t.add(str);
+}
+
+const char *atom_string(Atom atom) { return table().strings[atom]; }
+
+} // namespace xafile
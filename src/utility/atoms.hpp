@@ -0,0 +1,42 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace xafile {
+
+// Small ids for strings that repeat across a listing (icon names, file
+// types). Interning is thread-safe and the strings live for the whole
+// process, so atom_string() can be handed straight to GTK.
+using Atom = std::uint16_t;
+
+namespace atoms {
+inline constexpr Atom kNone = 0;
+inline constexpr Atom kFolderIcon = 1;
+inline constexpr Atom kFolderType = 2;
+inline constexpr Atom kFileIcon = 3;
+inline constexpr Atom kFileType = 4;
+} // namespace atoms
+
+Atom atom_intern(std::string_view str);
+const char *atom_string(Atom atom);
+
+} // namespace xafile
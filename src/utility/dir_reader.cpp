@@ -0,0 +1,203 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "dir_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <functional>
+#include <linux/magic.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+struct linux_dirent64 {
+  std::uint64_t d_ino;
+  std::int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+bool is_dot_or_dotdot(const char *name) {
+  return name[0] == '.' &&
+         (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+EntryKind kind_from_mode(mode_t mode) {
+  if (S_ISDIR(mode))
+    return EntryKind::Directory;
+  if (S_ISREG(mode))
+    return EntryKind::Regular;
+  return EntryKind::Other;
+}
+
+} // namespace
+
+DirReader::DirReader(const char *path) : DirReader(AT_FDCWD, path) {}
+
+DirReader::DirReader(int dir_fd, const char *path) {
+  int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+  if (dir_fd != AT_FDCWD)
+    flags |= O_NOFOLLOW;
+  fd_ = openat(dir_fd, path, flags);
+  if (fd_ < 0) {
+    error_ = errno;
+    return;
+  }
+  buffer_.reset(new char[kBufferSize]);
+}
+
+DirReader::~DirReader() {
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool DirReader::read(std::vector<DirEntry> &entries) {
+  entries.clear();
+  if (fd_ < 0)
+    return false;
+
+  // A buffer may hold nothing but "." and "..", keep reading until there is
+  // something to hand out.
+  while (entries.empty()) {
+    long n = syscall(SYS_getdents64, fd_, buffer_.get(), kBufferSize);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      error_ = errno;
+      return false;
+    }
+    if (n == 0)
+      return false;
+
+    std::vector<std::size_t> unresolved;
+    for (long pos = 0; pos < n;) {
+      auto *d = reinterpret_cast<linux_dirent64 *>(buffer_.get() + pos);
+      pos += d->d_reclen;
+      if (is_dot_or_dotdot(d->d_name))
+        continue;
+
+      DirEntry entry{std::string_view(d->d_name), d->d_ino, EntryKind::Other,
+                     d->d_type == DT_LNK};
+      switch (d->d_type) {
+      case DT_DIR:
+        entry.kind = EntryKind::Directory;
+        break;
+      case DT_REG:
+        entry.kind = EntryKind::Regular;
+        break;
+      case DT_LNK:
+      case DT_UNKNOWN:
+        unresolved.push_back(entries.size());
+        break;
+      default:
+        break;
+      }
+      entries.push_back(entry);
+    }
+
+    // Names are NUL terminated inside the buffer, so they can be passed to
+    // fstatat directly.
+    for (auto i : unresolved) {
+      struct stat st;
+      auto &entry = entries[i];
+      // DT_UNKNOWN does not say whether the entry itself is a link
+      int flags = entry.is_symlink ? 0 : AT_SYMLINK_NOFOLLOW;
+      if (fstatat(fd_, entry.name.data(), &st, flags) != 0)
+        continue;
+      if (S_ISLNK(st.st_mode)) {
+        entry.is_symlink = true;
+        if (fstatat(fd_, entry.name.data(), &st, 0) != 0)
+          continue;
+      }
+      entry.kind = kind_from_mode(st.st_mode);
+    }
+  }
+  return true;
+}
+
+HiddenNames HiddenNames::read(int dir_fd) {
+  // Anything larger is not a list of names someone wrote by hand
+  constexpr std::size_t kMaxSize = 256 * 1024;
+
+  HiddenNames hidden;
+  int fd = openat(dir_fd, ".hidden", O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd < 0)
+    return hidden;
+  std::string contents;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = ::read(fd, buffer, sizeof(buffer))) > 0 &&
+         contents.size() < kMaxSize)
+    contents.append(buffer, n);
+  close(fd);
+
+  std::string_view rest(contents);
+  while (!rest.empty()) {
+    auto end = rest.find('\n');
+    auto line = rest.substr(0, end);
+    rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (!line.empty())
+      hidden.names_.emplace_back(line);
+  }
+  std::sort(hidden.names_.begin(), hidden.names_.end());
+  return hidden;
+}
+
+bool HiddenNames::contains(std::string_view name) const {
+  return std::binary_search(names_.begin(), names_.end(), name,
+                            std::less<>());
+}
+
+// Kernel interfaces that look like directories but hold no user files, and
+// some of which never end (/proc/self/...).
+bool is_pseudo_filesystem(int fd) {
+  struct statfs fs;
+  if (fstatfs(fd, &fs) != 0)
+    return false;
+  switch (static_cast<unsigned long>(fs.f_type)) {
+  case PROC_SUPER_MAGIC:
+  case SYSFS_MAGIC:
+  case DEVPTS_SUPER_MAGIC:
+  case CGROUP_SUPER_MAGIC:
+  case CGROUP2_SUPER_MAGIC:
+  case DEBUGFS_MAGIC:
+  case TRACEFS_MAGIC:
+  case SECURITYFS_MAGIC:
+  case SELINUX_MAGIC:
+  case BPF_FS_MAGIC:
+  case PSTOREFS_MAGIC:
+  case EFIVARFS_MAGIC:
+  case BINFMTFS_MAGIC:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // namespace xafile
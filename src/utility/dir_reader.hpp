@@ -0,0 +1,94 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+enum class EntryKind : std::uint8_t { Directory, Regular, Other };
+
+struct DirEntry {
+  std::string_view name; // points into the reader's buffer
+  std::uint64_t inode;
+  EntryKind kind;
+  bool is_symlink; // kind is that of the target
+};
+
+// Reads a directory with large getdents64 calls. Entries are classified from
+// d_type; only DT_UNKNOWN and symlinks are resolved with fstatat, once per
+// buffer, so symlinks to directories still count as directories.
+class DirReader {
+public:
+  explicit DirReader(const char *path);
+  // Opens `path` relative to `dir_fd`, without following a final symlink
+  DirReader(int dir_fd, const char *path);
+  ~DirReader();
+
+  DirReader(const DirReader &) = delete;
+  DirReader &operator=(const DirReader &) = delete;
+
+  bool is_open() const { return fd_ >= 0; }
+  int error() const { return error_; }
+  int fd() const { return fd_; }
+  // Hands the open directory over to the caller, who has to close it.
+  // Nothing more can be read afterwards.
+  int release_fd() {
+    int fd = fd_;
+    fd_ = -1;
+    return fd;
+  }
+
+  // Replaces `entries` with the next chunk of the directory, without "." and
+  // "..". Names stay valid until the next call. Returns false once the
+  // directory is exhausted or an error occurred.
+  bool read(std::vector<DirEntry> &entries);
+
+private:
+  static constexpr std::size_t kBufferSize = 128 * 1024;
+
+  int fd_ = -1;
+  int error_ = 0;
+  std::unique_ptr<char[]> buffer_;
+};
+
+// Names a directory's .hidden file asks file managers not to show, one per
+// line, as understood by GNOME Files and others
+class HiddenNames {
+public:
+  // Reads .hidden from the open directory `dir_fd`; empty when there is none
+  static HiddenNames read(int dir_fd);
+
+  bool empty() const { return names_.empty(); }
+  bool contains(std::string_view name) const;
+
+private:
+  std::vector<std::string> names_; // sorted
+};
+
+// Whether the open directory `fd` is on proc, sysfs or a similar kernel
+// filesystem that recursive walks should stay out of
+bool is_pseudo_filesystem(int fd);
+
+} // namespace xafile
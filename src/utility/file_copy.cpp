@@ -0,0 +1,237 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "file_copy.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <memory>
+#include <string>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+// Progress and cancellation are looked at between chunks of this size
+constexpr std::uint64_t kChunk = 8 << 20;
+constexpr std::size_t kBufferSize = 1 << 20;
+
+// copy_file_range cannot be used between these files at all, as opposed
+// to failing part way
+bool is_unsupported(int error) {
+  return error == EXDEV || error == ENOSYS || error == EOPNOTSUPP ||
+         error == EINVAL || error == EBADF;
+}
+
+int write_all(int fd, const char *data, std::size_t length, off_t offset) {
+  while (length > 0) {
+    ssize_t n = pwrite(fd, data, length, offset);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno;
+    }
+    data += n;
+    length -= n;
+    offset += n;
+  }
+  return 0;
+}
+
+class ExtentCopier {
+public:
+  ExtentCopier(int in_fd, int out_fd, const std::atomic<bool> &cancelled,
+               const CopyProgress &on_progress)
+      : in_fd_(in_fd), out_fd_(out_fd), cancelled_(cancelled),
+        on_progress_(on_progress) {}
+
+  CopyMethod method() const { return method_; }
+
+  // Copies [offset, end) to the same place in the output
+  int copy(std::uint64_t offset, std::uint64_t end) {
+    while (offset < end) {
+      if (cancelled_.load(std::memory_order_relaxed))
+        return ECANCELED;
+      auto length = std::min(end - offset, kChunk);
+      std::uint64_t copied = 0;
+      int error = method_ == CopyMethod::ReadWrite
+                      ? read_write(offset, length, copied)
+                      : kernel_copy(offset, length, copied);
+      if (error != 0)
+        return error;
+      // The source shrank while being copied
+      if (copied == 0)
+        return 0;
+      offset += copied;
+      if (on_progress_)
+        on_progress_(copied);
+    }
+    return 0;
+  }
+
+private:
+  int kernel_copy(std::uint64_t offset, std::uint64_t length,
+                  std::uint64_t &copied) {
+    loff_t in_offset = offset;
+    loff_t out_offset = offset;
+    ssize_t n;
+    do {
+      n = copy_file_range(in_fd_, &in_offset, out_fd_, &out_offset, length,
+                          0);
+    } while (n < 0 && errno == EINTR);
+    if (n >= 0) {
+      copied = n;
+      return 0;
+    }
+    // Nothing has been written yet for this chunk, so it can be redone
+    if (!is_unsupported(errno))
+      return errno;
+    method_ = CopyMethod::ReadWrite;
+    return read_write(offset, length, copied);
+  }
+
+  int read_write(std::uint64_t offset, std::uint64_t length,
+                 std::uint64_t &copied) {
+    if (!buffer_)
+      buffer_ = std::make_unique<char[]>(kBufferSize);
+    copied = 0;
+    while (copied < length) {
+      auto want = std::min<std::uint64_t>(length - copied, kBufferSize);
+      ssize_t n = pread(in_fd_, buffer_.get(), want, offset + copied);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        return errno;
+      }
+      if (n == 0)
+        break;
+      if (int error = write_all(out_fd_, buffer_.get(), n, offset + copied))
+        return error;
+      copied += n;
+    }
+    return 0;
+  }
+
+  int in_fd_;
+  int out_fd_;
+  const std::atomic<bool> &cancelled_;
+  const CopyProgress &on_progress_;
+  CopyMethod method_ = CopyMethod::CopyFileRange;
+  std::unique_ptr<char[]> buffer_;
+};
+
+} // namespace
+
+CopyResult copy_contents(int in_fd, int out_fd, std::uint64_t size,
+                         const std::atomic<bool> &cancelled,
+                         const CopyProgress &on_progress) {
+  CopyResult result;
+  if (size == 0)
+    return result;
+
+  if (ioctl(out_fd, FICLONE, in_fd) == 0) {
+    if (on_progress)
+      on_progress(size);
+    return result;
+  }
+
+  posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  ExtentCopier copier(in_fd, out_fd, cancelled, on_progress);
+  std::uint64_t offset = 0;
+  while (offset < size) {
+    off_t data = lseek(in_fd, offset, SEEK_DATA);
+    if (data < 0) {
+      // ENXIO: only a hole is left. Anything else: no extent information,
+      // so the rest is copied as data.
+      if (errno == ENXIO)
+        break;
+      data = offset;
+    }
+    off_t hole = lseek(in_fd, data, SEEK_HOLE);
+    std::uint64_t end =
+        hole < 0 ? size : std::min<std::uint64_t>(hole, size);
+    if (static_cast<std::uint64_t>(data) >= end)
+      break;
+
+    // Holes skipped over count as copied
+    if (on_progress && static_cast<std::uint64_t>(data) > offset)
+      on_progress(data - offset);
+    if (int error = copier.copy(data, end)) {
+      result.error = error;
+      result.method = copier.method();
+      return result;
+    }
+    offset = end;
+  }
+  if (on_progress && offset < size)
+    on_progress(size - offset);
+
+  // Leaves a trailing hole in place
+  if (ftruncate(out_fd, size) != 0)
+    result.error = errno;
+  result.method = copier.method();
+  return result;
+}
+
+CopyResult copy_regular_file(const char *from, const char *to,
+                             const struct stat &st,
+                             const std::atomic<bool> &cancelled,
+                             const CopyProgress &on_progress) {
+  CopyResult result;
+  int in_fd = open(from, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (in_fd < 0) {
+    result.error = errno;
+    return result;
+  }
+  int out_fd = open(to, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (out_fd < 0) {
+    result.error = errno;
+    close(in_fd);
+    return result;
+  }
+
+  result = copy_contents(in_fd, out_fd, st.st_size, cancelled, on_progress);
+  if (result.error == 0) {
+    fchmod(out_fd, st.st_mode & 07777);
+    struct timespec times[2] = {st.st_atim, st.st_mtim};
+    futimens(out_fd, times);
+  }
+  close(in_fd);
+  if (close(out_fd) != 0 && result.error == 0)
+    result.error = errno;
+  if (result.error != 0)
+    unlink(to);
+  return result;
+}
+
+int copy_symlink(const char *from, const char *to) {
+  std::string target(PATH_MAX, '\0');
+  ssize_t n = readlink(from, target.data(), target.size());
+  if (n < 0)
+    return errno;
+  target.resize(n);
+  if (symlink(target.c_str(), to) != 0)
+    return errno;
+  return 0;
+}
+
+} // namespace xafile
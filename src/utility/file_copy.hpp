@@ -0,0 +1,59 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <sys/stat.h>
+
+namespace xafile {
+
+// How the bytes of a file were copied, cheapest first
+enum class CopyMethod : std::uint8_t { Reflink, CopyFileRange, ReadWrite };
+
+struct CopyResult {
+  int error = 0; // errno, 0 on success
+  CopyMethod method = CopyMethod::Reflink;
+};
+
+// Called with the number of bytes just copied
+using CopyProgress = std::function<void(std::uint64_t bytes)>;
+
+// Copies `size` bytes of `in_fd` into the empty file `out_fd`. A reflink
+// clone is tried first, which shares the extents on btrfs, XFS and the
+// like. Otherwise only the data extents are copied, with copy_file_range
+// so the data stays in the kernel, and holes stay holes. Filesystems that
+// refuse either get a plain read/write loop. Returns ECANCELED once
+// `cancelled` is set.
+CopyResult copy_contents(int in_fd, int out_fd, std::uint64_t size,
+                         const std::atomic<bool> &cancelled,
+                         const CopyProgress &on_progress);
+
+// Copies the regular file `from` to the new file `to` (which must not
+// exist), with its permissions and timestamps. A partial copy is removed.
+CopyResult copy_regular_file(const char *from, const char *to,
+                             const struct stat &st,
+                             const std::atomic<bool> &cancelled,
+                             const CopyProgress &on_progress);
+
+// Recreates the symlink `from` as `to`; returns errno, 0 on success
+int copy_symlink(const char *from, const char *to);
+
+} // namespace xafile
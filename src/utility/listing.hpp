@@ -0,0 +1,168 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "atoms.hpp"
+#include <glib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+struct ListingEntry {
+  std::uint32_t name_offset;
+  std::uint16_t name_length; // NAME_MAX is 255
+  Atom icon;
+  Atom type;         // human readable description
+  Atom content_type; // MIME type, kNone until detected
+  bool is_directory : 1;
+  bool has_metadata : 1;     // size and mtime are valid
+  bool is_hidden : 1;        // dotfile or listed in the directory's .hidden
+  std::uint16_t key_length;  // collation key, stored after the name
+  std::uint64_t size;
+  std::int64_t mtime; // seconds since the epoch, 0 when unknown
+};
+static_assert(sizeof(ListingEntry) == 32);
+
+// Directory contents with every name packed into one NUL separated buffer.
+// Each name is followed by its collation key, computed once when the entry
+// is added, so sorting by name is a plain byte comparison.
+class Listing {
+public:
+  std::uint32_t add(std::string_view name, bool is_directory) {
+    return append(name, collation_key(name), is_directory);
+  }
+
+  // Copies an entry from another listing, including its metadata
+  std::uint32_t add(const Listing &other, const ListingEntry &e) {
+    auto index = append(other.name(e), other.key(e), e.is_directory);
+    auto &copy = entries_[index];
+    auto offset = copy.name_offset;
+    copy = e;
+    copy.name_offset = offset;
+    return index;
+  }
+
+  std::size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+  const ListingEntry &operator[](std::size_t i) const { return entries_[i]; }
+  ListingEntry &operator[](std::size_t i) { return entries_[i]; }
+
+  std::string_view name(const ListingEntry &e) const {
+    return {names_.data() + e.name_offset, e.name_length};
+  }
+  const char *c_name(const ListingEntry &e) const {
+    return names_.data() + e.name_offset;
+  }
+  std::string_view key(const ListingEntry &e) const {
+    return {names_.data() + e.name_offset + e.name_length + 1, e.key_length};
+  }
+
+  // Dotfiles, and for paths relative to a search root anything inside a
+  // dot directory
+  static bool is_dot_name(std::string_view name) {
+    return name.starts_with('.') || name.find("/.") != std::string_view::npos;
+  }
+
+  static std::string collation_key(std::string_view name) {
+    // Names that are not UTF-8 are ordered by their bytes
+    if (!g_utf8_validate(name.data(), name.size(), nullptr))
+      return std::string(name);
+    char *collated = g_utf8_collate_key_for_filename(name.data(), name.size());
+    std::string key(collated);
+    g_free(collated);
+    return key;
+  }
+
+  // Directories first, then naturally by name ("file2" before "file10")
+  bool name_less(const ListingEntry &a, const ListingEntry &b) const {
+    if (a.is_directory != b.is_directory)
+      return a.is_directory;
+    if (auto c = key(a).compare(key(b)); c != 0)
+      return c < 0;
+    return name(a) < name(b);
+  }
+
+  void sort() {
+    std::sort(entries_.begin(), entries_.end(),
+              [this](const ListingEntry &a, const ListingEntry &b) {
+                return name_less(a, b);
+              });
+  }
+
+  std::size_t memory_bytes() const {
+    return sizeof(*this) + names_.capacity() +
+           entries_.capacity() * sizeof(ListingEntry);
+  }
+
+  void reserve(std::size_t entries, std::size_t name_bytes) {
+    entries_.reserve(entries);
+    names_.reserve(name_bytes);
+  }
+
+  // The packed form, for saving a listing and reading it back
+  std::string_view packed_names() const { return names_; }
+  const ListingEntry *packed_entries() const { return entries_.data(); }
+  // Replaces the contents; returns false, leaving the listing empty, when
+  // an entry points outside `names`
+  bool assign_packed(std::string_view names, const ListingEntry *entries,
+                     std::size_t count) {
+    names_.assign(names);
+    entries_.assign(entries, entries + count);
+    for (const auto &e : entries_) {
+      if (std::size_t(e.name_offset) + e.name_length + e.key_length + 2 >
+              names_.size() ||
+          names_[e.name_offset + e.name_length] != '\0' ||
+          names_[e.name_offset + e.name_length + e.key_length + 1] != '\0') {
+        names_.clear();
+        entries_.clear();
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::uint32_t append(std::string_view name, std::string_view key,
+                       bool is_directory) {
+    auto offset = static_cast<std::uint32_t>(names_.size());
+    auto key_length = static_cast<std::uint16_t>(
+        std::min<std::size_t>(key.size(), UINT16_MAX));
+    names_.append(name);
+    names_.push_back('\0');
+    names_.append(key.substr(0, key_length));
+    names_.push_back('\0');
+    entries_.push_back({offset, static_cast<std::uint16_t>(name.size()),
+                        is_directory ? atoms::kFolderIcon : atoms::kFileIcon,
+                        is_directory ? atoms::kFolderType : atoms::kFileType,
+                        atoms::kNone, is_directory, false, is_dot_name(name),
+                        key_length, 0, 0});
+    return static_cast<std::uint32_t>(entries_.size() - 1);
+  }
+
+private:
+  std::string names_;
+  std::vector<ListingEntry> entries_;
+};
+
+} // namespace xafile
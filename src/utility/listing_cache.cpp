@@ -0,0 +1,134 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "listing_cache.hpp"
+#include <cstdlib>
+#include <sys/stat.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr std::size_t kDefaultBudget = 64u << 20;
+
+std::size_t budget_from_env() {
+  if (const char *mb = std::getenv("XAFILE_LISTING_CACHE_MB"))
+    return static_cast<std::size_t>(std::strtoull(mb, nullptr, 10)) << 20;
+  return kDefaultBudget;
+}
+
+} // namespace
+
+std::optional<DirStamp> DirStamp::of(const std::string &path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    return std::nullopt;
+  DirStamp stamp;
+  stamp.device = st.st_dev;
+  stamp.inode = st.st_ino;
+  stamp.mtime_sec = st.st_mtim.tv_sec;
+  stamp.mtime_nsec = st.st_mtim.tv_nsec;
+  stamp.ctime_sec = st.st_ctim.tv_sec;
+  stamp.ctime_nsec = st.st_ctim.tv_nsec;
+  return stamp;
+}
+
+ListingCache &ListingCache::instance() {
+  static ListingCache cache(budget_from_env());
+  return cache;
+}
+
+std::optional<CachedListing> ListingCache::lookup(const std::string &path,
+                                                  const DirStamp &stamp) {
+  std::lock_guard lock(mutex_);
+  auto it = index_.find(path);
+  if (it == index_.end()) {
+    stats_.misses++;
+    return std::nullopt;
+  }
+
+  auto slot = it->second;
+  if (slot->stamp != stamp) {
+    // The directory changed since it was cached
+    stats_.bytes -= slot->bytes;
+    lru_.erase(slot);
+    index_.erase(it);
+    stats_.entries = lru_.size();
+    stats_.misses++;
+    return std::nullopt;
+  }
+
+  lru_.splice(lru_.begin(), lru_, slot);
+  stats_.hits++;
+  return slot->contents;
+}
+
+void ListingCache::store(const std::string &path, const DirStamp &stamp,
+                         CachedListing contents) {
+  std::size_t bytes = sizeof(Slot) + path.size() +
+                      contents.listing->memory_bytes() +
+                      contents.order.capacity() * sizeof(std::uint32_t);
+
+  std::lock_guard lock(mutex_);
+  if (auto it = index_.find(path); it != index_.end()) {
+    stats_.bytes -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+
+  lru_.push_front({path, stamp, std::move(contents), bytes});
+  index_.emplace(path, lru_.begin());
+  stats_.bytes += bytes;
+  evict_locked();
+}
+
+void ListingCache::erase(const std::string &path) {
+  std::lock_guard lock(mutex_);
+  if (auto it = index_.find(path); it != index_.end()) {
+    stats_.bytes -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+    stats_.entries = lru_.size();
+  }
+}
+
+void ListingCache::set_budget(std::size_t budget_bytes) {
+  std::lock_guard lock(mutex_);
+  budget_ = budget_bytes;
+  evict_locked();
+}
+
+ListingCache::Stats ListingCache::stats() const {
+  std::lock_guard lock(mutex_);
+  Stats stats = stats_;
+  stats.budget = budget_;
+  return stats;
+}
+
+void ListingCache::evict_locked() {
+  while (stats_.bytes > budget_ && !lru_.empty()) {
+    auto &victim = lru_.back();
+    stats_.bytes -= victim.bytes;
+    index_.erase(victim.path);
+    lru_.pop_back();
+    stats_.evictions++;
+  }
+  stats_.entries = lru_.size();
+}
+
+} // namespace xafile
@@ -0,0 +1,101 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "listing.hpp"
+#include "sort_order.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xafile {
+
+// Identifies one version of a directory. Creating, removing or renaming an
+// entry bumps the mtime, replacing the directory changes the inode.
+struct DirStamp {
+  std::uint64_t device;
+  std::uint64_t inode;
+  std::int64_t mtime_sec, mtime_nsec;
+  std::int64_t ctime_sec, ctime_nsec;
+
+  static std::optional<DirStamp> of(const std::string &path);
+  bool operator==(const DirStamp &) const = default;
+};
+
+// The listing is shared with the model showing it, which makes its changes
+// to a copy, so what is cached stays the directory as of its stamp.
+struct CachedListing {
+  std::shared_ptr<const Listing> listing;
+  std::vector<std::uint32_t> order; // display order, as in FileListModel
+  SortOrder sort;                    // what `order` is sorted by
+};
+
+// Keeps recently shown directories in memory so going back to one does not
+// rescan it. Entries are dropped least recently used first once the total
+// size exceeds the budget.
+class ListingCache {
+public:
+  struct Stats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t budget = 0;
+  };
+
+  // Budget defaults to 64 MiB, XAFILE_LISTING_CACHE_MB overrides it
+  static ListingCache &instance();
+
+  explicit ListingCache(std::size_t budget_bytes) : budget_(budget_bytes) {}
+
+  // Returns the cached listing if it was stored with the same stamp
+  std::optional<CachedListing> lookup(const std::string &path,
+                                      const DirStamp &stamp);
+  void store(const std::string &path, const DirStamp &stamp,
+             CachedListing listing);
+  void erase(const std::string &path);
+
+  void set_budget(std::size_t budget_bytes);
+  Stats stats() const;
+
+private:
+  struct Slot {
+    std::string path;
+    DirStamp stamp;
+    CachedListing contents;
+    std::size_t bytes;
+  };
+
+  void evict_locked();
+
+  mutable std::mutex mutex_;
+  std::list<Slot> lru_; // most recently used first
+  std::unordered_map<std::string, std::list<Slot>::iterator> index_;
+  std::size_t budget_;
+  Stats stats_;
+};
+
+} // namespace xafile
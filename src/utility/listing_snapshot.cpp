@@ -0,0 +1,380 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "listing_snapshot.hpp"
+#include <glib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <numeric>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+constexpr char kMagic[8] = {'X', 'A', 'F', 'L', 'S', 'T', '\0', '\0'};
+// Bump whenever the layout below or ListingEntry changes; older files are
+// ignored
+constexpr std::uint32_t kFormatVersion = 1;
+
+constexpr std::size_t kMaxDirectories = 32;
+constexpr std::size_t kMaxEntries = 200'000; // per directory
+constexpr std::size_t kMaxFileBytes = 64 << 20;
+
+// Every section starts at a multiple of 8 so it can be used in place
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t dir_count;
+  std::uint32_t atom_count;
+  std::uint32_t locale_length;
+  std::uint64_t locale_offset;
+  std::uint64_t dirs_offset;         // FileDir[dir_count], most recent first
+  std::uint64_t atom_offsets_offset; // uint32[atom_count + 1] into atom_names
+  std::uint64_t atom_names_offset;   // NUL separated
+  std::uint64_t file_size;
+};
+
+struct FileDir {
+  DirStamp stamp;
+  std::uint64_t path_offset;
+  std::uint64_t entries_offset; // ListingEntry[entry_count], display order
+  std::uint64_t names_offset;   // as packed by Listing
+  std::uint64_t names_length;
+  std::uint32_t path_length;
+  std::uint32_t entry_count;
+  SortField sort_field;
+  std::uint8_t sort_descending;
+  std::uint8_t reserved[6];
+};
+
+static_assert(std::is_trivially_copyable_v<DirStamp>);
+static_assert(sizeof(FileDir) % 8 == 0);
+
+// Collation keys and type descriptions depend on it
+std::string current_locale() {
+  std::string locale = std::setlocale(LC_COLLATE, nullptr);
+  locale += ';';
+  locale += std::setlocale(LC_MESSAGES, nullptr);
+  return locale;
+}
+
+bool write_file(const std::string &file, const std::string &data) {
+  // Written next to the old snapshot and renamed over it, so a run that
+  // starts meanwhile never maps a half written file
+  std::string temp = file + ".tmp";
+  int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                  0600);
+  if (fd < 0) {
+    std::cerr << temp << ": " << std::strerror(errno) << '\n';
+    return false;
+  }
+  std::size_t written = 0;
+  while (written < data.size()) {
+    auto n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    written += n;
+  }
+  int error = written == data.size() ? 0 : errno;
+  if (close(fd) != 0 && error == 0)
+    error = errno;
+  if (error == 0 && std::rename(temp.c_str(), file.c_str()) != 0)
+    error = errno;
+  if (error != 0) {
+    std::cerr << file << ": " << std::strerror(error) << '\n';
+    unlink(temp.c_str());
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+// A read-only view of a snapshot file. Listings are copied out of it, so
+// it can be replaced while mapped.
+class SnapshotMap {
+public:
+  static std::shared_ptr<const SnapshotMap> open(const std::string &file);
+  ~SnapshotMap() { munmap(data_, size_); }
+
+  SnapshotMap(const SnapshotMap &) = delete;
+  SnapshotMap &operator=(const SnapshotMap &) = delete;
+
+  std::size_t size() const { return header().dir_count; }
+  std::string_view path(std::size_t i) const {
+    return {data_ + dirs_[i].path_offset, dirs_[i].path_length};
+  }
+  std::optional<ListingSnapshot::Saved> read(std::size_t i) const;
+
+private:
+  SnapshotMap(char *data, std::size_t size) : data_(data), size_(size) {}
+
+  const FileHeader &header() const {
+    return *reinterpret_cast<const FileHeader *>(data_);
+  }
+
+  char *data_;
+  std::size_t size_;
+  const FileDir *dirs_ = nullptr;
+  std::vector<Atom> atoms_; // file's atom numbers to this run's
+};
+
+std::shared_ptr<const SnapshotMap> SnapshotMap::open(const std::string &file) {
+  int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    return nullptr;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  std::shared_ptr<SnapshotMap> map(
+      new SnapshotMap(static_cast<char *>(data), st.st_size));
+  const auto &h = map->header();
+  auto fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+    return offset % 8 == 0 && offset <= h.file_size &&
+           bytes <= h.file_size - offset;
+  };
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 ||
+      h.version != kFormatVersion ||
+      h.file_size != static_cast<std::uint64_t>(st.st_size) ||
+      !fits(h.locale_offset, h.locale_length) ||
+      std::string_view(map->data_ + h.locale_offset, h.locale_length) !=
+          current_locale() ||
+      !fits(h.dirs_offset, std::uint64_t(h.dir_count) * sizeof(FileDir)) ||
+      !fits(h.atom_offsets_offset, (h.atom_count + 1ull) * 4) ||
+      !fits(h.atom_names_offset, 0))
+    return nullptr;
+
+  map->dirs_ = reinterpret_cast<const FileDir *>(map->data_ + h.dirs_offset);
+  for (std::uint32_t i = 0; i < h.dir_count; i++) {
+    const auto &d = map->dirs_[i];
+    if (!fits(d.path_offset, d.path_length) ||
+        !fits(d.entries_offset,
+              std::uint64_t(d.entry_count) * sizeof(ListingEntry)) ||
+        !fits(d.names_offset, d.names_length) ||
+        d.sort_field > SortField::Modified)
+      return nullptr;
+  }
+
+  // Interned once, the strings are the same for every directory
+  auto *offsets = reinterpret_cast<const std::uint32_t *>(
+      map->data_ + h.atom_offsets_offset);
+  std::uint64_t names_size = h.file_size - h.atom_names_offset;
+  map->atoms_.reserve(h.atom_count);
+  for (std::uint32_t i = 0; i < h.atom_count; i++) {
+    // Each name is followed by its NUL
+    if (offsets[i] >= offsets[i + 1] || offsets[i + 1] > names_size)
+      return nullptr;
+    map->atoms_.push_back(
+        atom_intern({map->data_ + h.atom_names_offset + offsets[i],
+                     offsets[i + 1] - offsets[i] - 1}));
+  }
+  return map;
+}
+
+std::optional<ListingSnapshot::Saved> SnapshotMap::read(std::size_t i) const {
+  const auto &d = dirs_[i];
+  auto listing = std::make_shared<Listing>();
+  if (!listing->assign_packed(
+          {data_ + d.names_offset, d.names_length},
+          reinterpret_cast<const ListingEntry *>(data_ + d.entries_offset),
+          d.entry_count))
+    return std::nullopt;
+  for (std::size_t j = 0; j < listing->size(); j++) {
+    auto &e = (*listing)[j];
+    if (e.icon >= atoms_.size() || e.type >= atoms_.size() ||
+        e.content_type >= atoms_.size())
+      return std::nullopt;
+    e.icon = atoms_[e.icon];
+    e.type = atoms_[e.type];
+    e.content_type = atoms_[e.content_type];
+  }
+  std::vector<std::uint32_t> order(listing->size());
+  std::iota(order.begin(), order.end(), 0);
+  return ListingSnapshot::Saved{
+      d.stamp,
+      {std::move(listing), std::move(order),
+       {d.sort_field, d.sort_descending != 0}}};
+}
+
+ListingSnapshot &ListingSnapshot::instance() {
+  static ListingSnapshot snapshot;
+  return snapshot;
+}
+
+ListingSnapshot::ListingSnapshot() {
+  const char *setting = std::getenv("XAFILE_LISTING_SNAPSHOT");
+  enabled_ = !setting || std::strcmp(setting, "0") != 0;
+  file_ = std::string(g_get_user_cache_dir()) + "/xafile/listings";
+  if (enabled_)
+    map_ = SnapshotMap::open(file_);
+}
+
+std::optional<ListingSnapshot::Saved>
+ListingSnapshot::take(const std::string &path) {
+  if (!map_ || !taken_.insert(path).second)
+    return std::nullopt;
+  for (std::size_t i = 0; i < map_->size(); i++)
+    if (map_->path(i) == path)
+      return map_->read(i);
+  return std::nullopt;
+}
+
+void ListingSnapshot::remember(const std::string &path, const DirStamp &stamp,
+                               const CachedListing &contents) {
+  if (!enabled_)
+    return;
+  for (auto it = recent_.begin(); it != recent_.end(); ++it) {
+    if (it->path == path) {
+      recent_.erase(it);
+      break;
+    }
+  }
+  recent_.push_front({path, stamp, contents});
+  if (recent_.size() > kMaxDirectories)
+    recent_.pop_back();
+}
+
+void ListingSnapshot::write() {
+  if (!enabled_)
+    return;
+
+  // Shown this run first, then what the last run saved and was not shown
+  std::vector<Recent> dirs(recent_.begin(), recent_.end());
+  for (std::size_t i = 0; map_ && i < map_->size(); i++) {
+    if (dirs.size() >= kMaxDirectories)
+      break;
+    auto path = map_->path(i);
+    if (std::any_of(dirs.begin(), dirs.end(),
+                    [&](const Recent &r) { return r.path == path; }))
+      continue;
+    if (auto saved = map_->read(i))
+      dirs.push_back({std::string(path), saved->stamp,
+                      std::move(saved->contents)});
+  }
+
+  std::string out(sizeof(FileHeader), '\0');
+  auto place = [&out](const void *data, std::size_t bytes) {
+    out.resize((out.size() + 7) & ~std::size_t(7));
+    std::uint64_t offset = out.size();
+    out.append(static_cast<const char *>(data), bytes);
+    return offset;
+  };
+
+  std::unordered_map<Atom, Atom> atom_ids;
+  std::vector<Atom> atoms;
+  auto local = [&](Atom atom) {
+    auto [it, added] =
+        atom_ids.try_emplace(atom, static_cast<Atom>(atoms.size()));
+    if (added)
+      atoms.push_back(atom);
+    return it->second;
+  };
+
+  std::vector<FileDir> records;
+  for (const auto &dir : dirs) {
+    const auto &listing = *dir.contents.listing;
+    const auto &order = dir.contents.order;
+    if (order.size() > kMaxEntries)
+      continue;
+    // Only the rows shown, in display order; the live listing keeps
+    // entries that were removed
+    Listing packed;
+    bool valid = true;
+    for (auto index : order) {
+      if (index >= listing.size()) {
+        valid = false;
+        break;
+      }
+      auto &e = packed[packed.add(listing, listing[index])];
+      e.icon = local(e.icon);
+      e.type = local(e.type);
+      e.content_type = local(e.content_type);
+    }
+    auto names = packed.packed_names();
+    if (!valid || out.size() + names.size() +
+                          packed.size() * sizeof(ListingEntry) >
+                      kMaxFileBytes)
+      continue;
+
+    FileDir record{};
+    record.stamp = dir.stamp;
+    record.path_offset = place(dir.path.data(), dir.path.size());
+    record.path_length = static_cast<std::uint32_t>(dir.path.size());
+    record.entries_offset = place(packed.packed_entries(),
+                                  packed.size() * sizeof(ListingEntry));
+    record.entry_count = static_cast<std::uint32_t>(packed.size());
+    record.names_offset = place(names.data(), names.size());
+    record.names_length = names.size();
+    record.sort_field = dir.contents.sort.field;
+    record.sort_descending = dir.contents.sort.descending;
+    records.push_back(record);
+  }
+
+  std::vector<std::uint32_t> atom_offsets;
+  std::string atom_names;
+  for (auto atom : atoms) {
+    atom_offsets.push_back(static_cast<std::uint32_t>(atom_names.size()));
+    atom_names += atom_string(atom);
+    atom_names.push_back('\0');
+  }
+  atom_offsets.push_back(static_cast<std::uint32_t>(atom_names.size()));
+  auto locale = current_locale();
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kFormatVersion;
+  header.dir_count = static_cast<std::uint32_t>(records.size());
+  header.atom_count = static_cast<std::uint32_t>(atoms.size());
+  header.locale_length = static_cast<std::uint32_t>(locale.size());
+  header.locale_offset = place(locale.data(), locale.size());
+  header.dirs_offset = place(records.data(), records.size() * sizeof(FileDir));
+  header.atom_offsets_offset =
+      place(atom_offsets.data(), atom_offsets.size() * sizeof(std::uint32_t));
+  header.atom_names_offset = place(atom_names.data(), atom_names.size());
+  header.file_size = out.size();
+  std::memcpy(out.data(), &header, sizeof(header));
+
+  g_mkdir_with_parents((std::string(g_get_user_cache_dir()) + "/xafile").c_str(),
+                       0700);
+  write_file(file_, out);
+}
+
+} // namespace xafile
@@ -0,0 +1,72 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "listing_cache.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+namespace xafile {
+
+class SnapshotMap;
+
+// The directories shown most recently, with names, types, sizes and dates,
+// saved to one file in the cache directory when the application exits.
+// The next run maps that file and can show a directory from it before
+// scanning anything; the stamp says whether it changed since.
+//
+// Turned off by XAFILE_LISTING_SNAPSHOT=0. Main thread only.
+class ListingSnapshot {
+public:
+  struct Saved {
+    DirStamp stamp;         // of the directory when it was saved
+    CachedListing contents; // rows in `contents.sort` order
+  };
+
+  static ListingSnapshot &instance();
+
+  // What the last run saved for `path`, handed out once; after that the
+  // directory is in ListingCache or gets scanned
+  std::optional<Saved> take(const std::string &path);
+  // Notes what is shown for `path`; saved by write()
+  void remember(const std::string &path, const DirStamp &stamp,
+                const CachedListing &contents);
+  void write();
+
+private:
+  struct Recent {
+    std::string path;
+    DirStamp stamp;
+    CachedListing contents;
+  };
+
+  ListingSnapshot();
+
+  bool enabled_;
+  std::string file_;
+  std::shared_ptr<const SnapshotMap> map_;
+  std::unordered_set<std::string> taken_;
+  std::list<Recent> recent_; // most recently shown first
+};
+
+} // namespace xafile
@@ -0,0 +1,234 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "name_filter.hpp"
+#include <algorithm>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace xafile {
+
+namespace {
+
+// Listings this big are filtered on several threads
+constexpr std::size_t kParallelThreshold = 1 << 16;
+
+constexpr std::int32_t kSubstringBonus = 1000;
+constexpr std::int32_t kPrefixBonus = 500;
+constexpr std::int32_t kBoundaryBonus = 60;
+constexpr std::int32_t kAdjacentBonus = 20;
+constexpr std::size_t kMaxLengthPenalty = 100;
+
+// Bytes after the last name, so a block load from any name stays inside
+constexpr std::size_t kPadding = 16;
+
+char ascii_fold(char c) { return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c; }
+
+// Start of a word: the first character or one after a separator
+bool is_boundary(std::string_view name, std::size_t i) {
+  if (i == 0)
+    return true;
+  char before = name[i - 1];
+  return before == ' ' || before == '_' || before == '-' || before == '.';
+}
+
+// First position at or after `from` holding `c`, or npos
+std::size_t find_byte(std::string_view name, std::size_t from, char c) {
+  std::size_t i = from;
+#ifdef __SSE2__
+  const __m128i needle = _mm_set1_epi8(c);
+  for (; i < name.size(); i += 16) {
+    __m128i block =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(name.data() + i));
+    unsigned mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+    if (mask) {
+      std::size_t at = i + __builtin_ctz(mask);
+      return at < name.size() ? at : std::string_view::npos;
+    }
+  }
+  return std::string_view::npos;
+#else
+  return name.find(c, i);
+#endif
+}
+
+} // namespace
+
+FoldedNames::FoldedNames(const Listing &listing,
+                         const std::vector<std::uint32_t> &order) {
+  offsets_.resize(order.size() + 1);
+  std::uint32_t total = 0;
+  for (std::size_t row = 0; row < order.size(); row++) {
+    offsets_[row] = total;
+    total += listing[order[row]].name_length;
+  }
+  offsets_[order.size()] = total;
+
+  buffer_.resize(total + kPadding, '\0');
+  for (std::size_t row = 0; row < order.size(); row++) {
+    auto name = listing.name(listing[order[row]]);
+    std::transform(name.begin(), name.end(), buffer_.begin() + offsets_[row],
+                   ascii_fold);
+  }
+}
+
+NameFilter::NameFilter(std::string_view query) {
+  query_.reserve(query.size());
+  for (char c : query)
+    query_.push_back(ascii_fold(c));
+}
+
+std::optional<std::int32_t> NameFilter::score(std::string_view name) const {
+  if (query_.empty())
+    return 0;
+
+  // Scattered: every character in order, taken as early as possible. Most
+  // names fail here after a block compare or two.
+  std::int32_t scattered = 0;
+  std::size_t first = std::string_view::npos;
+  std::size_t previous = std::string_view::npos;
+  std::size_t pos = 0;
+  for (char c : query_) {
+    auto at = find_byte(name, pos, c);
+    if (at == std::string_view::npos)
+      return std::nullopt;
+    if (first == std::string_view::npos)
+      first = at;
+    if (is_boundary(name, at))
+      scattered += kBoundaryBonus;
+    if (previous != std::string_view::npos && at == previous + 1)
+      scattered += kAdjacentBonus;
+    previous = at;
+    pos = at + 1;
+  }
+  auto length_penalty = static_cast<std::int32_t>(std::min<std::size_t>(
+      name.size(), kMaxLengthPenalty));
+
+  // The query as one piece, preferring a word start over the first hit
+  std::optional<std::size_t> substring;
+  for (std::size_t at = first; at != std::string_view::npos;
+       at = find_byte(name, at + 1, query_[0])) {
+    if (name.compare(at, query_.size(), query_) != 0)
+      continue;
+    if (!substring)
+      substring = at;
+    if (is_boundary(name, at)) {
+      substring = at;
+      break;
+    }
+  }
+  if (!substring)
+    return scattered - length_penalty;
+
+  std::int32_t score = kSubstringBonus - length_penalty;
+  if (*substring == 0)
+    score += kPrefixBonus;
+  else if (is_boundary(name, *substring))
+    score += kBoundaryBonus;
+  return score;
+}
+
+std::vector<std::uint32_t>
+NameFilter::rank(const FoldedNames &names,
+                 const std::vector<std::uint32_t> *rows) const {
+  struct Hit {
+    std::int32_t score;
+    std::uint32_t row;
+  };
+
+  std::size_t n = rows ? rows->size() : names.size();
+  auto scan = [&](std::size_t begin, std::size_t stop,
+                  std::vector<Hit> &hits) {
+    if (rows) {
+      for (std::size_t i = begin; i < stop; i++) {
+        auto row = (*rows)[i];
+        if (auto s = score(names[row]))
+          hits.push_back({*s, row});
+      }
+      return;
+    }
+
+    // Only rows holding the query's first character can match; look for
+    // it across the whole buffer instead of name by name
+    const auto &offsets = names.offsets();
+    std::string_view buffer(names.buffer() + offsets[begin],
+                            offsets[stop] - offsets[begin]);
+    std::size_t row = begin;
+    std::size_t pos = 0;
+    while ((pos = find_byte(buffer, pos, query_[0])) !=
+           std::string_view::npos) {
+      auto at = offsets[begin] + pos;
+      while (offsets[row + 1] <= at)
+        row++;
+      if (auto s = score(names[row]))
+        hits.push_back({*s, static_cast<std::uint32_t>(row)});
+      pos = offsets[++row] - offsets[begin];
+    }
+  };
+
+  std::vector<Hit> hits;
+  if (n == 0 || query_.empty()) {
+    std::vector<std::uint32_t> all(n);
+    for (std::size_t i = 0; i < n; i++)
+      all[i] = rows ? (*rows)[i] : static_cast<std::uint32_t>(i);
+    return all;
+  }
+  std::size_t slices =
+      n < kParallelThreshold
+          ? 1
+          : std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 8);
+  if (slices == 1) {
+    scan(0, n, hits);
+  } else {
+    std::vector<std::vector<Hit>> parts(slices);
+    {
+      std::vector<std::jthread> workers;
+      for (std::size_t i = 0; i < slices; i++)
+        workers.emplace_back([&, i] {
+          scan(n * i / slices, n * (i + 1) / slices, parts[i]);
+        });
+    }
+    for (auto &part : parts)
+      hits.insert(hits.end(), part.begin(), part.end());
+  }
+
+  // Scores span a small range and hits are already in row order, so a
+  // counting sort ranks them in linear time
+  if (hits.empty())
+    return {};
+  auto [low, high] = std::minmax_element(
+      hits.begin(), hits.end(),
+      [](const Hit &a, const Hit &b) { return a.score < b.score; });
+  std::int32_t min_score = low->score;
+  std::vector<std::uint32_t> starts(high->score - min_score + 2, 0);
+  for (const auto &hit : hits)
+    starts[high->score - hit.score + 1]++;
+  for (std::size_t i = 1; i < starts.size(); i++)
+    starts[i] += starts[i - 1];
+  std::vector<std::uint32_t> ranked(hits.size());
+  std::int32_t max_score = high->score;
+  for (const auto &hit : hits)
+    ranked[starts[max_score - hit.score]++] = hit.row;
+  return ranked;
+}
+
+} // namespace xafile
@@ -0,0 +1,79 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "listing.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+// The names of a listing in row order, ASCII-lowercased and packed back to
+// back, so filtering reads one sequential buffer. The buffer is padded so
+// 16 byte blocks can be loaded from any name.
+class FoldedNames {
+public:
+  FoldedNames() = default;
+  FoldedNames(const Listing &listing, const std::vector<std::uint32_t> &order);
+
+  std::size_t size() const {
+    return offsets_.empty() ? 0 : offsets_.size() - 1;
+  }
+  std::string_view operator[](std::size_t row) const {
+    return {buffer_.data() + offsets_[row],
+            offsets_[row + 1] - offsets_[row]};
+  }
+  // Where each row starts in buffer(), plus the end of the last one
+  const std::vector<std::uint32_t> &offsets() const { return offsets_; }
+  const char *buffer() const { return buffer_.data(); }
+
+private:
+  std::string buffer_;
+  std::vector<std::uint32_t> offsets_;
+};
+
+// Fuzzy matcher for narrowing a listing as the user types. A name matches
+// when it contains the query's characters in order, ignoring ASCII case.
+// Names containing the query as one piece rank above scattered matches,
+// and matches at the start of the name or of a word rank higher still.
+// Names are compared 16 bytes at a time where SSE2 is available.
+class NameFilter {
+public:
+  explicit NameFilter(std::string_view query);
+
+  bool empty() const { return query_.empty(); }
+  const std::string &query() const { return query_; }
+
+  // Score of a name taken from FoldedNames
+  std::optional<std::int32_t> score(std::string_view name) const;
+
+  // The matching rows, best first and in row order among equal scores.
+  // Only `rows` are looked at when given.
+  std::vector<std::uint32_t>
+  rank(const FoldedNames &names,
+       const std::vector<std::uint32_t> *rows = nullptr) const;
+
+private:
+  std::string query_; // ASCII lowercased
+};
+
+} // namespace xafile
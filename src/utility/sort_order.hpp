@@ -0,0 +1,222 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "listing.hpp"
+#include <glib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace xafile {
+
+enum class SortField : std::uint8_t { Name, Size, Type, Modified };
+
+struct SortOrder {
+  SortField field = SortField::Name;
+  bool descending = false;
+
+  bool operator==(const SortOrder &) const = default;
+  // Whether the order depends on metadata that arrives after the scan
+  bool needs_metadata() const { return field != SortField::Name; }
+};
+
+// Compares entry indices of one listing. Directories always come first;
+// entries that tie on the field are ordered by name.
+class EntryOrder {
+public:
+  EntryOrder(const Listing &listing, SortOrder order)
+      : listing_(&listing), order_(order) {
+    if (order.field == SortField::Type)
+      rank_types();
+  }
+
+  bool operator()(std::uint32_t a, std::uint32_t b) const {
+    const auto &x = (*listing_)[a];
+    const auto &y = (*listing_)[b];
+    if (x.is_directory != y.is_directory)
+      return x.is_directory;
+    return order_.descending ? field_less(y, x) : field_less(x, y);
+  }
+
+  // An integer that orders like operator() among entries of the same kind,
+  // except that ties still have to be compared in full. Name keys are read
+  // from `skip`, a prefix every key shares.
+  std::uint64_t prefix(std::uint32_t index, std::size_t skip) const {
+    const auto &e = (*listing_)[index];
+    std::uint64_t value = 0;
+    switch (order_.field) {
+    case SortField::Name: {
+      auto key = listing_->key(e);
+      for (std::size_t i = skip; i < skip + 8; i++) {
+        value <<= 8;
+        if (i < key.size())
+          value |= static_cast<unsigned char>(key[i]);
+      }
+      break;
+    }
+    case SortField::Size:
+      value = e.is_directory ? 0 : e.size;
+      break;
+    case SortField::Type:
+      value = type_rank(e.type);
+      break;
+    case SortField::Modified:
+      value = static_cast<std::uint64_t>(e.mtime) ^ (std::uint64_t(1) << 63);
+      break;
+    }
+    return order_.descending ? ~value : value;
+  }
+
+private:
+  bool field_less(const ListingEntry &a, const ListingEntry &b) const {
+    switch (order_.field) {
+    case SortField::Name:
+      break;
+    case SortField::Size:
+      // Directories have no size worth comparing
+      if (!a.is_directory && a.size != b.size)
+        return a.size < b.size;
+      break;
+    case SortField::Type:
+      if (a.type != b.type) {
+        auto x = type_rank(a.type), y = type_rank(b.type);
+        if (x != y)
+          return x < y;
+        // Neither was there when the ranks were made
+        return g_utf8_collate(atom_string(a.type), atom_string(b.type)) < 0;
+      }
+      break;
+    case SortField::Modified:
+      if (a.mtime != b.mtime)
+        return a.mtime < b.mtime;
+      break;
+    }
+    return listing_->name_less(a, b);
+  }
+
+  // Types that were not in the listing when the ranks were made sort last
+  static constexpr std::uint32_t kUnranked = UINT32_MAX;
+  std::uint32_t type_rank(Atom type) const {
+    return type < type_rank_.size() ? type_rank_[type] : kUnranked;
+  }
+
+  // Type descriptions are collated once per distinct type, not per compare
+  void rank_types() {
+    std::vector<Atom> types;
+    for (std::size_t i = 0; i < listing_->size(); i++) {
+      Atom type = (*listing_)[i].type;
+      if (type >= type_rank_.size())
+        type_rank_.resize(type + 1, kUnranked);
+      if (type_rank_[type] == kUnranked) {
+        type_rank_[type] = 0;
+        types.push_back(type);
+      }
+    }
+    std::sort(types.begin(), types.end(), [](Atom a, Atom b) {
+      return g_utf8_collate(atom_string(a), atom_string(b)) < 0;
+    });
+    for (std::size_t i = 0; i < types.size(); i++)
+      type_rank_[types[i]] = static_cast<std::uint32_t>(i);
+  }
+
+  const Listing *listing_;
+  SortOrder order_;
+  std::vector<std::uint32_t> type_rank_;
+};
+
+// std::sort on one slice per core, then pairwise merges, each round in
+// parallel. Small ranges are sorted on the calling thread.
+template <typename It, typename Less>
+void parallel_sort(It first, It last, Less less) {
+  constexpr std::ptrdiff_t kSerialCutoff = 1 << 15;
+  std::size_t slices =
+      std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+  auto n = last - first;
+  if (n < kSerialCutoff || slices < 2) {
+    std::sort(first, last, less);
+    return;
+  }
+
+  std::vector<It> bounds;
+  for (std::size_t i = 0; i <= slices; i++)
+    bounds.push_back(first + n * static_cast<std::ptrdiff_t>(i) /
+                                 static_cast<std::ptrdiff_t>(slices));
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t i = 0; i < slices; i++)
+      workers.emplace_back(
+          [&, i] { std::sort(bounds[i], bounds[i + 1], less); });
+  }
+  for (std::size_t width = 1; width < slices; width *= 2) {
+    std::vector<std::jthread> workers;
+    for (std::size_t i = 0; i + width < slices; i += 2 * width) {
+      auto end = std::min(i + 2 * width, slices);
+      workers.emplace_back([&, i, end] {
+        std::inplace_merge(bounds[i], bounds[i + width], bounds[end], less);
+      });
+    }
+  }
+}
+
+// Sorts row order for `listing`. Entries are sorted as (prefix, index)
+// pairs so most comparisons never leave the array.
+inline void sort_entries(const Listing &listing,
+                         std::vector<std::uint32_t> &order, SortOrder sort) {
+  struct Slot {
+    std::uint64_t prefix;
+    std::uint32_t index;
+    bool is_file;
+  };
+
+  // Names in one directory often share a prefix ("IMG_2024...")
+  std::size_t skip = 0;
+  if (sort.field == SortField::Name && !order.empty()) {
+    auto first = listing.key(listing[order[0]]);
+    skip = first.size();
+    for (auto index : order) {
+      auto key = listing.key(listing[index]);
+      auto [a, b] = std::mismatch(first.begin(), first.begin() + skip,
+                                  key.begin(), key.end());
+      skip = a - first.begin();
+    }
+  }
+
+  EntryOrder less(listing, sort);
+  std::vector<Slot> slots(order.size());
+  for (std::size_t i = 0; i < order.size(); i++)
+    slots[i] = {less.prefix(order[i], skip), order[i],
+                !listing[order[i]].is_directory};
+
+  parallel_sort(slots.begin(), slots.end(),
+                [&less](const Slot &a, const Slot &b) {
+                  if (a.is_file != b.is_file)
+                    return b.is_file;
+                  if (a.prefix != b.prefix)
+                    return a.prefix < b.prefix;
+                  return less(a.index, b.index);
+                });
+  for (std::size_t i = 0; i < slots.size(); i++)
+    order[i] = slots[i].index;
+}
+
+} // namespace xafile
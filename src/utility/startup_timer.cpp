@@ -0,0 +1,107 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "startup_timer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+struct Milestone {
+  const char *name;
+  std::uint64_t ns;
+};
+
+std::uint64_t boot_time_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_BOOTTIME, &ts);
+  return std::uint64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+// When the process was started, on the CLOCK_BOOTTIME scale. The kernel
+// keeps it in clock ticks, so it is only good to about 10 ms; 0 when
+// /proc is not there.
+std::uint64_t process_start_ns() {
+  std::ifstream file("/proc/self/stat");
+  std::string stat;
+  std::getline(file, stat);
+  // The command name may hold spaces and parentheses; fields are counted
+  // from the last ')', which ends it
+  auto end = stat.rfind(')');
+  if (end == std::string::npos)
+    return 0;
+  const char *field = stat.c_str() + end + 1;
+  // starttime is field 22, the 20th after the name
+  for (int i = 0; i < 19 && field; i++)
+    field = std::strchr(field + 1, ' ');
+  if (!field)
+    return 0;
+  auto ticks = std::strtoull(field, nullptr, 10);
+  return ticks * (1'000'000'000 / sysconf(_SC_CLK_TCK));
+}
+
+std::uint64_t g_origin_ns = 0;
+std::vector<Milestone> g_milestones;
+
+} // namespace
+
+void StartupTimer::start() {
+  if (enabled_)
+    return;
+  enabled_ = true;
+  auto now = boot_time_ns();
+  auto started = process_start_ns();
+  g_origin_ns = started && started <= now ? started : now;
+  mark("main");
+}
+
+void StartupTimer::start_from_environment() {
+  const char *setting = std::getenv("XAFILE_STARTUP_TIMINGS");
+  if (setting && *setting && std::strcmp(setting, "0") != 0)
+    start();
+}
+
+void StartupTimer::mark(const char *milestone) {
+  if (!enabled_)
+    return;
+  for (const auto &m : g_milestones)
+    if (std::strcmp(m.name, milestone) == 0)
+      return;
+  g_milestones.push_back({milestone, boot_time_ns() - g_origin_ns});
+}
+
+void StartupTimer::finish(const char *milestone) {
+  if (!enabled_)
+    return;
+  mark(milestone);
+  enabled_ = false;
+  for (const auto &m : g_milestones)
+    std::fprintf(stderr, "startup: %s %.1f ms\n", m.name, m.ns / 1e6);
+  std::vector<Milestone>().swap(g_milestones);
+}
+
+} // namespace xafile
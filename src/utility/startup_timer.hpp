@@ -0,0 +1,50 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace xafile {
+
+// Startup milestones, timed from when the kernel started the process and
+// printed on stderr once the first listing has been painted:
+//
+//   startup: main 3.2 ms
+//   startup: window-presented 41.0 ms
+//   ...
+//
+// Off unless XAFILE_STARTUP_TIMINGS is set or --startup-timings is given.
+// Main thread only.
+class StartupTimer {
+public:
+  static bool enabled() { return enabled_; }
+  static void start();
+  static void start_from_environment();
+
+  // Records the first time `milestone` is reached, which has to be a
+  // string literal
+  static void mark(const char *milestone);
+  // The last milestone; prints the report and stops
+  static void finish(const char *milestone);
+
+private:
+  static inline bool enabled_ = false;
+};
+
+} // namespace xafile
@@ -0,0 +1,206 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "trace.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+// About 300 MB of events; anything past that is counted and dropped
+constexpr std::size_t kMaxEvents = 4'000'000;
+
+struct Event {
+  const char *name;
+  char phase; // 'X' span, 'b'/'e' navigation begin and end
+  std::uint64_t ts_ns;
+  std::uint64_t dur_ns;
+  std::uint64_t navigation;
+  std::int64_t count;
+  std::string detail;
+};
+
+// Each thread appends to its own buffer, so the lock is never contended
+// except while the trace is written
+struct ThreadBuffer {
+  std::mutex mutex;
+  pid_t tid;
+  std::vector<Event> events;
+};
+
+struct Recorder {
+  std::mutex mutex;
+  std::string path;
+  // Kept after their threads exit, until the trace is written
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::atomic<std::size_t> events{0};
+  std::atomic<std::size_t> dropped{0};
+  std::atomic<std::uint64_t> last_navigation{0};
+};
+
+Recorder &recorder() {
+  // Worker threads may still record while the process exits
+  static auto *instance = new Recorder();
+  return *instance;
+}
+
+ThreadBuffer &thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto created = std::make_shared<ThreadBuffer>();
+    created->tid = gettid();
+    auto &r = recorder();
+    std::lock_guard lock(r.mutex);
+    r.buffers.push_back(created);
+    return created;
+  }();
+  return *buffer;
+}
+
+void record(Event &&event) {
+  auto &r = recorder();
+  if (r.events.fetch_add(1, std::memory_order_relaxed) >= kMaxEvents) {
+    r.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto &buffer = thread_buffer();
+  std::lock_guard lock(buffer.mutex);
+  buffer.events.push_back(std::move(event));
+}
+
+void write_escaped(std::FILE *out, const std::string &s) {
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\')
+      std::fprintf(out, "\\%c", c);
+    else if (c < 0x20)
+      std::fprintf(out, "\\u%04x", c);
+    else
+      std::fputc(c, out);
+  }
+}
+
+} // namespace
+
+void Trace::start(const std::string &path) {
+  auto &r = recorder();
+  {
+    std::lock_guard lock(r.mutex);
+    r.path = path;
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void Trace::start_from_environment() {
+  const char *path = std::getenv("XAFILE_TRACE");
+  if (path && *path)
+    start(path);
+}
+
+std::uint64_t Trace::now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return std::uint64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+void Trace::complete(const char *name, std::uint64_t start_ns,
+                     std::uint64_t navigation, std::int64_t count) {
+  auto end = now_ns();
+  record({name, 'X', start_ns, end - start_ns, navigation, count, {}});
+}
+
+std::uint64_t Trace::begin_navigation(const std::string &path) {
+  if (!enabled())
+    return 0;
+  auto id = recorder().last_navigation.fetch_add(1) + 1;
+  navigation_.store(id, std::memory_order_relaxed);
+  record({"navigate", 'b', now_ns(), 0, id, -1, path});
+  return id;
+}
+
+void Trace::end_navigation(std::uint64_t id) {
+  if (id == 0 || !enabled())
+    return;
+  record({"navigate", 'e', now_ns(), 0, id, -1, {}});
+}
+
+void Trace::write() {
+  if (!enabled())
+    return;
+  enabled_.store(false, std::memory_order_relaxed);
+
+  auto &r = recorder();
+  std::lock_guard lock(r.mutex);
+  std::FILE *out = std::fopen(r.path.c_str(), "w");
+  if (!out) {
+    std::perror(r.path.c_str());
+    return;
+  }
+
+  auto pid = getpid();
+  std::fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  std::fprintf(out,
+               "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %d, "
+               "\"args\": {\"name\": \"xafile\"}}",
+               pid);
+  for (const auto &buffer : r.buffers) {
+    std::lock_guard buffer_lock(buffer->mutex);
+    if (buffer->tid == pid)
+      std::fprintf(out,
+                   ",\n{\"ph\": \"M\", \"name\": \"thread_name\", "
+                   "\"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"main\"}}",
+                   pid, buffer->tid);
+    for (const auto &e : buffer->events) {
+      std::fprintf(out,
+                   ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", "
+                   "\"ts\": %.3f, \"pid\": %d, \"tid\": %d",
+                   e.name, e.phase == 'X' ? "xafile" : "navigation", e.phase,
+                   e.ts_ns / 1000.0, pid, buffer->tid);
+      if (e.phase == 'X')
+        std::fprintf(out, ", \"dur\": %.3f", e.dur_ns / 1000.0);
+      else
+        std::fprintf(out, ", \"id\": %llu",
+                     static_cast<unsigned long long>(e.navigation));
+      std::fprintf(out, ", \"args\": {\"nav\": %llu",
+                   static_cast<unsigned long long>(e.navigation));
+      if (e.count >= 0)
+        std::fprintf(out, ", \"count\": %lld", static_cast<long long>(e.count));
+      if (!e.detail.empty()) {
+        std::fprintf(out, ", \"path\": \"");
+        write_escaped(out, e.detail);
+        std::fputc('"', out);
+      }
+      std::fprintf(out, "}}");
+    }
+  }
+  std::fprintf(out, "\n]}\n");
+  std::fclose(out);
+
+  if (auto dropped = r.dropped.load())
+    std::cerr << "trace: dropped " << dropped << " events past "
+              << kMaxEvents << '\n';
+  std::cerr << "trace written to " << r.path << '\n';
+}
+
+} // namespace xafile
@@ -0,0 +1,90 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace xafile {
+
+// Timing spans around the hot paths, written as a Chrome trace that
+// ui.perfetto.dev and chrome://tracing open. Off unless XAFILE_TRACE or
+// --trace names the file, and then only a relaxed load per span.
+//
+// Each navigation gets an id. Spans started while it is the latest one
+// carry it as "nav", and the navigation itself is an async span from the
+// click to the first frame painted with its rows.
+class Trace {
+public:
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Starts recording into `path`, which is written by write()
+  static void start(const std::string &path);
+  // Starts recording if XAFILE_TRACE is set
+  static void start_from_environment();
+  // Writes what was recorded; called once when the application exits
+  static void write();
+
+  static std::uint64_t now_ns();
+  static void complete(const char *name, std::uint64_t start_ns,
+                       std::uint64_t navigation, std::int64_t count);
+
+  // Returns the new navigation id, 0 while tracing is off
+  static std::uint64_t begin_navigation(const std::string &path);
+  static void end_navigation(std::uint64_t id);
+  static std::uint64_t navigation() {
+    return navigation_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static inline std::atomic<bool> enabled_{false};
+  static inline std::atomic<std::uint64_t> navigation_{0};
+};
+
+// Records a span from construction to destruction. `name` has to be a
+// string literal. `count` shows up as an argument when set, e.g. the
+// number of entries handled.
+class TraceSpan {
+public:
+  explicit TraceSpan(const char *name, std::int64_t count = -1)
+      : name_(Trace::enabled() ? name : nullptr), count_(count) {
+    if (name_) {
+      navigation_ = Trace::navigation();
+      start_ = Trace::now_ns();
+    }
+  }
+  ~TraceSpan() {
+    if (name_)
+      Trace::complete(name_, start_, navigation_, count_);
+  }
+
+  TraceSpan(const TraceSpan &) = delete;
+  TraceSpan &operator=(const TraceSpan &) = delete;
+
+  void set_count(std::int64_t count) { count_ = count; }
+
+private:
+  const char *name_;
+  std::int64_t count_;
+  std::uint64_t navigation_ = 0;
+  std::uint64_t start_ = 0;
+};
+
+} // namespace xafile
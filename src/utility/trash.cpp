@@ -0,0 +1,197 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "trash.hpp"
+#include <glib.h>
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+std::string parent_of(const std::string &path) {
+  auto slash = path.rfind('/');
+  if (slash == std::string::npos || slash == 0)
+    return "/";
+  return path.substr(0, slash);
+}
+
+// The outermost directory above `path` still on device `dev`
+std::string mount_top(const std::string &path, dev_t dev) {
+  std::string dir = parent_of(path);
+  while (dir != "/") {
+    auto parent = parent_of(dir);
+    struct stat st;
+    if (stat(parent.c_str(), &st) != 0 || st.st_dev != dev)
+      break;
+    dir = std::move(parent);
+  }
+  return dir;
+}
+
+// A directory of ours, not a symlink someone else planted
+bool is_private_dir(const std::string &path) {
+  struct stat st;
+  return lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+         st.st_uid == getuid();
+}
+
+std::optional<TrashDir> prepare(std::string path, std::string top) {
+  mkdir(path.c_str(), 0700);
+  if (!is_private_dir(path))
+    return std::nullopt;
+  mkdir((path + "/files").c_str(), 0700);
+  mkdir((path + "/info").c_str(), 0700);
+  if (!is_private_dir(path + "/files") || !is_private_dir(path + "/info"))
+    return std::nullopt;
+  return TrashDir{std::move(path), std::move(top)};
+}
+
+} // namespace
+
+std::optional<TrashDir> home_trash() {
+  std::string data_dir = g_get_user_data_dir();
+  if (g_mkdir_with_parents(data_dir.c_str(), 0700) != 0)
+    return std::nullopt;
+  return prepare(data_dir + "/Trash", {});
+}
+
+std::optional<TrashDir> trash_for(const std::string &path, dev_t dev) {
+  if (auto home = home_trash()) {
+    struct stat st;
+    if (stat(home->path.c_str(), &st) == 0 && st.st_dev == dev)
+      return home;
+  }
+
+  auto top = mount_top(path, dev);
+  auto uid = std::to_string(getuid());
+  auto base = top == "/" ? std::string() : top;
+
+  // An administrator provided .Trash only counts when it is sticky, so
+  // users cannot remove each other's directories in it
+  auto shared = base + "/.Trash";
+  struct stat st;
+  if (lstat(shared.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+      (st.st_mode & S_ISVTX)) {
+    if (auto trash = prepare(shared + "/" + uid, top))
+      return trash;
+  }
+  return prepare(base + "/.Trash-" + uid, top);
+}
+
+TrashBatch::TrashBatch(TrashDir trash) : trash_(std::move(trash)) {
+  files_fd_ = open((trash_.path + "/files").c_str(),
+                   O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  info_fd_ = open((trash_.path + "/info").c_str(),
+                  O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (files_fd_ < 0 || info_fd_ < 0)
+    error_ = errno;
+
+  char date[32];
+  std::time_t now = std::time(nullptr);
+  std::tm local;
+  localtime_r(&now, &local);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &local);
+  deletion_date_ = date;
+}
+
+TrashBatch::~TrashBatch() {
+  if (files_fd_ >= 0)
+    close(files_fd_);
+  if (info_fd_ >= 0)
+    close(info_fd_);
+}
+
+std::optional<std::string> TrashBatch::reserve(const std::string &path,
+                                               int &error) {
+  // Per-device trashes record where the file was below their mount point
+  std::string_view recorded = path;
+  if (!trash_.top.empty() && trash_.top != "/" &&
+      recorded.starts_with(trash_.top + "/"))
+    recorded.remove_prefix(trash_.top.size() + 1);
+  else if (trash_.top == "/")
+    recorded.remove_prefix(1);
+  char *escaped =
+      g_uri_escape_string(std::string(recorded).c_str(), "/", FALSE);
+  std::string info = "[Trash Info]\nPath=";
+  info += escaped;
+  info += "\nDeletionDate=" + deletion_date_ + "\n";
+  g_free(escaped);
+
+  auto slash = path.rfind('/');
+  std::string base =
+      slash == std::string::npos ? path : path.substr(slash + 1);
+  for (int n = 1;; n++) {
+    auto name = n == 1 ? base : base + "." + std::to_string(n);
+    struct stat st;
+    if (fstatat(files_fd_, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == 0)
+      continue;
+    // Creating the info file is what claims the name
+    int fd = openat(info_fd_, (name + ".trashinfo").c_str(),
+                    O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+      if (errno == EEXIST)
+        continue;
+      error = errno;
+      return std::nullopt;
+    }
+    // Its contents have to be on disk before the file is moved in, the
+    // directory entry is synced for the whole batch by sync()
+    bool written = write(fd, info.data(), info.size()) ==
+                       static_cast<ssize_t>(info.size()) &&
+                   fdatasync(fd) == 0;
+    error = written ? 0 : errno;
+    if (close(fd) != 0 && written) {
+      written = false;
+      error = errno;
+    }
+    if (!written) {
+      release(name);
+      return std::nullopt;
+    }
+    return name;
+  }
+}
+
+int TrashBatch::move_in(const std::string &path, const std::string &name) {
+  if (renameat(AT_FDCWD, path.c_str(), files_fd_, name.c_str()) != 0)
+    return errno;
+  return 0;
+}
+
+void TrashBatch::release(const std::string &name) {
+  unlinkat(info_fd_, (name + ".trashinfo").c_str(), 0);
+}
+
+std::string TrashBatch::file_path(const std::string &name) const {
+  return trash_.path + "/files/" + name;
+}
+
+void TrashBatch::sync() {
+  // The info files themselves were synced as they were written
+  if (info_fd_ >= 0)
+    fsync(info_fd_);
+}
+
+} // namespace xafile
@@ -0,0 +1,80 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <sys/types.h>
+
+namespace xafile {
+
+// A freedesktop.org trash directory: trashed files go to "files", and a
+// .trashinfo file for each, saying where it came from, to "info".
+struct TrashDir {
+  std::string path;
+  // Mount point of a per-device trash, which records paths relative to
+  // it. Empty for the home trash, which records absolute paths.
+  std::string top;
+};
+
+// The trash in the user's data directory, created when missing
+std::optional<TrashDir> home_trash();
+
+// The trash a file on device `dev` can be renamed into: the home trash
+// when it is on that device, otherwise $top/.Trash/$uid or $top/.Trash-$uid
+// on the mount holding `path`. Empty when that device has none and one
+// cannot be created.
+std::optional<TrashDir> trash_for(const std::string &path, dev_t dev);
+
+// Trashes files into one trash directory in two passes: reserve() writes
+// the .trashinfo of every file, then move_in() renames them all, so the
+// info files are written back to back.
+class TrashBatch {
+public:
+  explicit TrashBatch(TrashDir trash);
+  ~TrashBatch();
+
+  TrashBatch(const TrashBatch &) = delete;
+  TrashBatch &operator=(const TrashBatch &) = delete;
+
+  int error() const { return error_; }
+
+  // Claims a free name for the absolute `path` by creating its .trashinfo,
+  // whose contents are on disk when this returns. Returns the name, or
+  // nullopt with `error` set.
+  std::optional<std::string> reserve(const std::string &path, int &error);
+  // Renames `path` to the reserved `name`; returns errno, 0 on success
+  int move_in(const std::string &path, const std::string &name);
+  // Gives a reserved name back, e.g. because the file could not be moved
+  void release(const std::string &name);
+  // Where a file reserved as `name` goes, for copying it in
+  std::string file_path(const std::string &name) const;
+  // Makes the info files written so far durable, along with their names
+  // in the info directory
+  void sync();
+
+private:
+  TrashDir trash_;
+  int files_fd_ = -1;
+  int info_fd_ = -1;
+  int error_ = 0;
+  std::string deletion_date_;
+};
+
+} // namespace xafile
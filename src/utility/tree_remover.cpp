@@ -0,0 +1,208 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tree_remover.hpp"
+#include "dir_reader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr unsigned kMaxWorkers = 8;
+
+} // namespace
+
+struct TreeRemover::Node {
+  Node *parent;
+  std::string name; // relative to the parent's fd, a full path for roots
+  dev_t dev;
+  int fd = -1; // open from its listing until it is removed
+  // Its own listing, plus each subdirectory still there
+  std::atomic<std::uint32_t> pending{1};
+  // Something inside could not be removed, so neither can the directory
+  std::atomic<bool> failed{false};
+
+  Node(Node *parent, std::string name, dev_t dev)
+      : parent(parent), name(std::move(name)), dev(dev) {}
+};
+
+TreeRemover::TreeRemover(const std::atomic<bool> &cancelled,
+                         CountCallback on_found, CountCallback on_removed,
+                         ErrorCallback on_error)
+    : cancelled_(cancelled), on_found_(std::move(on_found)),
+      on_removed_(std::move(on_removed)), on_error_(std::move(on_error)) {}
+
+void TreeRemover::remove(const std::vector<std::string> &paths) {
+  std::vector<Node *> roots;
+  for (const auto &path : paths) {
+    struct stat st;
+    if (lstat(path.c_str(), &st) != 0) {
+      on_error_(path, errno);
+      continue;
+    }
+    on_found_(1);
+    if (S_ISDIR(st.st_mode)) {
+      roots.push_back(new Node(nullptr, path, st.st_dev));
+    } else if (unlink(path.c_str()) == 0) {
+      on_removed_(1);
+    } else {
+      on_error_(path, errno);
+    }
+  }
+  if (roots.empty())
+    return;
+
+  roots_left_ = roots.size();
+  shared_ = std::move(roots);
+  unsigned workers =
+      std::clamp(std::thread::hardware_concurrency(), 2u, kMaxWorkers);
+  std::vector<std::jthread> threads;
+  for (unsigned i = 0; i < workers; i++)
+    threads.emplace_back([this] { work(); });
+}
+
+void TreeRemover::work() {
+  // Depth first, so only the directories on the current path stay open
+  std::vector<Node *> stack;
+  for (;;) {
+    Node *node;
+    if (!stack.empty()) {
+      node = stack.back();
+      stack.pop_back();
+    } else {
+      std::unique_lock lock(mutex_);
+      idle_++;
+      wake_.wait(lock,
+                 [this] { return !shared_.empty() || roots_left_ == 0; });
+      idle_--;
+      if (shared_.empty())
+        return;
+      node = shared_.back();
+      shared_.pop_back();
+    }
+    visit(node, stack);
+  }
+}
+
+void TreeRemover::visit(Node *node, std::vector<Node *> &stack) {
+  // Whatever is left is only closed and freed
+  if (cancelled_.load(std::memory_order_relaxed)) {
+    node->failed = true;
+    finish(node);
+    return;
+  }
+
+  int parent_fd = node->parent ? node->parent->fd : AT_FDCWD;
+  DirReader reader(parent_fd, node->name.c_str());
+  struct stat st;
+  if (!reader.is_open() || fstat(reader.fd(), &st) != 0) {
+    fail(node, {}, reader.is_open() ? errno : reader.error());
+    finish(node);
+    return;
+  }
+  if (st.st_dev != node->dev) {
+    fail(node, {}, EXDEV);
+    finish(node);
+    return;
+  }
+
+  std::vector<Node *> children;
+  std::vector<DirEntry> entries;
+  while (reader.read(entries)) {
+    on_found_(entries.size());
+    std::uint64_t removed = 0;
+    for (const auto &e : entries) {
+      if (e.kind == EntryKind::Directory && !e.is_symlink) {
+        node->pending++;
+        children.push_back(new Node(node, std::string(e.name), node->dev));
+      } else if (unlinkat(reader.fd(), e.name.data(), 0) == 0) {
+        removed++;
+      } else {
+        fail(node, e.name, errno);
+      }
+    }
+    if (removed > 0)
+      on_removed_(removed);
+  }
+  if (reader.error() != 0)
+    fail(node, {}, reader.error());
+  node->fd = reader.release_fd();
+
+  for (auto *child : children) {
+    if (idle_ == 0) {
+      stack.push_back(child);
+      continue;
+    }
+    {
+      std::lock_guard lock(mutex_);
+      shared_.push_back(child);
+    }
+    wake_.notify_one();
+  }
+  finish(node);
+}
+
+// Drops one pending count, removing the directory once it was the last
+void TreeRemover::finish(Node *node) {
+  while (node && --node->pending == 0) {
+    if (node->fd >= 0)
+      close(node->fd);
+    Node *parent = node->parent;
+    int parent_fd = parent ? parent->fd : AT_FDCWD;
+    if (node->failed) {
+      if (parent)
+        parent->failed = true;
+    } else if (unlinkat(parent_fd, node->name.c_str(), AT_REMOVEDIR) == 0) {
+      on_removed_(1);
+    } else {
+      fail(node, {}, errno);
+      if (parent)
+        parent->failed = true;
+    }
+
+    if (!parent) {
+      std::lock_guard lock(mutex_);
+      if (--roots_left_ == 0)
+        wake_.notify_all();
+    }
+    delete node;
+    node = parent;
+  }
+}
+
+void TreeRemover::fail(Node *node, std::string_view name, int error) {
+  node->failed = true;
+  auto path = path_of(node);
+  if (!name.empty())
+    (path += '/') += name;
+  on_error_(path, error);
+}
+
+std::string TreeRemover::path_of(const Node *node) {
+  if (!node->parent)
+    return node->name;
+  return path_of(node->parent) + '/' + node->name;
+}
+
+} // namespace xafile
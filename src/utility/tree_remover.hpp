@@ -0,0 +1,75 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+// Deletes files and whole directory trees on several threads. Each worker
+// goes depth first through its part of the tree and hands subdirectories
+// to idle workers. Entries are unlinked relative to an fd of their
+// directory, and a directory is removed once everything in it is gone, so
+// only a few directories per worker are open at any time. Symlinks are
+// removed, never followed. Other filesystems mounted inside a tree are
+// left alone.
+//
+// The callbacks run on the worker threads.
+class TreeRemover {
+public:
+  // Entries found and entries removed so far, in increments
+  using CountCallback = std::function<void(std::uint64_t count)>;
+  using ErrorCallback = std::function<void(const std::string &path, int error)>;
+
+  TreeRemover(const std::atomic<bool> &cancelled, CountCallback on_found,
+              CountCallback on_removed, ErrorCallback on_error);
+
+  // Returns once every path is gone, has failed or the remover was
+  // cancelled
+  void remove(const std::vector<std::string> &paths);
+
+private:
+  struct Node;
+
+  void work();
+  void visit(Node *node, std::vector<Node *> &stack);
+  void finish(Node *node);
+  void fail(Node *node, std::string_view name, int error);
+  static std::string path_of(const Node *node);
+
+  const std::atomic<bool> &cancelled_;
+  CountCallback on_found_;
+  CountCallback on_removed_;
+  ErrorCallback on_error_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::vector<Node *> shared_; // directories up for grabs
+  std::atomic<std::size_t> idle_{0};
+  std::size_t roots_left_ = 0;
+};
+
+} // namespace xafile
@@ -16,36 +16,32 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <algorithm>
+#include "dir_reader.hpp"
+#include "listing.hpp"
+#include "trace.hpp"
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <pwd.h>
 #include <sstream>
 #include <string>
-#include <tuple>
 #include <unistd.h>
 #include <vector>
 
+// Each ContentView has its own, so every window keeps its own directory
 class Utility {
 private:
-  inline static std::filesystem::path homedir{};
-  inline static std::filesystem::path curDir{};
+  std::filesystem::path curDir{};
 
 public:
-  static auto getHome() {
-    homedir = getpwuid(getuid())->pw_dir;
-    // Avoid null while launching app
-    if (curDir == "")
-      curDir = std::string(homedir);
-    return homedir;
+  static std::filesystem::path getHome() {
+    return getpwuid(getuid())->pw_dir;
   }
 
-  static auto getParsedCurDir() {
-    if (curDir.empty())
-      curDir = getHome();
-    std::stringstream ss(curDir);
+  auto getParsedCurDir() {
+    std::stringstream ss(getCurDir());
     std::string segment;
     std::vector<std::string> result;
 
@@ -57,31 +53,36 @@ public:
     return result;
   }
 
-  std::tuple<std::vector<std::filesystem::path>,
-             std::vector<std::filesystem::path>>
-  scan(const std::string &path) {
-    std::vector<std::filesystem::path> dirs;
-    std::vector<std::filesystem::path> files;
+  xafile::Listing scan(const std::string &path) {
+    xafile::TraceSpan span("utility-scan");
+    xafile::Listing listing;
+    xafile::DirReader reader(path.c_str());
+    auto hidden = xafile::HiddenNames::read(reader.fd());
+    std::vector<xafile::DirEntry> entries;
 
-    try {
-      for (const auto &entry : std::filesystem::directory_iterator(path)) {
-        auto name = entry.path().filename().string();
-
-        if (entry.is_directory())
-          dirs.push_back(name);
-        else if (entry.is_regular_file())
-          files.push_back(name);
+    while (reader.read(entries)) {
+      for (const auto &e : entries) {
+        if (e.kind == xafile::EntryKind::Other)
+          continue;
+        auto &entry = listing[listing.add(
+            e.name, e.kind == xafile::EntryKind::Directory)];
+        if (hidden.contains(e.name))
+          entry.is_hidden = true;
       }
-    } catch (const std::filesystem::filesystem_error &e) {
-      std::cerr << e.what() << '\n';
     }
+    if (reader.error() != 0)
+      std::cerr << path << ": " << std::strerror(reader.error()) << '\n';
 
-    std::sort(dirs.begin(), dirs.end());
-    std::sort(files.begin(), files.end());
-
-    return {dirs, files};
+    listing.sort();
+    span.set_count(listing.size());
+    return listing;
   }
 
   auto setCurDir(std::filesystem::path path) { return curDir = path; }
-  auto getCurDir() { return curDir; }
+  auto getCurDir() {
+    // The home directory until something else is opened
+    if (curDir.empty())
+      curDir = getHome();
+    return curDir;
+  }
 };
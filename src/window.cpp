@@ -19,7 +19,10 @@
 #include "window.hpp"
 #include "content_view.hpp"
 #include "gtk/gtkshortcut.h"
+#include "properties_dialog.hpp"
 #include "sidebar.hpp"
+#include <string_view>
+#include <utility>
 
 namespace xafile {
 
@@ -31,10 +34,21 @@ Window::Window(GtkApplication *app) {
   setup_headerbar();
   setup_content();
   setup_actions();
+
+  // Each window goes away with its GtkWindow, and so do its views
+  g_signal_connect_swapped(window_, "destroy",
+                           G_CALLBACK(+[](Window *self) { delete self; }),
+                           this);
 }
 
 Window *Window::create(GtkApplication *app) { return new Window(app); }
 
+Window::~Window() {
+  TransferQueue::instance().disconnect(transfer_listener_);
+  delete content_view_;
+  delete sidebar_;
+}
+
 
 void Window::setup_headerbar() {
   headerbar_ = ADW_HEADER_BAR(adw_header_bar_new());
@@ -96,9 +110,27 @@ void Window::setup_headerbar() {
   g_menu_append(section1, "New File", "win.new-file");
   g_menu_append_section(menu, NULL, G_MENU_MODEL(section1));
 
+  auto *edit_section = g_menu_new();
+  g_menu_append(edit_section, "Cut", "win.cut");
+  g_menu_append(edit_section, "Copy", "win.copy");
+  g_menu_append(edit_section, "Paste", "win.paste");
+  g_menu_append(edit_section, "Move to Trash", "win.trash");
+  g_menu_append(edit_section, "Delete Permanently", "win.delete");
+  g_menu_append_section(menu, NULL, G_MENU_MODEL(edit_section));
+
   auto *section2 = g_menu_new();
   g_menu_append(section2, "Show Hidden Files", "win.show-hidden");
-  g_menu_append(section2, "Sort By...", "win.sort");
+  auto *sort_menu = g_menu_new();
+  auto *sort_fields = g_menu_new();
+  g_menu_append(sort_fields, "Name", "win.sort::name");
+  g_menu_append(sort_fields, "Size", "win.sort::size");
+  g_menu_append(sort_fields, "Type", "win.sort::type");
+  g_menu_append(sort_fields, "Modified", "win.sort::modified");
+  g_menu_append_section(sort_menu, NULL, G_MENU_MODEL(sort_fields));
+  auto *sort_direction = g_menu_new();
+  g_menu_append(sort_direction, "Reversed Order", "win.sort-descending");
+  g_menu_append_section(sort_menu, NULL, G_MENU_MODEL(sort_direction));
+  g_menu_append_submenu(section2, "Sort By...", G_MENU_MODEL(sort_menu));
   g_menu_append_section(menu, NULL, G_MENU_MODEL(section2));
 
   auto *section3 = g_menu_new();
@@ -109,7 +141,11 @@ void Window::setup_headerbar() {
   gtk_menu_button_set_menu_model(GTK_MENU_BUTTON(menu_btn), G_MENU_MODEL(menu));
   adw_header_bar_pack_end(headerbar_, GTK_WIDGET(menu_btn));
 
+  g_object_unref(sort_fields);
+  g_object_unref(sort_direction);
+  g_object_unref(sort_menu);
   g_object_unref(section1);
+  g_object_unref(edit_section);
   g_object_unref(section2);
   g_object_unref(section3);
   g_object_unref(menu);
@@ -133,9 +169,22 @@ void Window::setup_content() {
   auto *search_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
   gtk_widget_set_halign(search_box, GTK_ALIGN_CENTER);
   gtk_box_append(GTK_BOX(search_box), GTK_WIDGET(search_entry_));
+  gtk_widget_add_css_class(search_box, "linked");
+
+  // Typing filters the current directory; this widens it to a search of
+  // everything below it
+  subfolders_btn_ = gtk_toggle_button_new();
+  gtk_button_set_icon_name(GTK_BUTTON(subfolders_btn_),
+                           "folder-saved-search-symbolic");
+  gtk_widget_set_tooltip_text(subfolders_btn_, "Search Subfolders");
+  g_signal_connect(subfolders_btn_, "toggled",
+                   G_CALLBACK(on_subfolders_toggled), this);
+  gtk_box_append(GTK_BOX(search_box), subfolders_btn_);
 
   gtk_search_bar_set_child(search_bar_, search_box);
   gtk_search_bar_connect_entry(search_bar_, GTK_EDITABLE(search_entry_));
+  g_signal_connect(search_entry_, "search-changed",
+                   G_CALLBACK(on_search_changed), this);
   gtk_box_append(GTK_BOX(main_box), GTK_WIDGET(search_bar_));
 
   split_view_ = ADW_NAVIGATION_SPLIT_VIEW(adw_navigation_split_view_new());
@@ -150,6 +199,8 @@ void Window::setup_content() {
   content_view_->set_on_history_changed(
       [this](bool can_back, bool can_forward) {
         update_nav_buttons(can_back, can_forward);
+        // Navigating ends a search, the new directory is shown as is
+        gtk_editable_set_text(GTK_EDITABLE(search_entry_), "");
       });
   sidebar_->set_content_view(content_view_);
   auto *content_page =
@@ -165,6 +216,32 @@ void Window::setup_content() {
   gtk_widget_set_margin_top(status_bar, 6);
   gtk_widget_set_margin_bottom(status_bar, 6);
 
+  // Progress of copies and moves, shown while one runs
+  transfer_box_ = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 12);
+  gtk_widget_set_hexpand(transfer_box_, TRUE);
+  gtk_widget_set_visible(transfer_box_, FALSE);
+  transfer_label_ = gtk_label_new("");
+  gtk_label_set_ellipsize(GTK_LABEL(transfer_label_), PANGO_ELLIPSIZE_END);
+  gtk_box_append(GTK_BOX(transfer_box_), transfer_label_);
+  transfer_bar_ = gtk_progress_bar_new();
+  gtk_widget_set_hexpand(transfer_bar_, TRUE);
+  gtk_widget_set_valign(transfer_bar_, GTK_ALIGN_CENTER);
+  gtk_box_append(GTK_BOX(transfer_box_), transfer_bar_);
+  auto *cancel_btn = gtk_button_new_from_icon_name("process-stop-symbolic");
+  gtk_widget_set_tooltip_text(cancel_btn, "Cancel");
+  gtk_widget_add_css_class(cancel_btn, "flat");
+  g_signal_connect_swapped(
+      cancel_btn, "clicked", G_CALLBACK(+[](Window *self) {
+        TransferQueue::instance().cancel(self->transfer_id_);
+      }),
+      this);
+  gtk_box_append(GTK_BOX(transfer_box_), cancel_btn);
+  gtk_box_append(GTK_BOX(status_bar), transfer_box_);
+  transfer_listener_ = TransferQueue::instance().connect(
+      [this](const TransferProgress &progress) {
+        on_transfer_progress(progress);
+      });
+
   gtk_box_append(GTK_BOX(main_box), status_bar);
 
   adw_application_window_set_content(window_, main_box);
@@ -181,15 +258,74 @@ void Window::setup_actions() {
   g_action_map_add_action(G_ACTION_MAP(action_group),
                           G_ACTION(new_file_action));
 
+  auto *copy_action = g_simple_action_new("copy", NULL);
+  g_signal_connect(copy_action, "activate", G_CALLBACK(on_copy), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(copy_action));
+
+  auto *cut_action = g_simple_action_new("cut", NULL);
+  g_signal_connect(cut_action, "activate", G_CALLBACK(on_copy), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(cut_action));
+
+  auto *paste_action = g_simple_action_new("paste", NULL);
+  g_signal_connect(paste_action, "activate", G_CALLBACK(on_paste), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(paste_action));
+
+  auto *trash_action = g_simple_action_new("trash", NULL);
+  g_signal_connect(trash_action, "activate", G_CALLBACK(on_trash), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(trash_action));
+
+  auto *delete_action = g_simple_action_new("delete", NULL);
+  g_signal_connect(delete_action, "activate", G_CALLBACK(on_delete), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(delete_action));
+
+  // Only while the files have focus, so text fields keep their own
+  // clipboard shortcuts
+  auto *shortcuts = gtk_shortcut_controller_new();
+  const std::pair<const char *, const char *> bindings[] = {
+      {"<Control>c", "win.copy"},
+      {"<Control>x", "win.cut"},
+      {"<Control>v", "win.paste"},
+      {"Delete", "win.trash"},
+      {"<Shift>Delete", "win.delete"},
+      {"<Control><Shift>d", "win.diagnostics"},
+  };
+  for (auto [trigger, action] : bindings)
+    gtk_shortcut_controller_add_shortcut(
+        GTK_SHORTCUT_CONTROLLER(shortcuts),
+        gtk_shortcut_new(gtk_shortcut_trigger_parse_string(trigger),
+                         gtk_named_action_new(action)));
+  gtk_widget_add_controller(content_view_->get_widget(), shortcuts);
+
   auto *show_hidden_action = g_simple_action_new_stateful(
       "show-hidden", NULL, g_variant_new_boolean(FALSE));
+  g_signal_connect(show_hidden_action, "change-state",
+                   G_CALLBACK(on_show_hidden_changed), this);
   g_action_map_add_action(G_ACTION_MAP(action_group),
                           G_ACTION(show_hidden_action));
 
-  auto *sort_action = g_simple_action_new("sort", NULL);
+  auto *diagnostics_action = g_simple_action_new_stateful(
+      "diagnostics", NULL, g_variant_new_boolean(FALSE));
+  g_signal_connect(diagnostics_action, "change-state",
+                   G_CALLBACK(on_diagnostics_changed), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group),
+                          G_ACTION(diagnostics_action));
+
+  auto *sort_action = g_simple_action_new_stateful(
+      "sort", G_VARIANT_TYPE_STRING, g_variant_new_string("name"));
+  g_signal_connect(sort_action, "change-state", G_CALLBACK(on_sort_changed),
+                   this);
   g_action_map_add_action(G_ACTION_MAP(action_group), G_ACTION(sort_action));
 
+  auto *sort_descending_action = g_simple_action_new_stateful(
+      "sort-descending", NULL, g_variant_new_boolean(FALSE));
+  g_signal_connect(sort_descending_action, "change-state",
+                   G_CALLBACK(on_sort_changed), this);
+  g_action_map_add_action(G_ACTION_MAP(action_group),
+                          G_ACTION(sort_descending_action));
+
   auto *properties_action = g_simple_action_new("properties", NULL);
+  g_signal_connect(properties_action, "activate", G_CALLBACK(on_properties),
+                   this);
   g_action_map_add_action(G_ACTION_MAP(action_group),
                           G_ACTION(properties_action));
 
@@ -200,6 +336,190 @@ void Window::setup_actions() {
                                  G_ACTION_GROUP(action_group));
 }
 
+void Window::on_sort_changed(GSimpleAction *action, GVariant *value,
+                             gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  g_simple_action_set_state(action, value);
+
+  std::string_view action_name = g_action_get_name(G_ACTION(action));
+  if (action_name == "sort-descending") {
+    self->sort_.descending = g_variant_get_boolean(value);
+  } else {
+    std::string_view field = g_variant_get_string(value, nullptr);
+    if (field == "size")
+      self->sort_.field = SortField::Size;
+    else if (field == "type")
+      self->sort_.field = SortField::Type;
+    else if (field == "modified")
+      self->sort_.field = SortField::Modified;
+    else
+      self->sort_.field = SortField::Name;
+  }
+
+  if (self->content_view_)
+    self->content_view_->set_sort(self->sort_);
+}
+
+void Window::on_show_hidden_changed(GSimpleAction *action, GVariant *value,
+                                    gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  g_simple_action_set_state(action, value);
+  if (self->content_view_)
+    self->content_view_->set_show_hidden(g_variant_get_boolean(value));
+}
+
+void Window::on_diagnostics_changed(GSimpleAction *action, GVariant *value,
+                                    gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  g_simple_action_set_state(action, value);
+  if (self->content_view_)
+    self->content_view_->set_diagnostics_visible(g_variant_get_boolean(value));
+}
+
+void Window::on_copy(GSimpleAction *action, GVariant *, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  auto paths = self->content_view_->selected_paths();
+  if (paths.empty())
+    return;
+  self->clipboard_ = std::move(paths);
+  self->clipboard_cut_ =
+      std::string_view(g_action_get_name(G_ACTION(action))) == "cut";
+}
+
+void Window::on_paste(GSimpleAction *, GVariant *, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  if (self->clipboard_.empty())
+    return;
+  auto kind = self->clipboard_cut_ ? TransferKind::Move : TransferKind::Copy;
+  auto sources = self->clipboard_;
+  // Cut files can only be moved once
+  if (self->clipboard_cut_)
+    self->clipboard_.clear();
+  TransferQueue::instance().enqueue(kind, std::move(sources),
+                                    self->content_view_->current_path());
+}
+
+void Window::on_trash(GSimpleAction *, GVariant *, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  auto paths = self->content_view_->selected_paths();
+  if (paths.empty())
+    return;
+  TransferQueue::instance().enqueue(TransferKind::Trash, std::move(paths), {});
+}
+
+void Window::on_delete(GSimpleAction *, GVariant *, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  auto paths = self->content_view_->selected_paths();
+  if (paths.empty())
+    return;
+
+  std::string heading;
+  if (paths.size() == 1) {
+    char *name = g_path_get_basename(paths.front().c_str());
+    heading = std::string("Permanently delete \u201c") + name + "\u201d?";
+    g_free(name);
+  } else {
+    heading = "Permanently delete " + std::to_string(paths.size()) + " items?";
+  }
+  self->pending_delete_ = std::move(paths);
+  auto *dialog = adw_alert_dialog_new(
+      heading.c_str(), "Deleted items are not sent to the trash and cannot "
+                       "be restored.");
+  adw_alert_dialog_add_responses(ADW_ALERT_DIALOG(dialog), "cancel",
+                                 "_Cancel", "delete", "_Delete", NULL);
+  adw_alert_dialog_set_response_appearance(ADW_ALERT_DIALOG(dialog), "delete",
+                                           ADW_RESPONSE_DESTRUCTIVE);
+  adw_alert_dialog_set_default_response(ADW_ALERT_DIALOG(dialog), "cancel");
+  adw_alert_dialog_set_close_response(ADW_ALERT_DIALOG(dialog), "cancel");
+  g_signal_connect(dialog, "response", G_CALLBACK(on_delete_response), self);
+  adw_dialog_present(dialog, GTK_WIDGET(self->window_));
+}
+
+void Window::on_delete_response(AdwAlertDialog *, const char *response,
+                                gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  auto paths = std::move(self->pending_delete_);
+  self->pending_delete_.clear();
+  if (std::string_view(response) != "delete" || paths.empty())
+    return;
+  TransferQueue::instance().enqueue(TransferKind::Delete, std::move(paths),
+                                    {});
+}
+
+void Window::on_properties(GSimpleAction *, GVariant *, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  // Without a selection, the folder being shown
+  auto paths = self->content_view_->selected_paths();
+  if (paths.empty())
+    paths.push_back(self->content_view_->current_path());
+  PropertiesDialog::present(GTK_WIDGET(self->window_), std::move(paths));
+}
+
+void Window::on_transfer_progress(const TransferProgress &progress) {
+  transfer_id_ = progress.id;
+  const char *done_verb = "copied";
+  const char *running_verb = "Copying ";
+  switch (progress.kind) {
+  case TransferKind::Move:
+    done_verb = "moved";
+    running_verb = "Moving ";
+    break;
+  case TransferKind::Trash:
+    done_verb = "moved to the trash";
+    running_verb = "Moving to the trash: ";
+    break;
+  case TransferKind::Delete:
+    done_verb = "deleted";
+    running_verb = "Deleting ";
+    break;
+  default:
+    break;
+  }
+  std::string text;
+  if (progress.finished) {
+    if (progress.queued > 0)
+      return;
+    if (progress.errors.empty() || progress.cancelled) {
+      gtk_widget_set_visible(transfer_box_, FALSE);
+      return;
+    }
+    // Stays up, with the details in the tooltip, until the next transfer
+    text = std::to_string(progress.errors.size()) +
+           (progress.errors.size() == 1 ? " file" : " files") +
+           " could not be " + done_verb;
+    std::string details;
+    for (const auto &error : progress.errors)
+      details += (details.empty() ? "" : "\n") + error;
+    gtk_widget_set_tooltip_text(transfer_label_, details.c_str());
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(transfer_bar_), 1.0);
+  } else {
+    text = std::string(running_verb) + std::to_string(progress.items_done) +
+           " of " + std::to_string(progress.items_total) + " items";
+    // Deletions and renames have no bytes to count
+    if (progress.bytes_total > 0) {
+      char *done = g_format_size(progress.bytes_done);
+      char *total = g_format_size(progress.bytes_total);
+      char *rate =
+          g_format_size(static_cast<guint64>(progress.bytes_per_second));
+      text += std::string(", ") + done + " of " + total + " (" + rate + "/s)";
+      g_free(done);
+      g_free(total);
+      g_free(rate);
+    }
+    if (progress.queued > 0)
+      text += ", " + std::to_string(progress.queued) + " more waiting";
+    gtk_widget_set_tooltip_text(transfer_label_, nullptr);
+    double fraction = 0.0;
+    if (progress.bytes_total > 0)
+      fraction = static_cast<double>(progress.bytes_done) / progress.bytes_total;
+    else if (progress.items_total > 0)
+      fraction = static_cast<double>(progress.items_done) / progress.items_total;
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(transfer_bar_), fraction);
+  }
+  gtk_label_set_text(GTK_LABEL(transfer_label_), text.c_str());
+  gtk_widget_set_visible(transfer_box_, TRUE);
+}
+
 void Window::on_back_clicked(GtkButton *button, gpointer user_data) {
   (void)button;
   auto *self = static_cast<Window *>(user_data);
@@ -225,6 +545,35 @@ void Window::on_search_toggled(GtkToggleButton *button, gpointer user_data) {
   auto *self = static_cast<Window *>(user_data);
   gboolean active = gtk_toggle_button_get_active(button);
   gtk_search_bar_set_search_mode(self->search_bar_, active);
+  if (!active)
+    gtk_editable_set_text(GTK_EDITABLE(self->search_entry_), "");
+}
+
+void Window::on_search_changed(GtkSearchEntry *entry, gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  if (!self->content_view_)
+    return;
+  const char *text = gtk_editable_get_text(GTK_EDITABLE(entry));
+  if (gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(self->subfolders_btn_)))
+    self->content_view_->search(text);
+  else
+    self->content_view_->filter(text);
+}
+
+void Window::on_subfolders_toggled(GtkToggleButton *button,
+                                   gpointer user_data) {
+  auto *self = static_cast<Window *>(user_data);
+  if (!self->content_view_)
+    return;
+  // Hand the current text over from one mode to the other
+  const char *text = gtk_editable_get_text(GTK_EDITABLE(self->search_entry_));
+  if (gtk_toggle_button_get_active(button)) {
+    self->content_view_->filter("");
+    self->content_view_->search(text);
+  } else {
+    self->content_view_->search("");
+    self->content_view_->filter(text);
+  }
 }
 
 void Window::on_view_mode_changed(GtkToggleButton *button, gpointer user_data) {
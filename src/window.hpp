@@ -18,9 +18,15 @@
 
 #pragma once
 
+#include "transfer_queue.hpp"
+#include "utility/sort_order.hpp"
 #include <adwaita.h>
 #include <gtk/gtk.h>
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 namespace xafile {
 
 class Sidebar;
@@ -34,16 +40,39 @@ public:
 
 private:
   Window(GtkApplication *app);
+  ~Window();
 
   void setup_headerbar();
   void setup_content();
   void setup_actions();
 
   void update_nav_buttons(bool can_back, bool can_forward);
+  void on_transfer_progress(const TransferProgress &progress);
 
+  static void on_sort_changed(GSimpleAction *action, GVariant *value,
+                              gpointer user_data);
+  static void on_show_hidden_changed(GSimpleAction *action, GVariant *value,
+                                     gpointer user_data);
+  static void on_diagnostics_changed(GSimpleAction *action, GVariant *value,
+                                     gpointer user_data);
+  static void on_copy(GSimpleAction *action, GVariant *value,
+                      gpointer user_data);
+  static void on_paste(GSimpleAction *action, GVariant *value,
+                       gpointer user_data);
+  static void on_trash(GSimpleAction *action, GVariant *value,
+                       gpointer user_data);
+  static void on_delete(GSimpleAction *action, GVariant *value,
+                        gpointer user_data);
+  static void on_properties(GSimpleAction *action, GVariant *value,
+                            gpointer user_data);
+  static void on_delete_response(AdwAlertDialog *dialog, const char *response,
+                                 gpointer user_data);
   static void on_back_clicked(GtkButton *button, gpointer user_data);
   static void on_forward_clicked(GtkButton *button, gpointer user_data);
   static void on_search_toggled(GtkToggleButton *button, gpointer user_data);
+  static void on_search_changed(GtkSearchEntry *entry, gpointer user_data);
+  static void on_subfolders_toggled(GtkToggleButton *button,
+                                    gpointer user_data);
   static void on_view_mode_changed(GtkToggleButton *button, gpointer user_data);
 
   AdwApplicationWindow *window_;
@@ -51,6 +80,7 @@ private:
   AdwNavigationSplitView *split_view_;
   GtkSearchBar *search_bar_;
   GtkSearchEntry *search_entry_;
+  GtkWidget *subfolders_btn_;
 
   Sidebar *sidebar_;
   ContentView *content_view_;
@@ -60,6 +90,20 @@ private:
 
   GtkWidget *grid_view_btn_;
   GtkWidget *list_view_btn_;
+
+  SortOrder sort_;
+
+  // Paths picked with Copy or Cut, pasted by the next Paste
+  std::vector<std::string> clipboard_;
+  bool clipboard_cut_ = false;
+  // Selection waiting for the permanent deletion to be confirmed
+  std::vector<std::string> pending_delete_;
+
+  GtkWidget *transfer_box_;
+  GtkWidget *transfer_label_;
+  GtkWidget *transfer_bar_;
+  std::uint64_t transfer_id_ = 0;
+  std::size_t transfer_listener_ = 0;
 };
 
 } // namespace xafile
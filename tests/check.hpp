@@ -0,0 +1,86 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// A few checks shared by the unit tests. Each test is a plain executable
+// that reports failed checks on stderr and exits non-zero if there were
+// any, which is all `meson test` looks at.
+
+#pragma once
+
+#include <glib.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace xafile::test {
+
+inline int failures = 0;
+
+inline void fail(const char *file, int line, const char *what) {
+  std::cerr << file << ':' << line << ": check failed: " << what << '\n';
+  failures++;
+}
+
+// Exit status for main()
+inline int result() { return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE; }
+
+// A fresh directory under the temporary directory, removed again with
+// everything in it
+class TempDir {
+public:
+  TempDir() {
+    path_ = std::string(g_get_tmp_dir()) + "/xafile-test-XXXXXX";
+    if (!mkdtemp(path_.data())) {
+      std::perror(path_.c_str());
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  ~TempDir() {
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+  }
+
+  TempDir(const TempDir &) = delete;
+  TempDir &operator=(const TempDir &) = delete;
+
+  const std::string &path() const { return path_; }
+  std::string operator/(std::string_view name) const {
+    return path_ + '/' + std::string(name);
+  }
+
+private:
+  std::string path_;
+};
+
+inline void write_file(const std::string &path, std::string_view contents) {
+  std::ofstream(path, std::ios::binary)
+      .write(contents.data(), static_cast<std::streamsize>(contents.size()));
+}
+
+} // namespace xafile::test
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition))                                                          \
+      ::xafile::test::fail(__FILE__, __LINE__, #condition);                    \
+  } while (0)
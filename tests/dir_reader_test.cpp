@@ -0,0 +1,166 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/dir_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+std::map<std::string, DirEntry> read_all(DirReader &reader) {
+  std::map<std::string, DirEntry> found;
+  std::vector<DirEntry> entries;
+  while (reader.read(entries))
+    for (const auto &e : entries)
+      found.emplace(std::string(e.name), e);
+  return found;
+}
+
+void classifies_entries() {
+  test::TempDir dir;
+  mkdir((dir / "folder").c_str(), 0755);
+  test::write_file(dir / "file", "x");
+  symlink("folder", (dir / "folder-link").c_str());
+  symlink("file", (dir / "file-link").c_str());
+  symlink("missing", (dir / "dangling").c_str());
+  mkfifo((dir / "fifo").c_str(), 0600);
+
+  DirReader reader(dir.path().c_str());
+  CHECK(reader.is_open());
+  auto found = read_all(reader);
+  CHECK(reader.error() == 0);
+  CHECK(found.size() == 6);
+  CHECK(!found.contains(".") && !found.contains(".."));
+
+  CHECK(found["folder"].kind == EntryKind::Directory);
+  CHECK(!found["folder"].is_symlink);
+  CHECK(found["file"].kind == EntryKind::Regular);
+  CHECK(!found["file"].is_symlink);
+  CHECK(found["folder-link"].kind == EntryKind::Directory);
+  CHECK(found["folder-link"].is_symlink);
+  CHECK(found["file-link"].kind == EntryKind::Regular);
+  CHECK(found["file-link"].is_symlink);
+  CHECK(found["dangling"].kind == EntryKind::Other);
+  CHECK(found["dangling"].is_symlink);
+  CHECK(found["fifo"].kind == EntryKind::Other);
+
+  struct stat st;
+  stat((dir / "file").c_str(), &st);
+  CHECK(found["file"].inode == st.st_ino);
+}
+
+// More names than one getdents64 buffer holds
+void reads_every_chunk() {
+  test::TempDir dir;
+  constexpr int kCount = 5000;
+  std::string padding(100, 'n');
+  for (int i = 0; i < kCount; i++)
+    test::write_file(dir / (padding + std::to_string(i)), "");
+
+  DirReader reader(dir.path().c_str());
+  std::size_t chunks = 0, total = 0;
+  std::vector<std::string> names;
+  std::vector<DirEntry> entries;
+  while (reader.read(entries)) {
+    chunks++;
+    total += entries.size();
+    for (const auto &e : entries)
+      names.emplace_back(e.name);
+  }
+  CHECK(reader.error() == 0);
+  CHECK(chunks > 1);
+  CHECK(total == kCount);
+  std::sort(names.begin(), names.end());
+  CHECK(std::adjacent_find(names.begin(), names.end()) == names.end());
+}
+
+void reports_errors() {
+  test::TempDir dir;
+  DirReader missing((dir / "missing").c_str());
+  CHECK(!missing.is_open());
+  CHECK(missing.error() == ENOENT);
+  std::vector<DirEntry> entries;
+  CHECK(!missing.read(entries));
+
+  test::write_file(dir / "file", "");
+  DirReader file((dir / "file").c_str());
+  CHECK(!file.is_open());
+  CHECK(file.error() == ENOTDIR);
+}
+
+void opens_relative_to_a_directory() {
+  test::TempDir dir;
+  mkdir((dir / "inner").c_str(), 0755);
+  test::write_file(dir / "inner/a", "");
+  symlink("inner", (dir / "link").c_str());
+
+  int dir_fd = open(dir.path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  DirReader inner(dir_fd, "inner");
+  CHECK(inner.is_open());
+  CHECK(read_all(inner).contains("a"));
+  // A final symlink is not followed
+  DirReader link(dir_fd, "link");
+  CHECK(!link.is_open());
+  close(dir_fd);
+
+  DirReader released(dir.path().c_str());
+  int fd = released.release_fd();
+  CHECK(fd >= 0);
+  CHECK(!released.is_open());
+  close(fd);
+}
+
+void reads_hidden_names() {
+  test::TempDir dir;
+  int dir_fd = open(dir.path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  CHECK(HiddenNames::read(dir_fd).empty());
+
+  test::write_file(dir / ".hidden", "zeta\nalpha\n\nmid dle\n");
+  auto hidden = HiddenNames::read(dir_fd);
+  CHECK(!hidden.empty());
+  CHECK(hidden.contains("alpha"));
+  CHECK(hidden.contains("zeta"));
+  CHECK(hidden.contains("mid dle"));
+  CHECK(!hidden.contains("alp"));
+  CHECK(!hidden.contains(""));
+  close(dir_fd);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  classifies_entries();
+  reads_every_chunk();
+  reports_errors();
+  opens_relative_to_a_directory();
+  reads_hidden_names();
+  return test::result();
+}
@@ -0,0 +1,168 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/file_copy.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace xafile {
+
+namespace {
+
+constexpr off_t kMiB = 1 << 20;
+
+std::string read_file(const std::string &path) {
+  std::string contents;
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  char buffer[65536];
+  ssize_t n;
+  while (fd >= 0 && (n = read(fd, buffer, sizeof(buffer))) > 0)
+    contents.append(buffer, n);
+  if (fd >= 0)
+    close(fd);
+  return contents;
+}
+
+struct Copied {
+  CopyResult result;
+  std::uint64_t progress = 0;
+};
+
+Copied copy(const std::string &from, const std::string &to,
+            bool cancel = false) {
+  struct stat st;
+  lstat(from.c_str(), &st);
+  std::atomic<bool> cancelled{cancel};
+  Copied copied;
+  copied.result = copy_regular_file(
+      from.c_str(), to.c_str(), st, cancelled,
+      [&copied](std::uint64_t bytes) { copied.progress += bytes; });
+  return copied;
+}
+
+// Data, a hole, more data and a trailing hole
+void copies_sparse_files() {
+  test::TempDir dir;
+  auto from = dir / "sparse";
+  int fd = open(from.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0640);
+  std::string head(64 * 1024, 'h'), middle(64 * 1024, 'm');
+  CHECK(pwrite(fd, head.data(), head.size(), 0) == off_t(head.size()));
+  CHECK(pwrite(fd, middle.data(), middle.size(), 8 * kMiB) ==
+        off_t(middle.size()));
+  CHECK(ftruncate(fd, 16 * kMiB) == 0);
+  struct timespec times[2] = {{1000, 0}, {2000, 500}};
+  futimens(fd, times);
+  close(fd);
+
+  auto to = dir / "copy";
+  auto copied = copy(from, to);
+  CHECK(copied.result.error == 0);
+  CHECK(copied.progress == std::uint64_t(16 * kMiB));
+  CHECK(read_file(to) == read_file(from));
+
+  struct stat in, out;
+  stat(from.c_str(), &in);
+  stat(to.c_str(), &out);
+  CHECK(out.st_size == 16 * kMiB);
+  CHECK((out.st_mode & 07777) == 0640);
+  CHECK(out.st_mtim.tv_sec == 2000 && out.st_mtim.tv_nsec == 500);
+  // Where the filesystem keeps holes, the copy keeps them too
+  if (in.st_blocks * 512 < 4 * kMiB)
+    CHECK(out.st_blocks * 512 < 4 * kMiB);
+}
+
+void copies_plain_and_empty_files() {
+  test::TempDir dir;
+  std::string data;
+  for (int i = 0; i < 300000; i++)
+    data += char('a' + i % 26);
+  test::write_file(dir / "plain", data);
+  auto copied = copy(dir / "plain", dir / "plain-copy");
+  CHECK(copied.result.error == 0);
+  CHECK(copied.progress == data.size());
+  CHECK(read_file(dir / "plain-copy") == data);
+
+  test::write_file(dir / "empty", "");
+  copied = copy(dir / "empty", dir / "empty-copy");
+  CHECK(copied.result.error == 0);
+  CHECK(access((dir / "empty-copy").c_str(), F_OK) == 0);
+  CHECK(read_file(dir / "empty-copy").empty());
+}
+
+void reports_errors() {
+  test::TempDir dir;
+  test::write_file(dir / "file", "new");
+  test::write_file(dir / "existing", "old");
+  auto copied = copy(dir / "file", dir / "existing");
+  CHECK(copied.result.error == EEXIST);
+  CHECK(read_file(dir / "existing") == "old");
+
+  struct stat st{};
+  std::atomic<bool> cancelled{false};
+  auto result = copy_regular_file((dir / "missing").c_str(),
+                                  (dir / "to").c_str(), st, cancelled, {});
+  CHECK(result.error == ENOENT);
+  CHECK(access((dir / "to").c_str(), F_OK) != 0);
+}
+
+// A cancelled copy leaves nothing behind. A reflink is done in one step,
+// so it finishes regardless.
+void removes_cancelled_copies() {
+  test::TempDir dir;
+  test::write_file(dir / "file", std::string(1 << 20, 'c'));
+  auto copied = copy(dir / "file", dir / "copy", true);
+  if (copied.result.error != 0) {
+    CHECK(copied.result.error == ECANCELED);
+    CHECK(access((dir / "copy").c_str(), F_OK) != 0);
+  } else {
+    CHECK(copied.result.method == CopyMethod::Reflink);
+  }
+}
+
+void copies_symlinks() {
+  test::TempDir dir;
+  symlink("../some/where", (dir / "link").c_str());
+  CHECK(copy_symlink((dir / "link").c_str(), (dir / "copy").c_str()) == 0);
+  char target[PATH_MAX];
+  auto n = readlink((dir / "copy").c_str(), target, sizeof(target));
+  CHECK(std::string(target, n > 0 ? n : 0) == "../some/where");
+  CHECK(copy_symlink((dir / "link").c_str(), (dir / "copy").c_str()) ==
+        EEXIST);
+  CHECK(copy_symlink((dir / "missing").c_str(), (dir / "other").c_str()) ==
+        ENOENT);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  copies_sparse_files();
+  copies_plain_and_empty_files();
+  reports_errors();
+  removes_cancelled_copies();
+  copies_symlinks();
+  return test::result();
+}
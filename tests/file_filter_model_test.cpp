@@ -0,0 +1,198 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "file_filter_model.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+using Names = std::vector<std::string>;
+
+struct Change {
+  guint position, removed, added;
+  bool operator==(const Change &) const = default;
+};
+using Changes = std::vector<Change>;
+
+Names names_of(GListModel *model) {
+  Names names;
+  auto n = g_list_model_get_n_items(model);
+  for (guint i = 0; i < n; i++) {
+    auto *item = FILE_ITEM(g_list_model_get_item(model, i));
+    names.emplace_back(file_item_get_name(item));
+    g_object_unref(item);
+  }
+  return names;
+}
+
+// Records every items-changed and replays it on a copy of the rows, which
+// only ends up equal to the model if the ranges were right at every step
+struct Recorder {
+  GListModel *model;
+  Names rows;
+  Changes changes;
+
+  explicit Recorder(FileFilterModel *filter)
+      : model(G_LIST_MODEL(filter)), rows(names_of(model)) {
+    g_signal_connect(filter, "items-changed", G_CALLBACK(on_items_changed),
+                     this);
+  }
+
+  static void on_items_changed(GListModel *model, guint position,
+                               guint removed, guint added,
+                               gpointer user_data) {
+    auto *self = static_cast<Recorder *>(user_data);
+    self->changes.push_back({position, removed, added});
+    auto at = self->rows.begin() + position;
+    at = self->rows.erase(at, at + removed);
+    for (guint i = 0; i < added; i++) {
+      auto *item = FILE_ITEM(g_list_model_get_item(model, position + i));
+      at = self->rows.insert(at, file_item_get_name(item)) + 1;
+      g_object_unref(item);
+    }
+  }
+};
+
+// Rows in the given order; names starting with "h" are flagged hidden
+FileListModel *make_source(const Names &names) {
+  auto listing = std::make_shared<Listing>();
+  std::vector<std::uint32_t> order;
+  for (const auto &name : names) {
+    auto index = listing->add(name, false);
+    (*listing)[index].is_hidden = name.starts_with('h');
+    order.push_back(index);
+  }
+  auto *source = file_list_model_new();
+  file_list_model_set_listing(source, std::move(listing), std::move(order));
+  return source;
+}
+
+// Hidden rows at the start, in the middle and at the end
+const Names kRows{"h0", "h1", "s2", "s3", "h4", "s5", "s6", "h7", "h8"};
+const Names kShown{"s2", "s3", "s5", "s6"};
+
+void leaves_hidden_rows_out() {
+  auto *source = make_source(kRows);
+  auto *filter = file_filter_model_new(source);
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 4);
+  CHECK(names_of(G_LIST_MODEL(filter)) == kShown);
+  CHECK(!g_list_model_get_item(G_LIST_MODEL(filter), 4));
+  g_object_unref(filter);
+  g_object_unref(source);
+}
+
+void shows_and_hides_one_run_at_a_time() {
+  auto *source = make_source(kRows);
+  auto *filter = file_filter_model_new(source);
+  Recorder recorder(filter);
+
+  // The last run first, so the rows before each change are where they were
+  file_filter_model_set_show_hidden(filter, true);
+  CHECK(recorder.changes == (Changes{{4, 0, 2}, {2, 0, 1}, {0, 0, 2}}));
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 9);
+  CHECK(names_of(G_LIST_MODEL(filter)) == kRows);
+  CHECK(recorder.rows == kRows);
+
+  recorder.changes.clear();
+  file_filter_model_set_show_hidden(filter, false);
+  CHECK(recorder.changes == (Changes{{0, 2, 0}, {2, 1, 0}, {4, 2, 0}}));
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 4);
+  CHECK(names_of(G_LIST_MODEL(filter)) == kShown);
+  CHECK(recorder.rows == kShown);
+
+  // Setting it to what it is changes nothing
+  recorder.changes.clear();
+  file_filter_model_set_show_hidden(filter, false);
+  CHECK(recorder.changes.empty());
+  g_object_unref(filter);
+  g_object_unref(source);
+}
+
+void keeps_hidden_rows_out_of_source_changes() {
+  auto *source = make_source(kRows);
+  auto *filter = file_filter_model_new(source);
+  Recorder recorder(filter);
+
+  // Entries added later are hidden for being dotfiles
+  file_list_model_sort(source);
+  recorder.rows = names_of(G_LIST_MODEL(filter));
+  file_list_model_apply(source, {{".h45", true, false, 0, 0, {}},
+                                 {"s45", true, false, 0, 0, {}}});
+  auto shown = names_of(G_LIST_MODEL(filter));
+  CHECK(shown.size() == 5);
+  CHECK(std::find(shown.begin(), shown.end(), "s45") != shown.end());
+  CHECK(recorder.rows == shown);
+
+  file_filter_model_set_show_hidden(filter, true);
+  CHECK(names_of(G_LIST_MODEL(filter)) == names_of(G_LIST_MODEL(source)));
+  CHECK(recorder.rows == names_of(G_LIST_MODEL(source)));
+  g_object_unref(filter);
+  g_object_unref(source);
+}
+
+void shows_hidden_matches_with_a_query() {
+  auto *source = make_source(kRows);
+  auto *filter = file_filter_model_new(source);
+  Recorder recorder(filter);
+
+  file_filter_model_set_query(filter, "s");
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 4);
+  CHECK(recorder.changes == (Changes{{0, 4, 4}}));
+
+  // Matches are ranked, so only which rows are shown is compared
+  recorder.changes.clear();
+  file_filter_model_set_query(filter, "");
+  file_filter_model_set_query(filter, "h");
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 0);
+  file_filter_model_set_show_hidden(filter, true);
+  auto matched = names_of(G_LIST_MODEL(filter));
+  std::sort(matched.begin(), matched.end());
+  CHECK(matched == (Names{"h0", "h1", "h4", "h7", "h8"}));
+  CHECK(recorder.changes.back() == (Change{0, 0, 5}));
+
+  file_filter_model_set_show_hidden(filter, false);
+  CHECK(g_list_model_get_n_items(G_LIST_MODEL(filter)) == 0);
+  CHECK(recorder.changes.back() == (Change{0, 5, 0}));
+
+  // Back to every row, with the hidden ones left out
+  file_filter_model_set_query(filter, "");
+  CHECK(recorder.changes.back() == (Change{0, 0, 4}));
+  CHECK(names_of(G_LIST_MODEL(filter)) == kShown);
+  CHECK(recorder.rows == kShown);
+  g_object_unref(filter);
+  g_object_unref(source);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  leaves_hidden_rows_out();
+  shows_and_hides_one_run_at_a_time();
+  keeps_hidden_rows_out_of_source_changes();
+  shows_hidden_matches_with_a_query();
+  return test::result();
+}
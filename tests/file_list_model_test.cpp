@@ -0,0 +1,256 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "file_list_model.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+using Names = std::vector<std::string>;
+
+struct Change {
+  guint position, removed, added;
+  bool operator==(const Change &) const = default;
+};
+using Changes = std::vector<Change>;
+
+// Records every items-changed and replays it on a copy of the rows, which
+// only ends up equal to the model if the ranges were right
+struct Recorder {
+  FileListModel *model;
+  Names rows;
+  Changes changes;
+
+  explicit Recorder(FileListModel *model) : model(model), rows(names()) {
+    g_signal_connect(model, "items-changed", G_CALLBACK(on_items_changed),
+                     this);
+  }
+
+  Names names() const {
+    Names names;
+    auto n = g_list_model_get_n_items(G_LIST_MODEL(model));
+    for (guint i = 0; i < n; i++)
+      names.push_back(name_at(i));
+    return names;
+  }
+
+  std::string name_at(guint position) const {
+    auto *item =
+        FILE_ITEM(g_list_model_get_item(G_LIST_MODEL(model), position));
+    std::string name = file_item_get_name(item);
+    g_object_unref(item);
+    return name;
+  }
+
+  static void on_items_changed(GListModel *, guint position, guint removed,
+                               guint added, gpointer user_data) {
+    auto *self = static_cast<Recorder *>(user_data);
+    self->changes.push_back({position, removed, added});
+    auto at = self->rows.begin() + position;
+    at = self->rows.erase(at, at + removed);
+    for (guint i = 0; i < added; i++)
+      at = self->rows.insert(at, self->name_at(position + i)) + 1;
+  }
+};
+
+EntryUpdate file(std::string name, std::uint64_t size = 0) {
+  return {std::move(name), true, false, size, 0,
+          {atoms::kNone, atoms::kNone, atoms::kNone}};
+}
+
+EntryUpdate directory(std::string name) {
+  return {std::move(name), true, true, 0, 0,
+          {atoms::kNone, atoms::kNone, atoms::kNone}};
+}
+
+EntryUpdate gone(std::string name) {
+  return {std::move(name), false, false, 0, 0,
+          {atoms::kNone, atoms::kNone, atoms::kNone}};
+}
+
+// A sorted model of files with the given names and sizes
+FileListModel *make_model(const Names &names, SortOrder sort = {}) {
+  auto listing = std::make_shared<Listing>();
+  std::vector<std::uint32_t> order;
+  for (std::size_t i = 0; i < names.size(); i++) {
+    auto index = listing->add(names[i], false);
+    auto &e = (*listing)[index];
+    e.size = i;
+    e.has_metadata = true;
+    order.push_back(index);
+  }
+  auto *model = file_list_model_new();
+  file_list_model_set_listing(model, std::move(listing), std::move(order));
+  file_list_model_set_sort(model, sort);
+  return model;
+}
+
+Names numbered(std::string_view prefix, int count) {
+  Names names;
+  for (int i = 0; i < count; i++)
+    names.push_back(std::string(prefix) + (i < 10 ? "0" : "") +
+                    std::to_string(i));
+  return names;
+}
+
+void adds_and_removes_rows_one_at_a_time() {
+  auto *model = make_model({"a", "c", "e"});
+  Recorder recorder(model);
+  file_list_model_apply(model, {file("b"), file("d"), gone("e")});
+  CHECK(recorder.names() == (Names{"a", "b", "c", "d"}));
+  CHECK(recorder.rows == recorder.names());
+  // Removals bottom up first, then each insertion where it sorts
+  CHECK(recorder.changes == (Changes{{2, 1, 0}, {1, 0, 1}, {3, 0, 1}}));
+  g_object_unref(model);
+}
+
+void moves_retyped_entries() {
+  auto *model = make_model({"a", "b", "c"});
+  Recorder recorder(model);
+  // Directories sort first
+  file_list_model_apply(model, {directory("c")});
+  CHECK(recorder.names() == (Names{"c", "a", "b"}));
+  CHECK(recorder.rows == recorder.names());
+  CHECK(recorder.changes == (Changes{{2, 1, 0}, {0, 0, 1}}));
+
+  auto *item = FILE_ITEM(g_list_model_get_item(G_LIST_MODEL(model), 0));
+  CHECK(file_item_is_directory(item));
+  g_object_unref(item);
+  g_object_unref(model);
+}
+
+void moves_rows_whose_sort_key_changed() {
+  // Sizes 0, 1, 2, 3
+  auto *model = make_model({"a", "b", "c", "d"}, {SortField::Size, false});
+  Recorder recorder(model);
+  file_list_model_apply(model, {file("a", 10), file("c", 2)});
+  CHECK(recorder.names() == (Names{"b", "c", "d", "a"}));
+  CHECK(recorder.rows == recorder.names());
+  // "c" keeps its size and only its item is refreshed
+  CHECK(recorder.changes == (Changes{{0, 1, 0}, {3, 0, 1}}));
+  g_object_unref(model);
+}
+
+void merges_bursts_into_one_change() {
+  auto names = numbered("a", 10);
+  auto tail = numbered("z", 10);
+  names.insert(names.end(), tail.begin(), tail.end());
+
+  // Up to 32 changes are reported one by one
+  {
+    auto *model = make_model(names);
+    Recorder recorder(model);
+    std::vector<EntryUpdate> updates;
+    for (const auto &name : numbered("m", 32))
+      updates.push_back(file(name));
+    file_list_model_apply(model, updates);
+    CHECK(recorder.changes.size() == 32);
+    CHECK(recorder.rows == recorder.names());
+    g_object_unref(model);
+  }
+
+  // One more and they are merged; the unchanged rows before and after are
+  // left out of the range
+  {
+    auto *model = make_model(names);
+    Recorder recorder(model);
+    std::vector<EntryUpdate> updates;
+    for (const auto &name : numbered("m", 33))
+      updates.push_back(file(name));
+    file_list_model_apply(model, updates);
+    CHECK(recorder.changes == (Changes{{10, 0, 33}}));
+    CHECK(recorder.rows == recorder.names());
+    CHECK(recorder.names().size() == 53);
+    g_object_unref(model);
+  }
+
+  {
+    auto *model = make_model(names);
+    Recorder recorder(model);
+    std::vector<EntryUpdate> updates{gone("a05"), gone("z09")};
+    for (const auto &name : numbered("m", 40))
+      updates.push_back(file(name));
+    file_list_model_apply(model, updates);
+    // From a05 to z09, nothing is the same
+    CHECK(recorder.changes == (Changes{{5, 15, 53}}));
+    CHECK(recorder.rows == recorder.names());
+    auto shown = recorder.names();
+    CHECK(shown.size() == 58);
+    CHECK(shown[4] == "a04" && shown[5] == "a06" && shown[9] == "m00" &&
+          shown.back() == "z08");
+    g_object_unref(model);
+  }
+}
+
+void drops_dead_entries() {
+  auto *model = make_model(numbered("f", 10));
+  Recorder recorder(model);
+  std::vector<EntryUpdate> updates;
+  for (const auto &name : numbered("f", 6))
+    updates.push_back(gone(name));
+  // Only entries already dead count, these are still shown
+  CHECK(!file_list_model_apply(model, updates));
+  CHECK(file_list_model_get_listing(model).size() == 10);
+
+  auto *kept = FILE_ITEM(g_list_model_get_item(G_LIST_MODEL(model), 3));
+  CHECK(file_list_model_apply(model, {gone("f06")}));
+  CHECK(file_list_model_get_listing(model).size() == 4);
+  CHECK(recorder.names() == (Names{"f07", "f08", "f09"}));
+  CHECK(recorder.rows == recorder.names());
+  // Items already handed out follow their entry
+  CHECK(std::string_view(file_item_get_name(kept)) == "f09");
+  auto *again = FILE_ITEM(g_list_model_get_item(G_LIST_MODEL(model), 2));
+  CHECK(again == kept);
+  g_object_unref(again);
+  g_object_unref(kept);
+  g_object_unref(model);
+}
+
+void leaves_shared_listings_alone() {
+  auto *model = make_model({"a", "b"});
+  auto shared = file_list_model_share_listing(model);
+  file_list_model_apply(model, {file("a", 7), file("c")});
+  file_list_model_update_metadata(model, {{1, 9, 0, {}}});
+  CHECK(shared->size() == 2);
+  CHECK((*shared)[0].size == 0 && (*shared)[1].size == 1);
+  const auto &listing = file_list_model_get_listing(model);
+  CHECK(listing.size() == 3);
+  CHECK(listing[0].size == 7 && listing[1].size == 9);
+  g_object_unref(model);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  adds_and_removes_rows_one_at_a_time();
+  moves_retyped_entries();
+  moves_rows_whose_sort_key_changed();
+  merges_bursts_into_one_change();
+  drops_dead_entries();
+  leaves_shared_listings_alone();
+  return test::result();
+}
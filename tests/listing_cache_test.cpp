@@ -0,0 +1,148 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/listing_cache.hpp"
+
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+CachedListing make_listing(int entries) {
+  auto listing = std::make_shared<Listing>();
+  std::vector<std::uint32_t> order;
+  for (int i = 0; i < entries; i++)
+    order.push_back(listing->add("entry" + std::to_string(i), false));
+  return {std::move(listing), std::move(order), {}};
+}
+
+DirStamp stamp(std::uint64_t inode) { return {1, inode, 0, 0, 0, 0}; }
+
+void stamps_directories() {
+  test::TempDir dir;
+  // Back in time, so the next change shows up however coarse the clock
+  struct timespec past[2] = {{1000, 0}, {1000, 0}};
+  utimensat(AT_FDCWD, dir.path().c_str(), past, 0);
+  auto before = DirStamp::of(dir.path());
+  CHECK(before.has_value());
+  CHECK(DirStamp::of(dir.path()) == before);
+
+  test::write_file(dir / "new", "");
+  auto after = DirStamp::of(dir.path());
+  CHECK(after.has_value() && after != before);
+
+  CHECK(!DirStamp::of(dir / "new"));
+  CHECK(!DirStamp::of(dir / "missing"));
+}
+
+void looks_up_by_stamp() {
+  ListingCache cache(1 << 20);
+  CHECK(!cache.lookup("/a", stamp(1)));
+
+  auto contents = make_listing(3);
+  auto *listing = contents.listing.get();
+  contents.sort = {SortField::Size, true};
+  cache.store("/a", stamp(1), std::move(contents));
+  auto hit = cache.lookup("/a", stamp(1));
+  CHECK(hit.has_value());
+  // Shared, not copied
+  CHECK(hit && hit->listing.get() == listing);
+  CHECK(hit && hit->order.size() == 3);
+  CHECK(hit && hit->sort == (SortOrder{SortField::Size, true}));
+
+  // A changed directory drops what was cached for it
+  CHECK(!cache.lookup("/a", stamp(2)));
+  CHECK(!cache.lookup("/a", stamp(1)));
+
+  auto stats = cache.stats();
+  CHECK(stats.hits == 1);
+  CHECK(stats.misses == 3);
+  CHECK(stats.entries == 0);
+  CHECK(stats.bytes == 0);
+}
+
+void evicts_least_recently_used() {
+  ListingCache cache(1 << 20);
+  cache.store("/probe", stamp(1), make_listing(100));
+  auto size = cache.stats().bytes;
+  cache.erase("/probe");
+  CHECK(cache.stats().bytes == 0 && cache.stats().entries == 0);
+
+  // Room for two
+  cache.set_budget(size * 2 + size / 2);
+  cache.store("/a", stamp(1), make_listing(100));
+  cache.store("/b", stamp(1), make_listing(100));
+  CHECK(cache.lookup("/a", stamp(1)));
+  cache.store("/c", stamp(1), make_listing(100));
+  CHECK(cache.lookup("/a", stamp(1)));
+  CHECK(!cache.lookup("/b", stamp(1)));
+  CHECK(cache.lookup("/c", stamp(1)));
+  CHECK(cache.stats().evictions == 1);
+  CHECK(cache.stats().entries == 2);
+
+  // Storing a path again replaces it
+  cache.store("/a", stamp(2), make_listing(100));
+  CHECK(cache.stats().entries == 2);
+  CHECK(cache.stats().bytes <= cache.stats().budget);
+  CHECK(cache.lookup("/a", stamp(2)));
+
+  cache.set_budget(0);
+  CHECK(cache.stats().entries == 0);
+  CHECK(cache.stats().bytes == 0);
+}
+
+// Windows share the cache, each from its own thread here
+void shares_across_threads() {
+  ListingCache cache(1 << 20);
+  {
+    std::vector<std::jthread> threads;
+    for (int t = 0; t < 4; t++)
+      threads.emplace_back([&cache, t] {
+        for (int i = 0; i < 500; i++) {
+          auto path = "/dir" + std::to_string((t * 7 + i) % 20);
+          if (!cache.lookup(path, stamp(1)))
+            cache.store(path, stamp(1), make_listing(10));
+          if (i % 50 == 0)
+            cache.erase(path);
+        }
+      });
+  }
+  auto stats = cache.stats();
+  CHECK(stats.hits + stats.misses == 2000);
+  CHECK(stats.entries <= 20);
+  CHECK(stats.bytes <= stats.budget);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  stamps_directories();
+  looks_up_by_stamp();
+  evicts_least_recently_used();
+  shares_across_threads();
+  return test::result();
+}
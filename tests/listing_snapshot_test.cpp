@@ -0,0 +1,182 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/listing_snapshot.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+// ListingSnapshot reads its file once per process, so every step runs in
+// a child of its own. Returns the child's failed checks.
+int in_child(const std::function<void()> &step) {
+  std::fflush(nullptr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    step();
+    std::fflush(nullptr);
+    _exit(test::failures);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+void run(const std::function<void()> &step) {
+  test::failures += in_child(step);
+}
+
+const DirStamp kStamp{1, 2, 3, 4, 5, 6};
+
+// Rows "a" to "e", with "d" removed and the rest shown newest first
+void save_listing() {
+  auto listing = std::make_shared<Listing>();
+  for (auto name : {"a", "b", "c", "d"})
+    listing->add(name, false);
+  listing->add("e", true);
+  auto &b = (*listing)[1];
+  b.size = 4096;
+  b.mtime = 1700000000;
+  b.has_metadata = true;
+  b.type = atom_intern("Snapshot test type");
+  b.content_type = atom_intern("application/x-snapshot-test");
+
+  ListingSnapshot::instance().remember(
+      "/first", kStamp,
+      {listing, {4, 2, 1, 0}, {SortField::Modified, true}});
+  ListingSnapshot::instance().remember("/second", kStamp,
+                                       {listing, {0}, {}});
+  ListingSnapshot::instance().write();
+}
+
+void reads_back_what_was_saved() {
+  run(save_listing);
+  run([] {
+    // Atoms are numbered differently in another run
+    atom_intern("Interned first in this run");
+    auto saved = ListingSnapshot::instance().take("/first");
+    CHECK(saved.has_value());
+    if (!saved)
+      return;
+    CHECK(saved->stamp == kStamp);
+    CHECK(saved->contents.sort == (SortOrder{SortField::Modified, true}));
+    const auto &listing = *saved->contents.listing;
+    CHECK(listing.size() == 4);
+    CHECK(saved->contents.order == (std::vector<std::uint32_t>{0, 1, 2, 3}));
+    std::string names;
+    for (std::size_t i = 0; i < listing.size(); i++)
+      names += listing.name(listing[i]);
+    CHECK(names == "ecba");
+    CHECK(listing[0].is_directory);
+    CHECK(listing.key(listing[0]) == Listing::collation_key("e"));
+
+    const auto &b = listing[2];
+    CHECK(b.has_metadata && b.size == 4096 && b.mtime == 1700000000);
+    CHECK(std::strcmp(atom_string(b.type), "Snapshot test type") == 0);
+    CHECK(std::strcmp(atom_string(b.content_type),
+                      "application/x-snapshot-test") == 0);
+    CHECK(listing[0].content_type == atoms::kNone);
+    CHECK(listing[0].icon == atoms::kFolderIcon);
+
+    // Handed out once
+    CHECK(!ListingSnapshot::instance().take("/first"));
+    CHECK(ListingSnapshot::instance().take("/second"));
+    CHECK(!ListingSnapshot::instance().take("/missing"));
+  });
+}
+
+void ignores_damaged_files(const std::string &file) {
+  std::string good;
+  {
+    int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    char buffer[4096];
+    ssize_t n;
+    while (fd >= 0 && (n = read(fd, buffer, sizeof(buffer))) > 0)
+      good.append(buffer, n);
+    if (fd >= 0)
+      close(fd);
+  }
+  CHECK(good.size() > 64);
+
+  auto patched = [&good](std::size_t at, std::string_view bytes) {
+    auto copy = good;
+    copy.replace(at, bytes.size(), bytes);
+    return copy;
+  };
+  std::vector<std::string> damaged{
+      "",
+      good.substr(0, good.size() / 2),
+      good + "trailing",
+      patched(0, "NOTXAFIL"),
+      patched(8, std::string("\x7f\0\0\0", 4)),  // version
+      patched(12, std::string("\xff\xff\0\0", 4)), // directory count
+      std::string(good.size(), '\xa5'),
+  };
+  for (const auto &contents : damaged) {
+    test::write_file(file, contents);
+    run([] {
+      CHECK(!ListingSnapshot::instance().take("/first"));
+      CHECK(!ListingSnapshot::instance().take("/second"));
+    });
+  }
+  test::write_file(file, good);
+}
+
+void can_be_turned_off(const std::string &file) {
+  setenv("XAFILE_LISTING_SNAPSHOT", "0", 1);
+  run([] { CHECK(!ListingSnapshot::instance().take("/first")); });
+  run([] {
+    ListingSnapshot::instance().remember(
+        "/other", kStamp, {std::make_shared<Listing>(), {}, {}});
+    ListingSnapshot::instance().write();
+  });
+  unsetenv("XAFILE_LISTING_SNAPSHOT");
+  // Not written over
+  run([] {
+    CHECK(ListingSnapshot::instance().take("/first"));
+    CHECK(!ListingSnapshot::instance().take("/other"));
+  });
+  CHECK(access(file.c_str(), F_OK) == 0);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  test::TempDir cache;
+  setenv("XDG_CACHE_HOME", cache.path().c_str(), 1);
+  unsetenv("XAFILE_LISTING_SNAPSHOT");
+
+  reads_back_what_was_saved();
+  auto file = cache / "xafile/listings";
+  ignores_damaged_files(file);
+  can_be_turned_off(file);
+  return test::result();
+}
@@ -0,0 +1,153 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/name_filter.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+struct Names {
+  Listing listing;
+  std::vector<std::uint32_t> order;
+  FoldedNames folded;
+
+  explicit Names(const std::vector<std::string> &names) {
+    for (const auto &name : names)
+      order.push_back(listing.add(name, false));
+    folded = FoldedNames(listing, order);
+  }
+
+  std::vector<std::string> ranked(std::string_view query) const {
+    std::vector<std::string> out;
+    for (auto row : NameFilter(query).rank(folded))
+      out.emplace_back(listing.name(listing[order[row]]));
+    return out;
+  }
+};
+
+using Strings = std::vector<std::string>;
+
+void folds_names() {
+  Names names({"README.md", "Ünïcode", "a"});
+  CHECK(names.folded.size() == 3);
+  CHECK(names.folded[0] == "readme.md");
+  // Only ASCII is folded
+  CHECK(names.folded[1] == "Ünïcode");
+  CHECK(names.folded[2] == "a");
+  CHECK(names.folded.offsets().back() == 9 + 9 + 1);
+}
+
+void scores_matches() {
+  Names names({"report.txt", "my-report.txt", "preport.txt",
+               "r_e_p_o_r_t.txt", "xyz"});
+  NameFilter filter("REPORT");
+  CHECK(filter.query() == "report");
+  auto score = [&](std::size_t row) { return filter.score(names.folded[row]); };
+  CHECK(!score(4));
+  CHECK(score(0) && score(1) && score(2) && score(3));
+  // Prefix, then at a word start, then anywhere, then scattered
+  CHECK(*score(0) > *score(1));
+  CHECK(*score(1) > *score(2));
+  CHECK(*score(2) > *score(3));
+
+  CHECK(NameFilter("").empty());
+  CHECK(NameFilter("").score("anything") == 0);
+  CHECK(!NameFilter("tx.").score(names.folded[0]));
+}
+
+void ranks_best_first() {
+  Names names({"notes-old.txt", "notes.txt", "my notes.txt", "n-o-t-e-s",
+               "other"});
+  CHECK(names.ranked("notes") ==
+        (Strings{"notes.txt", "notes-old.txt", "my notes.txt", "n-o-t-e-s"}));
+  // Equal scores keep row order
+  Names same({"bb", "ab", "cb"});
+  CHECK(same.ranked("b") == (Strings{"bb", "ab", "cb"}));
+  CHECK(same.ranked("") == (Strings{"bb", "ab", "cb"}));
+  CHECK(same.ranked("q").empty());
+}
+
+void ranks_only_given_rows() {
+  Names names({"alpha", "beta", "alphabet", "gamma"});
+  std::vector<std::uint32_t> rows{1, 2, 3};
+  auto ranked = NameFilter("alp").rank(names.folded, &rows);
+  CHECK(ranked == (std::vector<std::uint32_t>{2}));
+  CHECK(NameFilter("").rank(names.folded, &rows) == rows);
+}
+
+// Characters of the query spread over neighbouring names must not match,
+// and names longer than a 16 byte block are searched to the end
+void stays_within_names() {
+  Names names({"abc", "xyz", std::string(40, 'k') + "target"});
+  CHECK(names.ranked("cx").empty());
+  CHECK(names.ranked("ktarget").size() == 1);
+  CHECK(names.ranked("tt").size() == 1);
+  CHECK(names.ranked("targetk").empty());
+}
+
+// Enough rows to be filtered on several threads, checked against scoring
+// every name on its own
+void ranks_large_listings() {
+  std::mt19937 rng(15);
+  std::vector<std::string> list;
+  const char letters[] = "abcdefgh_-. ";
+  for (int i = 0; i < 100000; i++) {
+    std::string name;
+    auto length = 3 + rng() % 30;
+    for (std::size_t j = 0; j < length; j++)
+      name.push_back(letters[rng() % (sizeof(letters) - 1)]);
+    list.push_back(std::move(name));
+  }
+  Names names(list);
+
+  for (auto query : {"abc", "h.a", "g"}) {
+    NameFilter filter(query);
+    std::vector<std::pair<std::int32_t, std::uint32_t>> expected;
+    for (std::uint32_t row = 0; row < names.folded.size(); row++)
+      if (auto s = filter.score(names.folded[row]))
+        expected.emplace_back(-*s, row);
+    std::sort(expected.begin(), expected.end());
+    std::vector<std::uint32_t> rows;
+    for (const auto &hit : expected)
+      rows.push_back(hit.second);
+    CHECK(filter.rank(names.folded) == rows);
+  }
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  folds_names();
+  scores_matches();
+  ranks_best_first();
+  ranks_only_given_rows();
+  stays_within_names();
+  ranks_large_listings();
+  return test::result();
+}
@@ -0,0 +1,168 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/sort_order.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+struct Row {
+  std::string_view name;
+  bool is_directory = false;
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0;
+  const char *type = nullptr;
+};
+
+Listing make_listing(const std::vector<Row> &rows) {
+  Listing listing;
+  for (const auto &row : rows) {
+    auto &e = listing[listing.add(row.name, row.is_directory)];
+    e.size = row.size;
+    e.mtime = row.mtime;
+    if (row.type)
+      e.type = atom_intern(row.type);
+  }
+  return listing;
+}
+
+std::vector<std::string> sorted_names(const Listing &listing, SortOrder sort) {
+  std::vector<std::uint32_t> order(listing.size());
+  std::iota(order.begin(), order.end(), 0);
+  sort_entries(listing, order, sort);
+  std::vector<std::string> names;
+  for (auto index : order)
+    names.emplace_back(listing.name(listing[index]));
+  return names;
+}
+
+using Names = std::vector<std::string>;
+
+void sorts_by_name() {
+  auto listing = make_listing({{"file10"},
+                               {"b", true},
+                               {"file2"},
+                               {"a"},
+                               {"a", true},
+                               {"file1"}});
+  CHECK(sorted_names(listing, {}) ==
+        (Names{"a", "b", "a", "file1", "file2", "file10"}));
+  // Directories stay first either way
+  CHECK(sorted_names(listing, {SortField::Name, true}) ==
+        (Names{"b", "a", "file10", "file2", "file1", "a"}));
+}
+
+void sorts_by_size() {
+  auto listing = make_listing({{"big", false, 300},
+                               {"dir", true, 999},
+                               {"small", false, 10},
+                               {"same-b", false, 50},
+                               {"same-a", false, 50}});
+  CHECK(sorted_names(listing, {SortField::Size, false}) ==
+        (Names{"dir", "small", "same-a", "same-b", "big"}));
+  CHECK(sorted_names(listing, {SortField::Size, true}) ==
+        (Names{"dir", "big", "same-b", "same-a", "small"}));
+}
+
+void sorts_by_modified() {
+  // Before the epoch is earlier still
+  auto listing = make_listing({{"now", false, 0, 1700000000},
+                               {"old", false, 0, -100},
+                               {"unknown", false, 0, 0}});
+  CHECK(sorted_names(listing, {SortField::Modified, false}) ==
+        (Names{"old", "unknown", "now"}));
+  CHECK(sorted_names(listing, {SortField::Modified, true}) ==
+        (Names{"now", "unknown", "old"}));
+}
+
+void sorts_by_type() {
+  auto listing = make_listing({{"photo", false, 0, 0, "Test image"},
+                               {"notes", false, 0, 0, "Test document"},
+                               {"draft", false, 0, 0, "Test document"},
+                               {"dir", true}});
+  CHECK(sorted_names(listing, {SortField::Type, false}) ==
+        (Names{"dir", "draft", "notes", "photo"}));
+  CHECK(sorted_names(listing, {SortField::Type, true}) ==
+        (Names{"dir", "photo", "notes", "draft"}));
+}
+
+// Types that show up after the ranks were made, from metadata filled in
+// later, sort after the ranked ones and among themselves by description
+void sorts_unranked_types_last() {
+  auto listing = make_listing({{"a", false, 0, 0, "Test rank b"},
+                               {"b", false, 0, 0, "Test rank b"},
+                               {"c", false, 0, 0, "Test rank b"}});
+  EntryOrder less(listing, {SortField::Type, false});
+  listing[1].type = atom_intern("Test rank z");
+  listing[2].type = atom_intern("Test rank a");
+  CHECK(less(0, 1) && !less(1, 0));
+  CHECK(less(0, 2) && !less(2, 0));
+  CHECK(less(2, 1) && !less(1, 2));
+}
+
+// Large enough to go through parallel_sort, with names that share a prefix
+void sorts_large_listings() {
+  std::mt19937 rng(12);
+  std::vector<std::string> names;
+  for (int i = 0; i < 50000; i++)
+    names.push_back("IMG_2024" + std::to_string(rng() % 100000) + ".jpg");
+  std::vector<Row> rows;
+  for (std::size_t i = 0; i < names.size(); i++)
+    rows.push_back({names[i], i % 97 == 0, rng() % 1000});
+  auto listing = make_listing(rows);
+
+  for (auto field : {SortField::Name, SortField::Size}) {
+    for (bool descending : {false, true}) {
+      SortOrder sort{field, descending};
+      std::vector<std::uint32_t> order(listing.size());
+      std::iota(order.begin(), order.end(), 0);
+      sort_entries(listing, order, sort);
+
+      EntryOrder less(listing, sort);
+      CHECK(std::is_sorted(order.begin(), order.end(), less));
+      auto seen = order;
+      std::sort(seen.begin(), seen.end());
+      CHECK(std::adjacent_find(seen.begin(), seen.end()) == seen.end());
+      CHECK(seen.size() == listing.size());
+    }
+  }
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  sorts_by_name();
+  sorts_by_size();
+  sorts_by_modified();
+  sorts_by_type();
+  sorts_unranked_types_last();
+  sorts_large_listings();
+  return test::result();
+}
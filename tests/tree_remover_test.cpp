@@ -0,0 +1,158 @@
+/*
+ * xafile - Xavier File Manager
+ * Copyright (C) 2026 Fitrian Musya
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "check.hpp"
+#include "utility/tree_remover.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace xafile {
+
+namespace {
+
+struct Removal {
+  std::atomic<std::uint64_t> found{0};
+  std::atomic<std::uint64_t> removed{0};
+  std::mutex mutex;
+  std::vector<std::pair<std::string, int>> errors;
+
+  void run(const std::vector<std::string> &paths, bool cancel = false) {
+    std::atomic<bool> cancelled{cancel};
+    TreeRemover(
+        cancelled, [this](std::uint64_t n) { found += n; },
+        [this](std::uint64_t n) { removed += n; },
+        [this](const std::string &path, int error) {
+          std::lock_guard lock(mutex);
+          errors.emplace_back(path, error);
+        })
+        .remove(paths);
+  }
+};
+
+bool exists(const std::string &path) {
+  struct stat st;
+  return lstat(path.c_str(), &st) == 0;
+}
+
+// Returns how many entries were made below `root`
+std::uint64_t build_tree(const std::string &root, int depth, int width) {
+  std::uint64_t count = 0;
+  for (int i = 0; i < width; i++) {
+    test::write_file(root + "/file" + std::to_string(i), "data");
+    count++;
+  }
+  if (depth == 0)
+    return count;
+  for (int i = 0; i < 3; i++) {
+    auto dir = root + "/dir" + std::to_string(i);
+    mkdir(dir.c_str(), 0755);
+    count += 1 + build_tree(dir, depth - 1, width);
+  }
+  return count;
+}
+
+void removes_trees() {
+  test::TempDir dir;
+  auto root = dir / "tree";
+  mkdir(root.c_str(), 0755);
+  auto count = 1 + build_tree(root, 4, 20);
+  // A deep chain, more levels than workers
+  std::string chain = root;
+  for (int i = 0; i < 100; i++) {
+    chain += "/d";
+    mkdir(chain.c_str(), 0755);
+    count++;
+  }
+
+  Removal removal;
+  removal.run({root});
+  CHECK(removal.errors.empty());
+  CHECK(!exists(root));
+  CHECK(removal.found == count);
+  CHECK(removal.removed == count);
+}
+
+void leaves_symlink_targets_alone() {
+  test::TempDir dir;
+  auto outside = dir / "outside";
+  mkdir(outside.c_str(), 0755);
+  test::write_file(outside + "/keep", "keep");
+  auto root = dir / "tree";
+  mkdir(root.c_str(), 0755);
+  symlink(outside.c_str(), (root + "/to-dir").c_str());
+  symlink((outside + "/keep").c_str(), (root + "/to-file").c_str());
+
+  Removal removal;
+  removal.run({root});
+  CHECK(removal.errors.empty());
+  CHECK(!exists(root));
+  CHECK(exists(outside + "/keep"));
+  CHECK(removal.removed == 3);
+}
+
+void removes_several_paths() {
+  test::TempDir dir;
+  test::write_file(dir / "file", "");
+  symlink("missing", (dir / "dangling").c_str());
+  mkdir((dir / "a").c_str(), 0755);
+  mkdir((dir / "b").c_str(), 0755);
+  auto count = 4 + build_tree(dir / "a", 1, 5) + build_tree(dir / "b", 2, 5);
+
+  Removal removal;
+  removal.run({dir / "file", dir / "dangling", dir / "a", dir / "missing",
+               dir / "b"});
+  CHECK(removal.errors.size() == 1 &&
+        removal.errors[0] == std::make_pair(dir / "missing", ENOENT));
+  CHECK(removal.found == count);
+  CHECK(removal.removed == count);
+  CHECK(!exists(dir / "file") && !exists(dir / "dangling"));
+  CHECK(!exists(dir / "a") && !exists(dir / "b"));
+}
+
+void stops_when_cancelled() {
+  test::TempDir dir;
+  auto root = dir / "tree";
+  mkdir(root.c_str(), 0755);
+  build_tree(root, 2, 5);
+
+  Removal removal;
+  removal.run({root}, true);
+  CHECK(exists(root));
+  CHECK(exists(root + "/dir0/dir0/file0"));
+  CHECK(removal.removed == 0);
+}
+
+} // namespace
+
+} // namespace xafile
+
+int main() {
+  using namespace xafile;
+  removes_trees();
+  leaves_symlink_targets_alone();
+  removes_several_paths();
+  stops_when_cancelled();
+  return test::result();
+}